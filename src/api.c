@@ -60,14 +60,27 @@ api_register_all ( const api_hook_t *hooks )
   }
 }
 
-int
-api_exec ( access_t *perm, const char *subsystem,
-           htsmsg_t *args, htsmsg_t **resp )
+/*
+ * The writer for the callbacks called from api_exec_stream()
+ */
+static __thread htsmsg_json_writer_t *api_stream_writer;
+
+htsmsg_json_writer_t *
+api_stream ( void )
+{
+  return api_stream_writer;
+}
+
+static int
+api_exec0 ( access_t *perm, const char *subsystem,
+            htsmsg_t *args, htsmsg_t **resp, htsmsg_json_writer_t *w )
 {
   api_hook_t h;
   api_link_t *ah, skel;
+  htsmsg_json_writer_t *w0;
   const char *op;
   uint32_t access;
+  int r;
 
   /* Args and response must be set */
   if (!args || !resp || !subsystem)
@@ -99,7 +112,25 @@ api_exec ( access_t *perm, const char *subsystem,
   // Note: this is not required (so no final validation)
 
   /* Execute */
-  return ah->hook->ah_callback(perm, ah->hook->ah_opaque, op, args, resp);
+  w0 = api_stream_writer;
+  api_stream_writer = w;
+  r = ah->hook->ah_callback(perm, ah->hook->ah_opaque, op, args, resp);
+  api_stream_writer = w0;
+  return r;
+}
+
+int
+api_exec ( access_t *perm, const char *subsystem,
+           htsmsg_t *args, htsmsg_t **resp )
+{
+  return api_exec0(perm, subsystem, args, resp, NULL);
+}
+
+int
+api_exec_stream ( access_t *perm, const char *subsystem,
+                  htsmsg_t *args, htsmsg_t **resp, htsmsg_json_writer_t *w )
+{
+  return api_exec0(perm, subsystem, args, resp, w);
 }
 
 static int
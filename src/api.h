@@ -21,6 +21,7 @@
 #define __TVH_API_H__
 
 #include "htsmsg.h"
+#include "htsmsg_json.h"
 #include "idnode.h"
 #include "redblack.h"
 #include "access.h"
@@ -55,6 +56,15 @@ void api_register_all ( const api_hook_t *hooks );
 int  api_exec ( access_t *perm, const char *subsystem,
                 htsmsg_t *args, htsmsg_t **resp );
 
+/*
+ * Execute with the streamed output, the callbacks which support it
+ * (large grids) write the reply to api_stream() and leave resp unset
+ */
+int  api_exec_stream ( access_t *perm, const char *subsystem,
+                       htsmsg_t *args, htsmsg_t **resp,
+                       htsmsg_json_writer_t *w );
+htsmsg_json_writer_t *api_stream ( void );
+
 /*
  * Initialise
  */
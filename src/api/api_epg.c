@@ -323,6 +323,49 @@ api_epg_decode_channel_num ( const char *s )
    return v;
 }
 
+/*
+ * Streamed output, the broadcasts are looked up again using the id
+ * after global_lock was released for the flush
+ */
+static void
+api_epg_grid_stream
+  ( epg_query_t *eq, uint32_t start, uint32_t end, const char *lang,
+    access_t *perm, htsmsg_json_writer_t *w )
+{
+  epg_broadcast_t *eb;
+  const char *blank = NULL;
+  uint32_t i, j, *ids = NULL;
+  htsmsg_t *e;
+
+  htsmsg_json_writer_map_start(w, NULL);
+  htsmsg_json_writer_add_s64(w, "totalCount", eq->entries);
+  htsmsg_json_writer_list_start(w, "entries");
+  for (i = start; i < end; i++) {
+    if (ids) {
+      if ((eb = epg_broadcast_find_by_id(ids[i - start])) == NULL)
+        continue;
+    } else {
+      eb = eq->result[i];
+    }
+    if (!(e = api_epg_entry(eb, lang, perm, &blank))) continue;
+    htsmsg_json_writer_add_msg(w, NULL, e);
+    htsmsg_destroy(e);
+    if (htsmsg_json_writer_full(w) && i + 1 < end) {
+      if (ids == NULL) {
+        ids = malloc((end - start) * sizeof(*ids));
+        for (j = i + 1; j < end; j++)
+          ids[j - start] = eq->result[j]->id;
+      }
+      tvh_mutex_unlock(&global_lock);
+      htsmsg_json_writer_flush(w);
+      tvh_mutex_lock(&global_lock);
+    }
+  }
+  htsmsg_json_writer_end(w);
+  htsmsg_json_writer_end(w);
+  free(ids);
+}
+
 static int
 api_epg_grid
   ( access_t *perm, void *opaque, const char *op, htsmsg_t *args, htsmsg_t **resp )
@@ -335,6 +378,7 @@ api_epg_grid
   int64_t duration_min, duration_max;
   htsmsg_field_t *f, *f2;
   htsmsg_t *l = NULL, *e, *filter;
+  htsmsg_json_writer_t *w = api_stream();
   const char* mode;
 
   memset(&eq, 0, sizeof(eq));
@@ -499,6 +543,13 @@ api_epg_grid
   /* Build response */
   start = MIN(eq.entries, start);
   end   = MIN(eq.entries, start + limit);
+  if (w) {
+    api_epg_grid_stream(&eq, start, end, lang, perm, w);
+    tvh_mutex_unlock(&global_lock);
+    epg_query_free(&eq);
+    free(lang);
+    return 0;
+  }
   l     = htsmsg_create_list();
   for (i = start; i < end; i++) {
     if (!(e = api_epg_entry(eq.result[i], lang, perm, &blank))) continue;
@@ -23,6 +23,9 @@
 #include "htsmsg.h"
 #include "api.h"
 
+/* Sort larger grids without global_lock */
+#define API_IDNODE_GRID_UNLOCK 1000
+
 htsmsg_t *
 api_idnode_flist_conf( htsmsg_t *args, const char *name )
 {
@@ -119,13 +122,16 @@ int
 api_idnode_grid
   ( access_t *perm, void *opaque, const char *op, htsmsg_t *args, htsmsg_t **resp )
 {
-  int i;
-  htsmsg_t *list, *e;
+  int i, lookup = 0;
+  htsmsg_t *list = NULL, *e;
+  htsmsg_json_writer_t *w = api_stream();
   htsmsg_t *flist = api_idnode_flist_conf(args, "list");
   api_idnode_grid_conf_t conf = { 0 };
   idnode_t *in;
   idnode_set_t ins = { 0 };
+  idnode_sort_keys_t *sk = NULL;
   api_idnode_grid_callback_t cb = opaque;
+  int64_t mono = getfastmonoclock();
 
   /* Grid configuration */
   api_idnode_grid_conf(perm, args, &conf);
@@ -134,32 +140,68 @@ api_idnode_grid
   tvh_mutex_lock(&global_lock);
   cb(perm, &ins, &conf, args);
 
-  /* Sort */
-  if (conf.sort.key)
-    idnode_set_sort(&ins, &conf.sort);
+  /* Sort (only the requested page), large sets without global_lock */
+  if ((conf.sort.key || w) && conf.limit != 0) {
+    sk = idnode_sort_keys_create(&ins, &conf.sort);
+    if (conf.sort.key && ins.is_count >= API_IDNODE_GRID_UNLOCK) {
+      tvh_mutex_unlock(&global_lock);
+      lookup = 1;
+    }
+    idnode_sort_keys_sort(sk, (size_t)conf.start + conf.limit);
+    if (lookup)
+      tvh_mutex_lock(&global_lock);
+  }
 
-  /* Paginate */
-  list  = htsmsg_create_list();
+  /* Paginate, the streamed output is flushed without global_lock */
+  if (w) {
+    htsmsg_json_writer_map_start(w, NULL);
+    htsmsg_json_writer_list_start(w, "entries");
+  } else {
+    list = htsmsg_create_list();
+  }
   for (i = conf.start; i < ins.is_count && conf.limit != 0; i++) {
-    in = ins.is_array[i];
-    if (idnode_perm(in, perm, NULL))
+    in = sk ? idnode_sort_keys_get(sk, i, lookup) : ins.is_array[i];
+    if (in == NULL || idnode_perm(in, perm, NULL))
       continue;
     e = htsmsg_create_map();
     htsmsg_add_uuid(e, "uuid", &in->in_uuid);
     idnode_read0(in, e, flist, 0, conf.sort.lang);
     idnode_perm_unset(in);
-    htsmsg_add_msg(list, NULL, e);
     if (conf.limit > 0) conf.limit--;
+    if (w == NULL) {
+      htsmsg_add_msg(list, NULL, e);
+      continue;
+    }
+    htsmsg_json_writer_add_msg(w, NULL, e);
+    htsmsg_destroy(e);
+    if (htsmsg_json_writer_full(w)) {
+      tvh_mutex_unlock(&global_lock);
+      lookup = 1;
+      htsmsg_json_writer_flush(w);
+      tvh_mutex_lock(&global_lock);
+    }
   }
 
   tvh_mutex_unlock(&global_lock);
 
+  mono = getfastmonoclock() - mono;
+  if (mono > ms2mono(100))
+    tvhdebug(LS_API, "grid %s: %zu entries, sort %s, %"PRId64" ms",
+             op ?: "", ins.is_count, conf.sort.key ?: "-", mono2ms(mono));
+
   /* Output */
-  *resp = htsmsg_create_map();
-  htsmsg_add_msg(*resp, "entries", list);
-  htsmsg_add_u32(*resp, "total",   ins.is_count);
+  if (w) {
+    htsmsg_json_writer_end(w);
+    htsmsg_json_writer_add_s64(w, "total", ins.is_count);
+    htsmsg_json_writer_end(w);
+  } else {
+    *resp = htsmsg_create_map();
+    htsmsg_add_msg(*resp, "entries", list);
+    htsmsg_add_u32(*resp, "total",   ins.is_count);
+  }
 
   /* Cleanup */
+  idnode_sort_keys_destroy(sk);
   free(ins.is_array);
   idnode_filter_clear(&conf.filter);
   htsmsg_destroy(flist);
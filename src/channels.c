@@ -35,6 +35,7 @@
 #include "bouquet.h"
 #include "intlconv.h"
 #include "memoryinfo.h"
+#include "hotchannel.h"
 
 typedef int (sortfcn_t)(const void *, const void *);
 
@@ -122,10 +123,17 @@ static void
 channel_class_notify_enabled ( void *obj, const char *lang )
 {
   channel_t *ch = (channel_t *)obj;
+  hotchannel_update(ch);
   if (!ch->ch_enabled)
     channel_remove_subscriber(ch, SM_CODE_CHN_NOT_ENABLED);
 }
 
+static void
+channel_class_notify_hot ( void *obj, const char *lang )
+{
+  hotchannel_update((channel_t *)obj);
+}
+
 static int
 channel_class_autoname_set ( void *obj, const void *p )
 {
@@ -542,6 +550,18 @@ const idclass_t channel_class = {
       .list     = channel_class_epg_running_list,
       .opts     = PO_EXPERT | PO_DOC_NLIST,
     },
+    {
+      .type     = PT_BOOL,
+      .id       = "hot",
+      .name     = N_("Hot channel"),
+      .desc     = N_("Keep the channel running on a spare tuner with "
+                     "a small keyframe cache, so new subscriptions "
+                     "start instantly. Any other subscription can "
+                     "take the tuner over."),
+      .off      = offsetof(channel_t, ch_hot),
+      .notify   = channel_class_notify_hot,
+      .opts     = PO_ADVANCED,
+    },
 #if ENABLE_TIMESHIFT
     {
       .type     = PT_BOOL,
@@ -1315,6 +1335,7 @@ channel_delete ( channel_t *ch, int delconf )
     idnode_list_unlink(ilm, delconf ? ch : NULL);
 
   /* Subscriptions */
+  hotchannel_remove(ch);
   while((s = LIST_FIRST(&ch->ch_subscriptions)) != NULL) {
     LIST_REMOVE(s, ths_channel_link);
     s->ths_channel = NULL;
@@ -62,6 +62,8 @@ typedef struct channel
   /* Service/subscriptions */
   idnode_list_head_t           ch_services;
   LIST_HEAD(, th_subscription) ch_subscriptions;
+  int                          ch_hot;
+  struct hotchannel           *ch_hotchannel;
 
   /* EPG fields */
   char                 *ch_epg_parent;
@@ -1692,7 +1692,8 @@ static int config_newcfg = 0;
 
 void
 config_boot
-  ( const char *path, gid_t gid, uid_t uid, const char *http_user_agent )
+  ( const char *path, gid_t gid, uid_t uid, const char *http_user_agent,
+    int settings_pack )
 {
   struct stat st;
   char buf[1024];
@@ -1719,6 +1720,7 @@ config_boot
   config.theme_ui = strdup("blue");
   config.chname_num = 1;
   config.iptv_tpool_count = 2;
+  config.http_client_threads = 2;
   config.date_mask = strdup("");
   config.label_formatting = 0;
   config.hdhomerun_ip = strdup("");
@@ -1770,6 +1772,9 @@ config_boot
   if (chown(config_lock, uid, gid))
     tvhwarn(LS_CONFIG, "unable to chown lock file %s UID:%d GID:%d", config_lock, uid, gid);
 
+  /* Packed store */
+  hts_settings_pack_init(settings_pack);
+
   /* Load global settings */
   config2 = hts_settings_load("config");
   if (!config2) {
@@ -2538,6 +2543,18 @@ const idclass_t config_class = {
       .off    = offsetof(config_t, iptv_tpool_count),
       .group  = 7,
     },
+    {
+      .type   = PT_INT,
+      .id     = "httpc_threads",
+      .name   = N_("HTTP client threads"),
+      .desc   = N_("Set the number of threads for the outgoing HTTP "
+                   "connections (HTTP IPTV, SAT>IP, downloads) to split "
+                   "load across more CPUs. Changes take effect after "
+                   "a restart."),
+      .off    = offsetof(config_t, http_client_threads),
+      .opts   = PO_EXPERT,
+      .group  = 7,
+    },
     {
       .type   = PT_INT,
       .id     = "dscp",
@@ -2576,6 +2593,31 @@ const idclass_t config_class = {
       .opts   = PO_EXPERT,
       .group  = 7,
     },
+    {
+      .type   = PT_BOOL,
+      .id     = "parser_shared",
+      .name   = N_("Shared stream parser"),
+      .desc   = N_("Parse the elementary streams only once per service "
+                   "and pass the parsed packets to all subscribers "
+                   "instead of running one parser per subscription. "
+                   "The change applies to new subscriptions."),
+      .off    = offsetof(config_t, parser_shared),
+      .opts   = PO_EXPERT,
+      .group  = 7,
+    },
+    {
+      .type   = PT_BOOL,
+      .id     = "parser_gop",
+      .name   = N_("Keyframe cache"),
+      .desc   = N_("Keep the parsed packets since the last video "
+                   "keyframe for each running service, so a new "
+                   "subscription to an already running service starts "
+                   "immediately from the cached keyframe. This implies "
+                   "the shared stream parser."),
+      .off    = offsetof(config_t, parser_gop),
+      .opts   = PO_EXPERT,
+      .group  = 7,
+    },
     {
       .type   = PT_STR,
       .id     = "muxconfpath",
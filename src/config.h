@@ -64,10 +64,13 @@ typedef struct config {
   uint32_t descrambler_buffer;
   int caclient_ui;
   int parser_backlog;
+  int parser_shared;
+  int parser_gop;
   int epg_compress;
   uint32_t epg_cut_window;
   uint32_t epg_update_window;
   int iptv_tpool_count;
+  int http_client_threads;
   char *date_mask;
   int label_formatting;
   uint32_t ticket_expires;
@@ -80,7 +83,8 @@ extern const idclass_t config_class;
 extern config_t config;
 
 void config_boot
-  ( const char *path, gid_t gid, uid_t uid, const char *http_user_agent );
+  ( const char *path, gid_t gid, uid_t uid, const char *http_user_agent,
+    int settings_pack );
 void config_init( int backup );
 void config_done( void );
 
@@ -194,7 +194,10 @@ typedef struct dvr_entry {
    */
 
   LIST_ENTRY(dvr_entry) de_global_link;
-  
+  LIST_ENTRY(dvr_entry) de_title_link;
+  uint32_t de_title_hash;
+  int de_title_indexed;
+
   channel_t *de_channel;
   LIST_ENTRY(dvr_entry) de_channel_link;
 
@@ -283,6 +286,12 @@ typedef struct dvr_entry {
    * Last error, see SM_CODE_ defines
    */
   uint32_t de_last_error;
+
+  /**
+   * Write-behind statistics (only to be modified by the recording thread)
+   */
+  uint32_t de_write_latency;
+  uint32_t de_write_queue;
   
 
   /**
@@ -705,7 +714,7 @@ char * dvr_autorec_entry_class_weekdays_rend(uint32_t weekdays, const char *lang
 const char *dvr_entry_get_image(const dvr_entry_t *o);
 const char *dvr_entry_get_fanart_image(const dvr_entry_t *o);
 
-void dvr_autorec_check_event(epg_broadcast_t *e);
+void dvr_autorec_check_event(epg_broadcast_t *e, epg_changes_t changes);
 
 void autorec_destroy_by_config(dvr_config_t *cfg, int delconf);
 
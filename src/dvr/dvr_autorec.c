@@ -1511,18 +1511,65 @@ dvr_autorec_async_reschedule(void)
 }
 
 /**
- *
+ * Return the EPG fields which may change the result of dvr_autorec_cmp()
+ * (or dvr_entry_create_by_autorec()) for this rule.
+ */
+static epg_changes_t
+dvr_autorec_epg_changes(dvr_autorec_entry_t *dae)
+{
+  epg_changes_t r;
+
+  /* time window, weekdays and duration use start/stop */
+  r = EPG_CHANGED_CREATE | EPG_CHANGED_TIME | EPG_CHANGED_EPISODE;
+  if (dae->dae_serieslink_uri)
+    r |= EPG_CHANGED_SERIESLINK;
+  if (dae->dae_btype != DVR_AUTOREC_BTYPE_ALL)
+    r |= EPG_CHANGED_IS_NEW | EPG_CHANGED_IS_REPEAT;
+  if (dae->dae_content_type)
+    r |= EPG_CHANGED_GENRE;
+  if ((dae->dae_cat1 && *dae->dae_cat1) ||
+      (dae->dae_cat2 && *dae->dae_cat2) ||
+      (dae->dae_cat3 && *dae->dae_cat3))
+    r |= EPG_CHANGED_CATEGORY;
+  if (dae->dae_minyear > 0 || dae->dae_maxyear > 0)
+    r |= EPG_CHANGED_COPYRIGHT_YEAR;
+  if (dae->dae_minseason > 0 || dae->dae_maxseason > 0)
+    r |= EPG_CHANGED_EPSER_NUM;
+  if (dae->dae_star_rating)
+    r |= EPG_CHANGED_STAR_RATING;
+  if ((dae->dae_serieslink_uri == NULL || dae->dae_serieslink_uri[0] == '\0') &&
+      dae->dae_title != NULL && dae->dae_title[0] != '\0') {
+    r |= EPG_CHANGED_TITLE;
+    if (dae->dae_fulltext)
+      r |= EPG_CHANGED_SUBTITLE | EPG_CHANGED_SUMMARY |
+           EPG_CHANGED_DESCRIPTION | EPG_CHANGED_CREDITS |
+           EPG_CHANGED_KEYWORD;
+  }
+  return r;
+}
+
+/**
+ * Re-evaluate the rules for an updated broadcast. Only the rules which
+ * depend on the changed fields are checked (zero means unknown changes).
  */
 void
-dvr_autorec_check_event(epg_broadcast_t *e)
+dvr_autorec_check_event(epg_broadcast_t *e, epg_changes_t changes)
 {
   dvr_autorec_entry_t *dae;
 
   if (e->channel && !e->channel->ch_enabled)
     return;
-  TAILQ_FOREACH(dae, &autorec_entries, dae_link)
+  TAILQ_FOREACH(dae, &autorec_entries, dae_link) {
+    if (!dae->dae_enabled)
+      continue;
+    /* a rule bound to a channel never matches other channels */
+    if (dae->dae_channel && dae->dae_channel != e->channel)
+      continue;
+    if (changes && (changes & dvr_autorec_epg_changes(dae)) == 0)
+      continue;
     if(dvr_autorec_cmp(dae, e))
       dvr_entry_create_by_autorec(1, e, dae);
+  }
   // Note: no longer updating event here as it will be done from EPG
   //       anyway
 }
@@ -1530,28 +1577,47 @@ dvr_autorec_check_event(epg_broadcast_t *e)
 /**
  *
  */
+static void
+dvr_autorec_changed_channel
+  (dvr_autorec_entry_t *dae, channel_t *ch, epg_broadcast_t **disabled)
+{
+  epg_broadcast_t *e, **p;
+  int enabled;
+
+  if (!ch->ch_enabled) return;
+  RB_FOREACH(e, &ch->ch_epg_schedule, sched_link) {
+    if(dvr_autorec_cmp(dae, e)) {
+      enabled = 1;
+      if (disabled) {
+        for (p = disabled; *p && *p != e; p++);
+        enabled = *p == NULL;
+      }
+      dvr_entry_create_by_autorec(enabled, e, dae);
+    }
+  }
+}
+
 void
 dvr_autorec_changed(dvr_autorec_entry_t *dae, int purge)
 {
   channel_t *ch;
-  epg_broadcast_t *e, **disabled = NULL, **p;
-  int enabled;
+  idnode_list_mapping_t *ilm;
+  epg_broadcast_t **disabled = NULL;
 
   if (purge)
     disabled = dvr_autorec_purge_spawns(dae, 1, 1);
 
-  CHANNEL_FOREACH(ch) {
-    if (!ch->ch_enabled) continue;
-    RB_FOREACH(e, &ch->ch_epg_schedule, sched_link) {
-      if(dvr_autorec_cmp(dae, e)) {
-        enabled = 1;
-        if (disabled) {
-          for (p = disabled; *p && *p != e; p++);
-          enabled = *p == NULL;
-        }
-        dvr_entry_create_by_autorec(enabled, e, dae);
-      }
-    }
+  /* only scan the schedules the rule can match */
+  if (!dae->dae_enabled || dae->dae_weekdays == 0) {
+    /* nothing */
+  } else if (dae->dae_channel) {
+    dvr_autorec_changed_channel(dae, dae->dae_channel, disabled);
+  } else if (dae->dae_channel_tag) {
+    LIST_FOREACH(ilm, &dae->dae_channel_tag->ct_ctms, ilm_in1_link)
+      dvr_autorec_changed_channel(dae, (channel_t *)ilm->ilm_in2, disabled);
+  } else {
+    CHANNEL_FOREACH(ch)
+      dvr_autorec_changed_channel(dae, ch, disabled);
   }
 
   free(disabled);
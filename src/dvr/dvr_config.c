@@ -1187,6 +1187,20 @@ const idclass_t dvr_config_class = {
       .opts     = PO_EXPERT | PO_DOC_NLIST,
       .group    = 2,
     },
+    {
+      .type     = PT_INT,
+      .id       = "write-buffer",
+      .name     = N_("Write-behind buffer (MB)"),
+      .desc     = N_("Size of the per-recording write buffer. The data "
+                     "are written to the disk in large blocks by "
+                     "the background threads and the cache scheme is "
+                     "applied once per written block. "
+                     "Zero means direct writes."),
+      .off      = offsetof(dvr_config_t, dvr_muxcnf.m_write_buffer),
+      .intextra = INTEXTRA_RANGE(0, 64, 1),
+      .opts     = PO_EXPERT,
+      .group    = 2,
+    },
     {
       .type     = PT_BOOL,
       .id       = "day-dir",
@@ -32,7 +32,10 @@
 #include "compat.h"
 #include "string_list.h"
 
+#define DVR_TITLE_HASH_SIZE 1024
+
 struct dvr_entry_list dvrentries;
+static struct dvr_entry_list dvrentries_title[DVR_TITLE_HASH_SIZE];
 static int dvr_in_init;
 
 #if ENABLE_DBUS_1
@@ -58,6 +61,55 @@ static void dvr_entry_watched_timer_disarm(dvr_entry_t* de);
 
 static dvr_entry_t *_dvr_duplicate_event(dvr_entry_t *de);
 
+/*
+ * Title index (used by the duplicate detection)
+ *
+ * lang_str_compare() resolves a missing language to the first available
+ * string, so two equal titles always contain the same set of strings.
+ * The smallest string hash is therefore a stable key for equal titles.
+ */
+static uint32_t
+dvr_entry_title_hash(const lang_str_t *ls)
+{
+  lang_str_ele_t *e;
+  uint32_t h, r = 0;
+  int first = 1;
+
+  if (ls == NULL)
+    return 0;
+  RB_FOREACH(e, ls, link) {
+    h = tvh_strhash(e->str, UINT_MAX);
+    if (first || h < r)
+      r = h;
+    first = 0;
+  }
+  return r % DVR_TITLE_HASH_SIZE;
+}
+
+static void
+dvr_entry_title_index(dvr_entry_t *de)
+{
+  uint32_t h = dvr_entry_title_hash(de->de_title);
+
+  if (de->de_title_indexed) {
+    if (de->de_title_hash == h)
+      return;
+    LIST_REMOVE(de, de_title_link);
+  }
+  de->de_title_hash = h;
+  de->de_title_indexed = 1;
+  LIST_INSERT_HEAD(&dvrentries_title[h], de, de_title_link);
+}
+
+static void
+dvr_entry_title_unindex(dvr_entry_t *de)
+{
+  if (de->de_title_indexed) {
+    LIST_REMOVE(de, de_title_link);
+    de->de_title_indexed = 0;
+  }
+}
+
 /*
  *
  */
@@ -1109,6 +1161,7 @@ dvr_entry_create(const char *uuid, htsmsg_t *conf, int clone)
   de->de_refcnt = 1;
 
   LIST_INSERT_HEAD(&dvrentries, de, de_global_link);
+  dvr_entry_title_index(de);
 
   /* We do early duplicate checking. Otherwise we have the scenario
    * where we have a dvr entry already on disk and an autorec creates
@@ -1780,7 +1833,8 @@ static dvr_entry_t *_dvr_duplicate_event(dvr_entry_t *de)
   assert(match);
 
   if (record < DVR_AUTOREC_LRECORD_DIFFERENT_EPISODE_NUMBER || record == DVR_AUTOREC_RECORD_UNIQUE) {
-    LIST_FOREACH(de2, &dvrentries, de_global_link) {
+    /* only entries with the same title can match, see dvr_entry_title_hash() */
+    LIST_FOREACH(de2, &dvrentries_title[dvr_entry_title_hash(de->de_title)], de_title_link) {
       if (de == de2)
         continue;
 
@@ -2170,6 +2224,7 @@ dvr_entry_destroy(dvr_entry_t *de, int delconf)
   if (de->de_channel)
     LIST_REMOVE(de, de_channel_link);
   LIST_REMOVE(de, de_global_link);
+  dvr_entry_title_unindex(de);
   de->de_channel = NULL;
 
   if (de->de_parent)
@@ -2594,6 +2649,8 @@ static dvr_entry_t *_dvr_entry_update
 
   /* Save changes */
 dosave:
+  if (save & DVR_UPDATED_TITLE)
+    dvr_entry_title_index(de);
   if (save) {
     dvr_entry_changed(de);
     if (tvhlog_limit(&de->de_update_limit, 60)) {
@@ -3045,6 +3102,8 @@ dvr_entry_class_changed(idnode_t *self)
   dvr_entry_t *de = (dvr_entry_t *)self;
   if (de->de_in_unsubscribe)
     return;
+  if (de->de_title_indexed)
+    dvr_entry_title_index(de);
   if (dvr_entry_is_valid(de))
     dvr_entry_set_timer(de);
   htsp_dvr_entry_update(de);
@@ -3630,6 +3689,8 @@ dvr_entry_class_disp_title_set(void *o, const void *v)
     s = lang_str_get(de->de_title, lang);
   if (strcmp(s, v)) {
     lang_str_set(&de->de_title, v, lang);
+    if (de->de_title_indexed)
+      dvr_entry_title_index(de);
     return 1;
   }
   return 0;
@@ -4402,6 +4463,24 @@ const idclass_t dvr_entry_class = {
       .off      = offsetof(dvr_entry_t, de_data_errors),
       .opts     = PO_RDONLY | PO_ADVANCED,
     },
+    {
+      .type     = PT_U32,
+      .id       = "write_latency",
+      .name     = N_("Write latency (ms)"),
+      .desc     = N_("Duration of the last block write (including "
+                     "the cache scheme) of the write-behind buffer."),
+      .off      = offsetof(dvr_entry_t, de_write_latency),
+      .opts     = PO_RDONLY | PO_EXPERT,
+    },
+    {
+      .type     = PT_U32,
+      .id       = "write_queue",
+      .name     = N_("Write queue depth"),
+      .desc     = N_("Number of blocks waiting in the write-behind "
+                     "buffer."),
+      .off      = offsetof(dvr_entry_t, de_write_queue),
+      .opts     = PO_RDONLY | PO_EXPERT,
+    },
     {
       .type     = PT_U16,
       .id       = "dvb_eid",
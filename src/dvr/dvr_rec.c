@@ -1242,7 +1242,16 @@ dvr_rec_fatal_error(dvr_entry_t *de, const char *fmt, ...)
 static void
 dvr_notify(dvr_entry_t *de)
 {
+  muxer_t *muxer;
+  uint32_t depth;
+  int64_t latency;
+
   if (de->de_last_notify + sec2mono(5) < mclk()) {
+    if (de->de_chain && (muxer = de->de_chain->prch_muxer) && muxer->m_wbuf) {
+      muxer_wbuf_stats(muxer->m_wbuf, &depth, &latency);
+      de->de_write_queue = depth;
+      de->de_write_latency = latency / 1000;
+    }
     idnode_notify_changed(&de->de_id);
     de->de_last_notify = mclk();
     htsp_dvr_entry_update_stats(de);
@@ -1627,7 +1636,7 @@ dvr_thread(void *aux)
   dvr_entry_t *de = aux;
   profile_chain_t *prch = de->de_chain;
   streaming_queue_t *sq = &prch->prch_sq;
-  struct streaming_message_queue backlog;
+  struct streaming_message_queue backlog, pending;
   streaming_message_t *sm, *sm2;
   th_pkt_t *pkt, *pkt2, *pkt3;
   streaming_start_t *ss = NULL;
@@ -1662,15 +1671,25 @@ dvr_thread(void *aux)
   dvr_thread_global_unlock(de);
 
   TAILQ_INIT(&backlog);
+  TAILQ_INIT(&pending);
 
   tvh_mutex_lock(&sq->sq_mutex);
+  streaming_queue_wakeup(sq, 256*1024, ms2mono(200));
+  tvh_mutex_unlock(&sq->sq_mutex);
+
   while(run) {
-    sm = TAILQ_FIRST(&sq->sq_queue);
+    sm = TAILQ_FIRST(&pending);
     if(sm == NULL) {
-      tvh_cond_wait(&sq->sq_cond, &sq->sq_mutex);
+      tvh_mutex_lock(&sq->sq_mutex);
+      /* the data below the wakeup size is not signalled when the input stalls */
+      while (TAILQ_EMPTY(&sq->sq_queue))
+        tvh_cond_timedwait(&sq->sq_cond, &sq->sq_mutex,
+                           mclk() + sq->sq_wake_delay);
+      streaming_queue_take(sq, &pending);
+      tvh_mutex_unlock(&sq->sq_mutex);
       continue;
     }
-    streaming_queue_remove(sq, sm);
+    TAILQ_REMOVE(&pending, sm, sm_link);
 
     old_epg_running = epg_running;
     if (running_disabled) {
@@ -1699,8 +1718,6 @@ dvr_thread(void *aux)
       tvhtrace(LS_DVR, "%s - running flag changed from %d to %d",
                idnode_uuid_as_str(&de->de_id, ubuf), old_epg_running, epg_running);
 
-    tvh_mutex_unlock(&sq->sq_mutex);
-
     switch(sm->sm_type) {
 
     case SMT_PACKET:
@@ -1915,10 +1932,9 @@ fin:
     }
 
     streaming_msg_free(sm);
-    tvh_mutex_lock(&sq->sq_mutex);
   }
-  tvh_mutex_unlock(&sq->sq_mutex);
 
+  streaming_queue_clear(&pending);
   streaming_queue_clear(&backlog);
 
   if (ss)
@@ -102,6 +102,7 @@ void epg_updated ( void )
     LIST_REMOVE(eo, up_link);
     eo->_updated = 0;
     eo->_created = 1;
+    eo->_changes = 0;
   }
 }
 
@@ -158,6 +159,12 @@ static inline void _epg_object_set_updated ( void *o )
     _epg_object_set_updated0(o);
 }
 
+static inline void _epg_object_set_changed ( void *o, epg_changes_t cflag )
+{
+  ((epg_object_t *)o)->_changes |= cflag;
+  _epg_object_set_updated(o);
+}
+
 static int _epg_object_can_remove ( void *_old, void *_new )
 {
   epggrab_module_t *ograb, *ngrab;
@@ -188,7 +195,7 @@ static void _epg_object_create ( void *o )
   if (!eo->id) eo->id = ++_epg_object_idx;
   tvhtrace(LS_EPG, "eo [%p, %u, %d] created",
            eo, eo->id, eo->type);
-  _epg_object_set_updated(eo);
+  _epg_object_set_changed(eo, EPG_CHANGED_CREATE);
   LIST_INSERT_HEAD(&epg_object_unref, eo, un_link);
   while (1) {
     if (!RB_INSERT_SORTED(epg_id_tree(eo), eo, id_link, _id_cmp))
@@ -259,7 +266,7 @@ static int _epg_object_set_str
   if (!*old || !newstr || strcmp(*old, newstr)) {
     free(*old);
     *old = newstr ? strdup(newstr) : NULL;
-    _epg_object_set_updated(eo);
+    _epg_object_set_changed(eo, cflag);
     save = 1;
   }
   return save;
@@ -280,13 +287,13 @@ static int FNNAME \
   if (!new) { \
     DESTROY(*old); \
     *old = NULL; \
-    _epg_object_set_updated(o); \
+    _epg_object_set_changed(o, cflag); \
     return 1; \
   } \
   if (COMPARE(*old, new)) { \
     DESTROY(*old); \
     *old = COPY(new); \
-    _epg_object_set_updated(o); \
+    _epg_object_set_changed(o, cflag); \
     return 1; \
   } \
   return 0; \
@@ -310,7 +317,7 @@ static int FNNAME \
   if (changed) *changed |= cflag; \
   if ((save = (*old != nval)) != 0) { \
     *old = nval; \
-    _epg_object_set_updated(o); \
+    _epg_object_set_changed(o, cflag); \
   } \
   return save; \
 }
@@ -614,7 +621,7 @@ static epg_broadcast_t *_epg_channel_add_broadcast
       /* Extend in time */
       } else {
         ret->stop = (*bcast)->stop;
-        _epg_object_set_updated(ret);
+        _epg_object_set_changed(ret, EPG_CHANGED_TIME);
         tvhtrace(LS_EPG, "updated event %u (%s) on %s @ %s to %s (grabber %s)",
                  ret->id, epg_broadcast_get_title(ret, NULL),
                  channel_get_name(ch, channel_blank_name),
@@ -645,7 +652,7 @@ static epg_broadcast_t *_epg_channel_add_broadcast
                gmtime2local(ebc->start, tm1, sizeof(tm1)),
                gmtime2local(ebc->stop, tm2, sizeof(tm2)));
       ebc->stop = ret->start;
-      _epg_object_set_updated(ebc);
+      _epg_object_set_changed(ebc, EPG_CHANGED_TIME);
       continue;
     }
     tvhtrace(LS_EPG, "remove overlap (b) event %u (%s) on %s @ %s to %s",
@@ -673,7 +680,8 @@ static epg_broadcast_t *_epg_channel_add_broadcast
                gmtime2local(ebc->start, tm1, sizeof(tm1)),
                gmtime2local(ebc->stop, tm2, sizeof(tm2)));
       ret->stop = ebc->start;
-      _epg_object_set_updated(ebc);
+      _epg_object_set_changed(ret, EPG_CHANGED_TIME);
+      _epg_object_set_changed(ebc, EPG_CHANGED_TIME);
       continue;
     }
     tvhtrace(LS_EPG, "remove overlap (a) event %u (%s) on %s @ %s to %s",
@@ -913,7 +921,7 @@ static void _epg_broadcast_updated ( void *eo )
     dvr_event_updated(eo);
     if (ebc->update_running != EPG_RUNNING_NOTSET)
       _epg_broadcast_update_running(ebc);
-    dvr_autorec_check_event(eo);
+    dvr_autorec_check_event(eo, ebc->_changes);
     channel_event_updated(eo);
   }
 }
@@ -1001,19 +1009,26 @@ int epg_broadcast_change_finish
   if (!(changes & EPG_CHANGED_DESCRIPTION))
     save |= epg_broadcast_set_description(broadcast, NULL, NULL);
   if (!(changes & EPG_CHANGED_EPSER_NUM))
-    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.s_num, 0, NULL, 0);
+    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.s_num, 0,
+                                NULL, EPG_CHANGED_EPSER_NUM);
   if (!(changes & EPG_CHANGED_EPSER_CNT))
-    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.s_cnt, 0, NULL, 0);
+    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.s_cnt, 0,
+                                NULL, EPG_CHANGED_EPSER_CNT);
   if (!(changes & EPG_CHANGED_EPNUM_NUM))
-    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.e_num, 0, NULL, 0);
+    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.e_num, 0,
+                                NULL, EPG_CHANGED_EPNUM_NUM);
   if (!(changes & EPG_CHANGED_EPNUM_CNT))
-    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.e_cnt, 0, NULL, 0);
+    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.e_cnt, 0,
+                                NULL, EPG_CHANGED_EPNUM_CNT);
   if (!(changes & EPG_CHANGED_EPPAR_NUM))
-    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.p_num, 0, NULL, 0);
+    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.p_num, 0,
+                                NULL, EPG_CHANGED_EPPAR_NUM);
   if (!(changes & EPG_CHANGED_EPPAR_CNT))
-    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.p_cnt, 0, NULL, 0);
+    save |= _epg_object_set_u16(broadcast, &broadcast->epnum.p_cnt, 0,
+                                NULL, EPG_CHANGED_EPPAR_CNT);
   if (!(changes & EPG_CHANGED_EPTEXT))
-    save |= _epg_object_set_str(broadcast, &broadcast->epnum.text, NULL, NULL, 0);
+    save |= _epg_object_set_str(broadcast, &broadcast->epnum.text, NULL,
+                                NULL, EPG_CHANGED_EPTEXT);
   if (!(changes & EPG_CHANGED_FIRST_AIRED))
     save |= epg_broadcast_set_first_aired(broadcast, 0, NULL);
   if (!(changes & EPG_CHANGED_COPYRIGHT_YEAR))
@@ -1094,7 +1109,7 @@ int epg_broadcast_set_running
   int save = 0;
   if (running != broadcast->running) {
     broadcast->update_running = running;
-    _epg_object_set_updated(broadcast);
+    _epg_object_set_changed(broadcast, EPG_CHANGED_RUNNING);
     save = 1;
   }
   return save;
@@ -1122,7 +1137,10 @@ int epg_broadcast_set_serieslink_uri
 {
   if (!ebc) return 0;
   if (changed) *changed |= EPG_CHANGED_SERIESLINK;
-  return _epg_broadcast_set_set(ebc, uri, &epg_serieslinks, &ebc->serieslink);
+  if (!_epg_broadcast_set_set(ebc, uri, &epg_serieslinks, &ebc->serieslink))
+    return 0;
+  ebc->_changes |= EPG_CHANGED_SERIESLINK;
+  return 1;
 }
 
 int epg_broadcast_set_episodelink_uri
@@ -1130,7 +1148,10 @@ int epg_broadcast_set_episodelink_uri
 {
   if (!ebc) return 0;
   if (changed) *changed |= EPG_CHANGED_EPISODE;
-  return _epg_broadcast_set_set(ebc, uri, &epg_episodelinks, &ebc->episodelink);
+  if (!_epg_broadcast_set_set(ebc, uri, &epg_episodelinks, &ebc->episodelink))
+    return 0;
+  ebc->_changes |= EPG_CHANGED_EPISODE;
+  return 1;
 }
 
 int epg_broadcast_set_dvb_eid
@@ -1422,6 +1443,8 @@ int epg_broadcast_set_genre
       save |= epg_genre_list_add(&b->genre, g1);
   }
 
+  if (save)
+    b->_changes |= EPG_CHANGED_GENRE;
   return save;
 }
 
@@ -1448,7 +1471,7 @@ int epg_broadcast_set_first_aired
   if (changed) *changed |= EPG_CHANGED_FIRST_AIRED;
   if (b->first_aired != aired) {
     b->first_aired = aired;
-    _epg_object_set_updated(b);
+    _epg_object_set_changed(b, EPG_CHANGED_FIRST_AIRED);
     return 1;
   }
   return 0;
@@ -149,6 +149,8 @@ typedef uint64_t epg_changes_t;
 #define EPG_CHANGED_AGE_RATING     (1ULL<<31)
 #define EPG_CHANGED_FIRST_AIRED    (1ULL<<32)
 #define EPG_CHANGED_COPYRIGHT_YEAR (1ULL<<33)
+#define EPG_CHANGED_TIME           (1ULL<<34)
+#define EPG_CHANGED_RUNNING        (1ULL<<35)
 
 typedef struct epg_object_ops {
   void (*getref)  ( void *o );        ///< Get a reference
@@ -170,6 +172,7 @@ struct epg_object
 
   uint8_t                 _updated;   ///< Flag to indicate updated
   uint8_t                 _created;   ///< Flag to indicate creation
+  epg_changes_t           _changes;   ///< Fields changed since last update
   int                     refcount;   ///< Reference counting
   // Note: could use LIST_ENTRY field to determine this!
 
@@ -35,8 +35,12 @@
 #include "config.h"
 #include "memoryinfo.h"
 
-#define EPG_DB_VERSION 3
+#define EPG_DB_VERSION 4
 #define EPG_DB_ALLOC_STEP (1024*1024)
+#define EPG_DB_CHUNK_RECORDS 4096
+#define EPG_DB_MAX_THREADS 8
+#define EPG_DB_V4_MAGIC "\xff\xff" "EPGDB4"
+#define EPG_DB_V4_GZIP 0x01
 
 extern epg_object_tree_t epg_episodes;
 
@@ -115,54 +119,28 @@ static void epg_mmap_sigbus (int sig, siginfo_t *siginfo, void *ptr)
 }
 
 /*
- * Load data
+ * Load v3 data (single gzip or plain image)
  */
-void epg_init ( void )
+static void
+_epgdb_v3_load ( int fd, struct stat *st, int ver,
+                 char **sect, epggrab_stats_t *stats )
 {
-  int fd = -1, r;
-  struct stat st;
+  int r;
   size_t remain;
   uint8_t *mem, *rp, *zlib_mem = NULL;
-  epggrab_stats_t stats;
-  int ver = EPG_DB_VERSION;
   struct sigaction act, oldact;
-  char *sect = NULL;
-
-  memoryinfo_register(&epg_memoryinfo_broadcasts);
-
-  /* Find the right file (and version) */
-  while (fd < 0 && ver > 0) {
-    fd = hts_settings_open_file(0, "epgdb.v%d", ver);
-    if (fd > 0) break;
-    ver--;
-  }
-  if ( fd < 0 )
-    fd = hts_settings_open_file(0, "epgdb");
-  if ( fd < 0 ) {
-    tvhdebug(LS_EPGDB, "database does not exist");
-    return;
-  }
 
   memset (&act, 0, sizeof(act));
   act.sa_sigaction = epg_mmap_sigbus;
   act.sa_flags = SA_SIGINFO;
   if (sigaction(SIGBUS, &act, &oldact)) {
     tvherror(LS_EPGDB, "failed to install SIGBUS handler");
-    close(fd);
     return;
   }
-  
+
   /* Map file to memory */
-  if ( fstat(fd, &st) != 0 ) {
-    tvherror(LS_EPGDB, "failed to detect database size");
-    goto end;
-  }
-  if ( !st.st_size ) {
-    tvhdebug(LS_EPGDB, "database is empty");
-    goto end;
-  }
-  remain   = st.st_size;
-  rp = mem = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  remain   = st->st_size;
+  rp = mem = mmap(NULL, st->st_size, PROT_READ, MAP_SHARED, fd, 0);
   if ( mem == MAP_FAILED ) {
     tvherror(LS_EPGDB, "failed to mmap database");
     goto end;
@@ -171,7 +149,7 @@ void epg_init ( void )
   if (sigsetjmp(epg_mmap_env, 1)) {
     tvherror(LS_EPGDB, "failed to read from mapped file");
     if (mem)
-      munmap(mem, st.st_size);
+      munmap(mem, st->st_size);
     goto end;
   }
 
@@ -189,7 +167,6 @@ void epg_init ( void )
   tvhinfo(LS_EPGDB, "parsing %zd bytes", remain);
 
   /* Process */
-  memset(&stats, 0, sizeof(stats));
   while ( remain > 4 ) {
 
     /* Get message length */
@@ -213,7 +190,7 @@ void epg_init ( void )
     /* Process */
     switch (ver) {
       case 3:
-        _epgdb_v3_process(&sect, m, &stats);
+        _epgdb_v3_process(sect, m, stats);
         break;
       default:
         break;
@@ -223,6 +200,323 @@ void epg_init ( void )
     htsmsg_destroy(m);
   }
 
+  /* Close file */
+  munmap(mem, st->st_size);
+  free(zlib_mem);
+end:
+  sigaction(SIGBUS, &oldact, NULL);
+}
+
+/*
+ * Load v4 data
+ *
+ * The v4 image is split into independent chunks (each optionally gzipped)
+ * described by an index at the start of the file. The chunks are read,
+ * inflated and decoded by a small pool of worker threads while the
+ * calling thread (holding global_lock) creates the broadcasts strictly
+ * in the file order. Each record uses the v3 record layout.
+ */
+typedef struct epgdb_v4_job {
+  off_t      offset;
+  uint32_t   stored;
+  uint32_t   size;
+  uint32_t   records;
+  uint8_t   *data;
+  htsmsg_t **msgs;
+  uint32_t   nmsgs;
+  int        state;
+} epgdb_v4_job_t;
+
+typedef struct epgdb_v4_loader {
+  tvh_mutex_t      lock;
+  tvh_cond_t       cond;
+  int              fd;
+  int              compressed;
+  epgdb_v4_job_t  *jobs;
+  uint32_t         njobs;
+  uint32_t         next;
+  uint32_t         done;
+  uint32_t         window;
+  int              abort;
+} epgdb_v4_loader_t;
+
+static inline uint32_t _epgdb_get_u32 ( const uint8_t *p )
+{
+  return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static inline void _epgdb_put_u32 ( uint8_t *p, uint32_t u32 )
+{
+  p[0] = u32 >> 24;
+  p[1] = u32 >> 16;
+  p[2] = u32 >> 8;
+  p[3] = u32;
+}
+
+static int
+_epgdb_v4_read ( int fd, uint8_t *buf, size_t len, off_t off )
+{
+  ssize_t r;
+
+  while (len > 0) {
+    r = pread(fd, buf, len, off);
+    if (r < 0) {
+      if (ERRNO_AGAIN(errno))
+        continue;
+      return -1;
+    }
+    if (r == 0)
+      return -1;
+    buf += r;
+    off += r;
+    len -= r;
+  }
+  return 0;
+}
+
+static int
+_epgdb_v4_decode ( epgdb_v4_loader_t *l, epgdb_v4_job_t *j )
+{
+  uint8_t *data, *rp;
+  size_t remain, msglen;
+  htsmsg_t *m;
+
+  if ((data = malloc(j->stored)) == NULL)
+    return -1;
+  if (_epgdb_v4_read(l->fd, data, j->stored, j->offset)) {
+    free(data);
+    return -1;
+  }
+  if (l->compressed) {
+#if ENABLE_ZLIB
+    rp = tvh_gzip_inflate(data, j->stored, j->size);
+#else
+    rp = NULL;
+#endif
+    free(data);
+    if ((data = rp) == NULL)
+      return -1;
+  } else if (j->stored != j->size) {
+    free(data);
+    return -1;
+  }
+  j->data = data;
+  j->msgs = malloc(j->records * sizeof(htsmsg_t *));
+  if (j->msgs == NULL)
+    return -1;
+  rp = data;
+  remain = j->size;
+  while (remain > 4 && j->nmsgs < j->records) {
+    msglen = remain;
+    if (htsmsg_binary2_deserialize(&m, rp, &msglen, NULL))
+      return -1;
+    rp     += msglen;
+    remain -= msglen;
+    if (m)
+      j->msgs[j->nmsgs++] = m;
+  }
+  return 0;
+}
+
+static void
+_epgdb_v4_job_free ( epgdb_v4_job_t *j )
+{
+  uint32_t i;
+
+  for (i = 0; i < j->nmsgs; i++)
+    htsmsg_destroy(j->msgs[i]);
+  free(j->msgs);
+  free(j->data);
+  j->msgs = NULL;
+  j->data = NULL;
+  j->nmsgs = 0;
+}
+
+static void *
+_epgdb_v4_thread ( void *aux )
+{
+  epgdb_v4_loader_t *l = aux;
+  epgdb_v4_job_t *j;
+  int r;
+
+  tvh_mutex_lock(&l->lock);
+  while (!l->abort && l->next < l->njobs) {
+    if (l->next >= l->done + l->window) {
+      tvh_cond_wait(&l->cond, &l->lock);
+      continue;
+    }
+    j = &l->jobs[l->next++];
+    tvh_mutex_unlock(&l->lock);
+    r = _epgdb_v4_decode(l, j);
+    tvh_mutex_lock(&l->lock);
+    j->state = r ? -1 : 1;
+    tvh_cond_signal(&l->cond, 1);
+  }
+  tvh_mutex_unlock(&l->lock);
+  return NULL;
+}
+
+static void
+_epgdb_v4_load ( int fd, struct stat *st,
+                 char **sect, epggrab_stats_t *stats )
+{
+  epgdb_v4_loader_t l;
+  epgdb_v4_job_t *j;
+  pthread_t tids[EPG_DB_MAX_THREADS];
+  uint8_t hdr[16], *idx = NULL;
+  uint32_t i, k, flags, nthreads = 0;
+  off_t off;
+  long ncpu;
+  int r;
+
+  memset(&l, 0, sizeof(l));
+  if (st->st_size < (off_t)sizeof(hdr) ||
+      _epgdb_v4_read(fd, hdr, sizeof(hdr), 0) ||
+      memcmp(hdr, EPG_DB_V4_MAGIC, 8)) {
+    tvherror(LS_EPGDB, "corruption detected, invalid header");
+    return;
+  }
+  flags   = _epgdb_get_u32(hdr + 8);
+  l.njobs = _epgdb_get_u32(hdr + 12);
+  off     = sizeof(hdr) + (off_t)l.njobs * 12;
+  if (off > st->st_size) {
+    tvherror(LS_EPGDB, "corruption detected, invalid index");
+    return;
+  }
+#if !ENABLE_ZLIB
+  if (flags & EPG_DB_V4_GZIP) {
+    tvherror(LS_EPGDB, "unable to load compressed database (no zlib)");
+    return;
+  }
+#endif
+  l.fd = fd;
+  l.compressed = (flags & EPG_DB_V4_GZIP) != 0;
+  l.jobs = calloc(MAX(l.njobs, 1), sizeof(epgdb_v4_job_t));
+  idx = malloc(MAX(l.njobs, 1) * 12);
+  if (l.jobs == NULL || idx == NULL ||
+      _epgdb_v4_read(fd, idx, l.njobs * 12, sizeof(hdr))) {
+    tvherror(LS_EPGDB, "failed to read database index");
+    goto fin;
+  }
+  for (i = 0; i < l.njobs; i++) {
+    j = &l.jobs[i];
+    j->offset  = off;
+    j->stored  = _epgdb_get_u32(idx + i * 12);
+    j->size    = _epgdb_get_u32(idx + i * 12 + 4);
+    j->records = _epgdb_get_u32(idx + i * 12 + 8);
+    off += j->stored;
+    if (off > st->st_size || j->records > j->size) {
+      tvherror(LS_EPGDB, "corruption detected, index exceeds file size");
+      goto fin;
+    }
+  }
+
+  tvhinfo(LS_EPGDB, "parsing %"PRId64" bytes in %u chunks%s",
+          (int64_t)st->st_size, l.njobs, l.compressed ? " (gzip)" : "");
+
+  /* Start workers */
+  tvh_mutex_init(&l.lock, NULL);
+  tvh_cond_init(&l.cond, 1);
+  ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  k = ncpu > 0 ? MIN(ncpu, EPG_DB_MAX_THREADS) : 1;
+  k = MIN(k, l.njobs);
+  l.window = MAX(k, 1) * 2;
+  for ( ; nthreads < k; nthreads++)
+    if (tvh_thread_create(&tids[nthreads], NULL, _epgdb_v4_thread, &l, "epgdb"))
+      break;
+
+  /* Create broadcasts in the file order */
+  for (i = 0; i < l.njobs; i++) {
+    j = &l.jobs[i];
+    tvh_mutex_lock(&l.lock);
+    if (j->state == 0 && l.next == i) {
+      /* nobody took this chunk yet, decode it here */
+      l.next++;
+      tvh_mutex_unlock(&l.lock);
+      r = _epgdb_v4_decode(&l, j);
+      tvh_mutex_lock(&l.lock);
+      j->state = r ? -1 : 1;
+    }
+    while (j->state == 0)
+      tvh_cond_wait(&l.cond, &l.lock);
+    tvh_mutex_unlock(&l.lock);
+    if (j->state < 0) {
+      tvherror(LS_EPGDB, "corruption detected, some/all data lost");
+      break;
+    }
+    for (k = 0; k < j->nmsgs; k++)
+      _epgdb_v3_process(sect, j->msgs[k], stats);
+    _epgdb_v4_job_free(j);
+    tvh_mutex_lock(&l.lock);
+    l.done = i + 1;
+    tvh_cond_signal(&l.cond, 1);
+    tvh_mutex_unlock(&l.lock);
+  }
+
+  /* Stop workers */
+  tvh_mutex_lock(&l.lock);
+  l.abort = 1;
+  tvh_cond_signal(&l.cond, 1);
+  tvh_mutex_unlock(&l.lock);
+  for (k = 0; k < nthreads; k++)
+    pthread_join(tids[k], NULL);
+  tvh_cond_destroy(&l.cond);
+  tvh_mutex_destroy(&l.lock);
+  tvhdebug(LS_EPGDB, "decoded with %u threads", nthreads);
+
+fin:
+  for (i = 0; i < l.njobs && l.jobs; i++)
+    _epgdb_v4_job_free(&l.jobs[i]);
+  free(l.jobs);
+  free(idx);
+}
+
+/*
+ * Load data
+ */
+void epg_init ( void )
+{
+  int fd = -1;
+  struct stat st;
+  epggrab_stats_t stats;
+  int ver = EPG_DB_VERSION;
+  char *sect = NULL;
+  int64_t mono;
+
+  memoryinfo_register(&epg_memoryinfo_broadcasts);
+
+  /* Find the right file (and version) */
+  while (fd < 0 && ver > 0) {
+    fd = hts_settings_open_file(0, "epgdb.v%d", ver);
+    if (fd > 0) break;
+    ver--;
+  }
+  if ( fd < 0 )
+    fd = hts_settings_open_file(0, "epgdb");
+  if ( fd < 0 ) {
+    tvhdebug(LS_EPGDB, "database does not exist");
+    return;
+  }
+
+  /* Check size */
+  if ( fstat(fd, &st) != 0 ) {
+    tvherror(LS_EPGDB, "failed to detect database size");
+    goto end;
+  }
+  if ( !st.st_size ) {
+    tvhdebug(LS_EPGDB, "database is empty");
+    goto end;
+  }
+
+  /* Process */
+  mono = getmonoclock();
+  memset(&stats, 0, sizeof(stats));
+  if (ver >= 4)
+    _epgdb_v4_load(fd, &st, &sect, &stats);
+  else
+    _epgdb_v3_load(fd, &st, ver, &sect, &stats);
+  mono = getmonoclock() - mono;
+
   free(sect);
 
   if (!stats.config.total) {
@@ -235,15 +529,11 @@ void epg_init ( void )
   }
 
   /* Stats */
-  tvhinfo(LS_EPGDB, "loaded v%d", ver);
+  tvhinfo(LS_EPGDB, "loaded v%d (%"PRId64" ms)", ver, mono2ms(mono));
   tvhinfo(LS_EPGDB, "  config     %d", stats.config.total);
   tvhinfo(LS_EPGDB, "  broadcasts %d", stats.broadcasts.total);
 
-  /* Close file */
-  munmap(mem, st.st_size);
-  free(zlib_mem);
 end:
-  sigaction(SIGBUS, &oldact, NULL);
   close(fd);
 }
 
@@ -263,8 +553,45 @@ void epg_done ( void )
  * Save
  * *************************************************************************/
 
-static int _epg_write ( sbuf_t *sb, htsmsg_t *m )
+typedef struct epgdb_chunk {
+  uint32_t offset;
+  uint32_t size;
+  uint32_t records;
+} epgdb_chunk_t;
+
+typedef struct epgdb_save {
+  sbuf_t         sb;
+  epgdb_chunk_t *chunks;
+  uint32_t       nchunks;
+  uint32_t       achunks;
+} epgdb_save_t;
+
+static void _epg_chunk_open ( epgdb_save_t *es )
 {
+  epgdb_chunk_t *c;
+
+  if (es->nchunks == es->achunks) {
+    es->achunks = MAX(es->achunks * 2, 64);
+    es->chunks = realloc(es->chunks, es->achunks * sizeof(epgdb_chunk_t));
+  }
+  c = &es->chunks[es->nchunks++];
+  c->offset = es->sb.sb_ptr;
+  c->size = 0;
+  c->records = 0;
+}
+
+static void _epg_chunk_close ( epgdb_save_t *es )
+{
+  epgdb_chunk_t *c = &es->chunks[es->nchunks - 1];
+
+  c->size = es->sb.sb_ptr - c->offset;
+  if (c->records == 0)
+    es->nchunks--;
+}
+
+static int _epg_write ( epgdb_save_t *es, htsmsg_t *m )
+{
+  sbuf_t *sb = &es->sb;
   int ret = 1;
   size_t msglen;
   void *msgdata;
@@ -279,6 +606,10 @@ static int _epg_write ( sbuf_t *sb, htsmsg_t *m )
         sbuf_realloc(sb, (sb->sb_size - (sb->sb_size % EPG_DB_ALLOC_STEP)) + EPG_DB_ALLOC_STEP);
       sbuf_append(sb, msgdata, msglen);
       free(msgdata);
+      if (++es->chunks[es->nchunks - 1].records >= EPG_DB_CHUNK_RECORDS) {
+        _epg_chunk_close(es);
+        _epg_chunk_open(es);
+      }
     }
   } else {
     ret = 0;
@@ -286,20 +617,67 @@ static int _epg_write ( sbuf_t *sb, htsmsg_t *m )
   return ret;
 }
 
-static int _epg_write_sect ( sbuf_t *sb, const char *sect )
+static int _epg_write_sect ( epgdb_save_t *es, const char *sect )
 {
   htsmsg_t *m = htsmsg_create_map();
   htsmsg_add_str(m, "__section__", sect);
-  return _epg_write(sb, m);
+  return _epg_write(es, m);
+}
+
+static void _epg_save_free ( epgdb_save_t *es )
+{
+  sbuf_free(&es->sb);
+  free(es->chunks);
+  free(es);
+}
+
+static int _epg_write_chunks ( int fd, epgdb_save_t *es, int compress, size_t *total )
+{
+  uint8_t hdr[16], *idx;
+  epgdb_chunk_t *c;
+  size_t stored;
+  uint32_t i;
+  int r;
+
+  /* the index is rewritten once the stored chunk sizes are known */
+  idx = calloc(MAX(es->nchunks, 1), 12);
+  memcpy(hdr, EPG_DB_V4_MAGIC, 8);
+  _epgdb_put_u32(hdr + 8, compress ? EPG_DB_V4_GZIP : 0);
+  _epgdb_put_u32(hdr + 12, es->nchunks);
+  r = tvh_write(fd, hdr, sizeof(hdr)) || tvh_write(fd, idx, es->nchunks * 12);
+  *total = sizeof(hdr) + es->nchunks * 12;
+  for (i = 0; !r && i < es->nchunks; i++) {
+    c = &es->chunks[i];
+#if ENABLE_ZLIB
+    if (compress) {
+      r = tvh_gzip_deflate_fd(fd, (uint8_t *)es->sb.sb_data + c->offset,
+                              c->size, &stored, 3) < 0;
+    } else
+#endif
+      r = tvh_write(fd, es->sb.sb_data + c->offset, stored = c->size);
+    if (r || stored > UINT32_MAX) {
+      r = 1;
+      break;
+    }
+    _epgdb_put_u32(idx + i * 12, stored);
+    _epgdb_put_u32(idx + i * 12 + 4, c->size);
+    _epgdb_put_u32(idx + i * 12 + 8, c->records);
+    *total += stored;
+  }
+  if (!r)
+    r = lseek(fd, sizeof(hdr), SEEK_SET) != (off_t)sizeof(hdr) ||
+        tvh_write(fd, idx, es->nchunks * 12);
+  free(idx);
+  return r;
 }
 
 static void epg_save_tsk_callback ( void *p, int dearmed )
 {
   char tmppath[PATH_MAX+4];
   char path[PATH_MAX];
-  sbuf_t *sb = p;
-  size_t size = sb->sb_ptr, orig;
-  int fd, r;
+  epgdb_save_t *es = p;
+  size_t orig = 0;
+  int fd, r, compress = 0;
 
   tvhinfo(LS_EPGDB, "save start");
   hts_settings_buildpath(path, sizeof(path), "epgdb.v%d", EPG_DB_VERSION);
@@ -310,25 +688,24 @@ static void epg_save_tsk_callback ( void *p, int dearmed )
     fd = tvh_open(tmppath, O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR);
   if (fd >= 0) {
 #if ENABLE_ZLIB
-    if (config.epg_compress) {
-      r = tvh_gzip_deflate_fd_header(fd, sb->sb_data, size, &orig, 3, "01") < 0;
-   } else
+    compress = config.epg_compress;
 #endif
-      r = tvh_write(fd, sb->sb_data, orig = size);
+    r = _epg_write_chunks(fd, es, compress, &orig);
     close(fd);
     if (r) {
       tvherror(LS_EPGDB, "write error (size %zd)", orig);
       if (remove(tmppath))
         tvherror(LS_EPGDB, "unable to remove file %s", tmppath);
     } else {
-      tvhinfo(LS_EPGDB, "stored (size %zd)", orig);
+      tvhinfo(LS_EPGDB, "stored (size %zd, %u chunks)", orig, es->nchunks);
       if (rename(tmppath, path))
         tvherror(LS_EPGDB, "unable to rename file %s to %s", tmppath, path);
+      else
+        hts_settings_remove("epgdb.v%d", EPG_DB_VERSION - 1);
     }
   } else
     tvherror(LS_EPGDB, "unable to open epgdb file");
-  sbuf_free(sb);
-  free(sb);
+  _epg_save_free(es);
 }
 
 void epg_save_callback ( void *p )
@@ -338,39 +715,41 @@ void epg_save_callback ( void *p )
 
 void epg_save ( void )
 {
-  sbuf_t *sb = malloc(sizeof(*sb));
+  epgdb_save_t *es = calloc(1, sizeof(*es));
   epg_broadcast_t *ebc;
   channel_t *ch;
   epggrab_stats_t stats;
   extern gtimer_t epggrab_save_timer;
 
-  if (!sb)
+  if (!es)
     return;
 
   tvhinfo(LS_EPGDB, "snapshot start");
 
-  sbuf_init_fixed(sb, EPG_DB_ALLOC_STEP);
+  sbuf_init_fixed(&es->sb, EPG_DB_ALLOC_STEP);
+  _epg_chunk_open(es);
 
   if (epggrab_conf.epgdb_periodicsave)
     gtimer_arm_rel(&epggrab_save_timer, epg_save_callback, NULL,
                    epggrab_conf.epgdb_periodicsave * 3600);
 
   memset(&stats, 0, sizeof(stats));
-  if ( _epg_write_sect(sb, "config") ) goto error;
-  if (_epg_write(sb, epg_config_serialize())) goto error;
-  if ( _epg_write_sect(sb, "broadcasts") ) goto error;
+  if ( _epg_write_sect(es, "config") ) goto error;
+  if (_epg_write(es, epg_config_serialize())) goto error;
+  if ( _epg_write_sect(es, "broadcasts") ) goto error;
   CHANNEL_FOREACH(ch) {
     if (ch->ch_epg_parent) continue;
     RB_FOREACH(ebc, &ch->ch_epg_schedule, sched_link) {
-      if (_epg_write(sb, epg_broadcast_serialize(ebc))) goto error;
+      if (_epg_write(es, epg_broadcast_serialize(ebc))) goto error;
       stats.broadcasts.total++;
     }
   }
+  _epg_chunk_close(es);
 
-  tasklet_arm_alloc(epg_save_tsk_callback, sb);
+  tasklet_arm_alloc(epg_save_tsk_callback, es);
 
   /* Stats */
-  tvhinfo(LS_EPGDB, "queued to save (size %d)", sb->sb_ptr);
+  tvhinfo(LS_EPGDB, "queued to save (size %d)", es->sb.sb_ptr);
   tvhinfo(LS_EPGDB, "  broadcasts %d", stats.broadcasts.total);
 
   return;
@@ -378,6 +757,5 @@ void epg_save ( void )
 error:
   tvherror(LS_EPGDB, "failed to store epg to disk");
   hts_settings_remove("epgdb.v%d", EPG_DB_VERSION);
-  sbuf_free(sb);
-  free(sb);
+  _epg_save_free(es);
 }
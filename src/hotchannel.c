@@ -0,0 +1,142 @@
+/*
+ *  tvheadend, hot channels
+ *  Copyright (C) 2026 Tvheadend Foundation CIC
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tvheadend.h"
+#include "channels.h"
+#include "subscriptions.h"
+#include "hotchannel.h"
+
+static LIST_HEAD(, hotchannel) hotchannels;
+static int hotchannel_running;
+
+/*
+ * The packets are only kept in the GOP cache of the shared parser
+ */
+static void
+hotchannel_input(void *opaque, streaming_message_t *sm)
+{
+  streaming_msg_free(sm);
+}
+
+static htsmsg_t *
+hotchannel_input_info(void *opaque, htsmsg_t *list)
+{
+  htsmsg_add_str(list, NULL, "hot channel input");
+  return list;
+}
+
+static streaming_ops_t hotchannel_input_ops = {
+  .st_cb   = hotchannel_input,
+  .st_info = hotchannel_input_info
+};
+
+/*
+ *
+ */
+static void
+hotchannel_start(channel_t *ch)
+{
+  hotchannel_t *hch = calloc(1, sizeof(*hch));
+
+  hch->hch_channel = ch;
+  profile_chain_init(&hch->hch_prch, NULL, ch, 0);
+  streaming_target_init(&hch->hch_input, &hotchannel_input_ops, hch, 0);
+  hch->hch_prch.prch_st = &hch->hch_input;
+  hch->hch_sub = subscription_create_from_channel(&hch->hch_prch, NULL,
+                   SUBSCRIPTION_PRIO_KEEP, "hotchannel",
+                   SUBSCRIPTION_PACKET | SUBSCRIPTION_HOT |
+                   SUBSCRIPTION_RESTART,
+                   NULL, NULL, "hotchannel", NULL);
+  if (hch->hch_sub == NULL) {
+    tvherror(LS_SUBSCRIPTION, "hot channel %s: unable to subscribe",
+             channel_get_name(ch, channel_blank_name));
+    profile_chain_close(&hch->hch_prch);
+    free(hch);
+    return;
+  }
+  ch->ch_hotchannel = hch;
+  LIST_INSERT_HEAD(&hotchannels, hch, hch_link);
+  tvhinfo(LS_SUBSCRIPTION, "hot channel %s: started",
+          channel_get_name(ch, channel_blank_name));
+}
+
+static void
+hotchannel_stop(hotchannel_t *hch)
+{
+  channel_t *ch = hch->hch_channel;
+
+  tvhinfo(LS_SUBSCRIPTION, "hot channel %s: stopped",
+          channel_get_name(ch, channel_blank_name));
+  LIST_REMOVE(hch, hch_link);
+  ch->ch_hotchannel = NULL;
+  subscription_unsubscribe(hch->hch_sub, UNSUBSCRIBE_QUIET | UNSUBSCRIBE_FINAL);
+  profile_chain_close(&hch->hch_prch);
+  free(hch);
+}
+
+/*
+ *
+ */
+void
+hotchannel_update(channel_t *ch)
+{
+  lock_assert(&global_lock);
+
+  if (!hotchannel_running)
+    return;
+  if (ch->ch_hot && ch->ch_enabled) {
+    if (ch->ch_hotchannel == NULL)
+      hotchannel_start(ch);
+  } else {
+    hotchannel_remove(ch);
+  }
+}
+
+void
+hotchannel_remove(channel_t *ch)
+{
+  lock_assert(&global_lock);
+
+  if (ch->ch_hotchannel)
+    hotchannel_stop(ch->ch_hotchannel);
+}
+
+/*
+ *
+ */
+void
+hotchannel_init(void)
+{
+  channel_t *ch;
+
+  hotchannel_running = 1;
+  CHANNEL_FOREACH(ch)
+    hotchannel_update(ch);
+}
+
+void
+hotchannel_done(void)
+{
+  hotchannel_t *hch;
+
+  tvh_mutex_lock(&global_lock);
+  hotchannel_running = 0;
+  while ((hch = LIST_FIRST(&hotchannels)) != NULL)
+    hotchannel_stop(hch);
+  tvh_mutex_unlock(&global_lock);
+}
@@ -0,0 +1,47 @@
+/*
+ *  tvheadend, hot channels
+ *  Copyright (C) 2026 Tvheadend Foundation CIC
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TVH_HOTCHANNEL_H__
+#define __TVH_HOTCHANNEL_H__
+
+#include "profile.h"
+#include "streaming.h"
+
+struct channel;
+struct th_subscription;
+
+/*
+ * Hot channel keeps the channel running using the lowest subscription
+ * priority (spare tuners only), the shared parser of the running service
+ * holds the GOP cache which is replayed to the new subscriptions
+ */
+typedef struct hotchannel {
+  LIST_ENTRY(hotchannel)  hch_link;
+  struct channel         *hch_channel;
+  profile_chain_t         hch_prch;
+  streaming_target_t      hch_input;
+  struct th_subscription *hch_sub;
+} hotchannel_t;
+
+void hotchannel_update(struct channel *ch);
+void hotchannel_remove(struct channel *ch);
+
+void hotchannel_init(void);
+void hotchannel_done(void);
+
+#endif /* __TVH_HOTCHANNEL_H__ */
@@ -82,10 +82,10 @@ htsbuf_queue_flush(htsbuf_queue_t *hq)
 {
   htsbuf_data_t *hd;
 
-  hq->hq_size = 0;
-
   while((hd = TAILQ_FIRST(&hq->hq_q)) != NULL)
     htsbuf_data_free(hq, hd);
+
+  hq->hq_size = 0;
 }
 
 /**
@@ -37,6 +37,99 @@ memoryinfo_t htsmsg_field_memoryinfo = { .my_name = "htsmsg field" };
 static void htsmsg_clear(htsmsg_t *msg);
 static htsmsg_t *htsmsg_field_get_msg ( htsmsg_field_t *f, int islist );
 
+/*
+ * Name hash index for the large maps, built when a lookup walks more
+ * than HTSMSG_INDEX_THRESHOLD fields, kept up to date when the fields
+ * are added and dropped when a field is removed. Duplicate names
+ * resolve to the first field like the linear lookup.
+ */
+
+#define HTSMSG_INDEX_THRESHOLD 16
+
+typedef struct htsmsg_index {
+  uint32_t        hi_mask;
+  uint32_t        hi_count;
+  htsmsg_field_t *hi_slots[0];
+} htsmsg_index_t;
+
+static inline uint32_t
+htsmsg_index_hash(const char *s)
+{
+  uint32_t h = 2166136261U;
+
+  while (*s)
+    h = (h ^ (uint8_t)*s++) * 16777619U;
+  return h;
+}
+
+static void
+htsmsg_index_insert(htsmsg_index_t *hi, htsmsg_field_t *f)
+{
+  const char *name = htsmsg_field_name(f);
+  uint32_t i = htsmsg_index_hash(name) & hi->hi_mask;
+  htsmsg_field_t *f2;
+
+  while ((f2 = hi->hi_slots[i]) != NULL) {
+    if (strcmp(htsmsg_field_name(f2), name) == 0)
+      return;
+    i = (i + 1) & hi->hi_mask;
+  }
+  hi->hi_slots[i] = f;
+  hi->hi_count++;
+}
+
+static htsmsg_index_t *
+htsmsg_index_build(const htsmsg_t *msg)
+{
+  htsmsg_index_t *hi;
+  htsmsg_field_t *f;
+  size_t count = 0, size = 64;
+
+  TAILQ_FOREACH(f, &msg->hm_fields, hmf_link)
+    count++;
+  while (size < count * 4)
+    size <<= 1;
+  hi = calloc(1, sizeof(*hi) + size * sizeof(htsmsg_field_t *));
+  if (hi == NULL)
+    return NULL;
+  hi->hi_mask = size - 1;
+  TAILQ_FOREACH(f, &msg->hm_fields, hmf_link)
+    htsmsg_index_insert(hi, f);
+  return hi;
+}
+
+static htsmsg_field_t *
+htsmsg_index_find(htsmsg_index_t *hi, const char *name)
+{
+  uint32_t i = htsmsg_index_hash(name) & hi->hi_mask;
+  htsmsg_field_t *f;
+
+  while ((f = hi->hi_slots[i]) != NULL) {
+    if (strcmp(htsmsg_field_name(f), name) == 0)
+      return f;
+    i = (i + 1) & hi->hi_mask;
+  }
+  return NULL;
+}
+
+static inline void
+htsmsg_index_clear(htsmsg_t *msg)
+{
+  free(msg->hm_index);
+  msg->hm_index = NULL;
+}
+
+/*
+ * Move all fields (and the index) from src to dst
+ */
+static inline void
+htsmsg_fields_move(htsmsg_t *dst, htsmsg_t *src)
+{
+  TAILQ_MOVE(&dst->hm_fields, &src->hm_fields, hmf_link);
+  dst->hm_index = src->hm_index;
+  src->hm_index = NULL;
+}
+
 /**
  *
  */
@@ -85,6 +178,8 @@ void
 htsmsg_field_destroy(htsmsg_t *msg, htsmsg_field_t *f)
 {
   TAILQ_REMOVE(&msg->hm_fields, f, hmf_link);
+  if (msg->hm_index)
+    htsmsg_index_clear(msg);
 
   htsmsg_field_data_destroy(f);
 
@@ -105,6 +200,7 @@ htsmsg_clear(htsmsg_t *msg)
 
   while((f = TAILQ_FIRST(&msg->hm_fields)) != NULL)
     htsmsg_field_destroy(msg, f);
+  htsmsg_index_clear(msg);
 }
 
 
@@ -160,6 +256,14 @@ htsmsg_field_add(htsmsg_t *msg, const char *name, int type, int flags, size_t es
   memoryinfo_alloc(&htsmsg_field_memoryinfo,
                    sizeof(htsmsg_field_t) + f->hmf_edata_size);
 #endif
+  if (msg->hm_index) {
+    if ((msg->hm_index->hi_count + 1) * 2 > msg->hm_index->hi_mask) {
+      htsmsg_index_clear(msg);
+      msg->hm_index = htsmsg_index_build(msg);
+    } else {
+      htsmsg_index_insert(msg->hm_index, f);
+    }
+  }
   return f;
 }
 
@@ -170,15 +274,29 @@ htsmsg_field_add(htsmsg_t *msg, const char *name, int type, int flags, size_t es
 htsmsg_field_t *
 htsmsg_field_find(const htsmsg_t *msg, const char *name)
 {
+  htsmsg_index_t *hi, *hi0 = NULL;
   htsmsg_field_t *f;
+  uint32_t count = 0;
 
   if (msg == NULL || name == NULL)
     return NULL;
+  /* concurrent readers might build the index, the first one is used */
+  hi = __atomic_load_n(&msg->hm_index, __ATOMIC_ACQUIRE);
+  if (hi)
+    return htsmsg_index_find(hi, name);
   TAILQ_FOREACH(f, &msg->hm_fields, hmf_link) {
     if(!strcmp(htsmsg_field_name(f), name))
-      return f;
+      break;
+    count++;
   }
-  return NULL;
+  if (count > HTSMSG_INDEX_THRESHOLD && !msg->hm_islist) {
+    hi = htsmsg_index_build(msg);
+    if (hi && !__atomic_compare_exchange_n((htsmsg_index_t **)&msg->hm_index,
+                                           &hi0, hi, 0, __ATOMIC_RELEASE,
+                                           __ATOMIC_ACQUIRE))
+      free(hi);
+  }
+  return f;
 }
 
 
@@ -234,6 +352,7 @@ htsmsg_create_map(void)
   msg = malloc(sizeof(htsmsg_t));
   if (msg) {
     TAILQ_INIT(&msg->hm_fields);
+    msg->hm_index = NULL;
     msg->hm_data = NULL;
     msg->hm_data_size = 0;
     msg->hm_islist = 0;
@@ -255,6 +374,7 @@ htsmsg_create_list(void)
   msg = malloc(sizeof(htsmsg_t));
   if (msg) {
     TAILQ_INIT(&msg->hm_fields);
+    msg->hm_index = NULL;
     msg->hm_data = NULL;
     msg->hm_data_size = 0;
     msg->hm_islist = 1;
@@ -279,6 +399,7 @@ htsmsg_concat(htsmsg_t *msg, htsmsg_t *sub)
   if (msg->hm_islist != sub->hm_islist)
     return;
   TAILQ_CONCAT(&msg->hm_fields, &sub->hm_fields, hmf_link);
+  htsmsg_index_clear(msg);
   htsmsg_destroy(sub);
 }
 
@@ -625,7 +746,7 @@ htsmsg_field_set_msg(htsmsg_field_t *f, htsmsg_t *sub)
   m->hm_data = NULL;
   m->hm_data_size = 0;
   m->hm_islist = sub->hm_islist;
-  TAILQ_MOVE(&m->hm_fields, &sub->hm_fields, hmf_link);
+  htsmsg_fields_move(m, sub);
   htsmsg_destroy(sub);
 
   if (f->hmf_type == (m->hm_islist ? HMF_LIST : HMF_MAP))
@@ -676,7 +797,7 @@ htsmsg_add_msg_extname(htsmsg_t *msg, const char *name, htsmsg_t *sub)
   assert(sub->hm_data == NULL);
   m->hm_data = NULL;
   m->hm_data_size = 0;
-  TAILQ_MOVE(&m->hm_fields, &sub->hm_fields, hmf_link);
+  htsmsg_fields_move(m, sub);
   m->hm_islist = sub->hm_islist;
   htsmsg_destroy(sub);
 }
@@ -1161,7 +1282,7 @@ htsmsg_field_get_msg ( htsmsg_field_t *f, int islist )
       l->hm_islist    = m->hm_islist;
       l->hm_data      = NULL;
       l->hm_data_size = 0;
-      TAILQ_MOVE(&l->hm_fields, &m->hm_fields, hmf_link);
+      htsmsg_fields_move(l, m);
       htsmsg_destroy(m);
     }
   }
@@ -1181,7 +1302,7 @@ htsmsg_detach_submsg(htsmsg_field_t *f)
   htsmsg_t *m = f->hmf_msg;
   htsmsg_t *r = htsmsg_create_map();
 
-  TAILQ_MOVE(&r->hm_fields, &m->hm_fields, hmf_link);
+  htsmsg_fields_move(r, m);
   r->hm_islist = f->hmf_type == HMF_LIST;
   return r;
 }
@@ -28,12 +28,19 @@
 
 TAILQ_HEAD(htsmsg_field_queue, htsmsg_field);
 
+struct htsmsg_index;
+
 typedef struct htsmsg {
   /**
    * fields 
    */
   struct htsmsg_field_queue hm_fields;
 
+  /**
+   * Name hash index, built on demand for the large maps
+   */
+  struct htsmsg_index *hm_index;
+
   /**
    * Set if this message is a list, otherwise it is a map.
    */
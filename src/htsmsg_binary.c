@@ -115,6 +115,7 @@ htsmsg_binary_des0(htsmsg_t *msg, const uint8_t *buf, size_t len)
     case HMF_LIST:
       sub = f->hmf_msg = (htsmsg_t *)(f->_hmf_name + nlen);
       TAILQ_INIT(&sub->hm_fields);
+      sub->hm_index = NULL;
       sub->hm_data = NULL;
       sub->hm_data_size = 0;
       sub->hm_islist = type == HMF_LIST;
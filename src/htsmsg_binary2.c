@@ -174,6 +174,7 @@ htsmsg_binary2_des0(htsmsg_t *msg, const uint8_t *buf, uint32_t len)
     case HMF_LIST:
       sub = f->hmf_msg = (htsmsg_t *)(f->_hmf_name + nlen);
       TAILQ_INIT(&sub->hm_fields);
+      sub->hm_index = NULL;
       sub->hm_data = NULL;
       sub->hm_data_size = 0;
       sub->hm_islist = type == HMF_LIST;
@@ -193,6 +194,13 @@ htsmsg_binary2_des0(htsmsg_t *msg, const uint8_t *buf, uint32_t len)
       f->hmf_bool = datalen == 1 ? buf[0] : 0;
       break;
 
+    case HMF_DBL:
+      u64 = 0;
+      for(i = datalen - 1; i >= 0; i--)
+	  u64 = (u64 << 8) | buf[i];
+      memcpy(&f->hmf_dbl, &u64, sizeof(u64));
+      break;
+
     default:
 #if ENABLE_SLOW_MEMORYINFO
       memoryinfo_free(&htsmsg_field_memoryinfo, tlen);
@@ -309,6 +317,9 @@ htsmsg_binary2_field_length(htsmsg_field_t *f)
   case HMF_BOOL:
     return f->hmf_bool ? 1 : 0;
 
+  case HMF_DBL:
+    return sizeof(f->hmf_dbl);
+
   default:
     abort();
   }
@@ -387,6 +398,14 @@ htsmsg_binary2_write(htsmsg_t *msg, uint8_t *ptr)
         ptr[0] = 1;
       break;
 
+    case HMF_DBL:
+      memcpy(&u64, &f->hmf_dbl, sizeof(u64));
+      for(i = 0; i < l; i++) {
+	ptr[i] = u64;
+	u64 >>= 8;
+      }
+      break;
+
     default:
       abort();
     }
@@ -116,6 +116,107 @@ htsmsg_json_serialize(htsmsg_t *msg, htsbuf_queue_t *hq, int pretty)
 }
 
 
+/**
+ * Streaming writer, the output is passed to the flush callback in parts
+ */
+void
+htsmsg_json_writer_init(htsmsg_json_writer_t *w, htsbuf_queue_t *hq,
+                        size_t flush_size,
+                        void (*flush)(void *opaque, htsbuf_queue_t *hq),
+                        void *opaque)
+{
+  memset(w, 0, sizeof(*w));
+  w->hjw_hq = hq;
+  w->hjw_flush_size = flush_size;
+  w->hjw_flush = flush;
+  w->hjw_opaque = opaque;
+}
+
+static void
+htsmsg_json_writer_name(htsmsg_json_writer_t *w, const char *name)
+{
+  uint32_t bit;
+
+  if (w->hjw_depth == 0)
+    return;
+  bit = 1 << (w->hjw_depth - 1);
+  if (w->hjw_first & bit)
+    w->hjw_first &= ~bit;
+  else
+    htsbuf_append(w->hjw_hq, ",", 1);
+  if ((w->hjw_list & bit) == 0) {
+    htsbuf_append_and_escape_jsonstr(w->hjw_hq, name ?: "");
+    htsbuf_append(w->hjw_hq, ":", 1);
+  }
+}
+
+static void
+htsmsg_json_writer_start(htsmsg_json_writer_t *w, const char *name, int islist)
+{
+  uint32_t bit;
+
+  assert(w->hjw_depth < 32);
+  htsmsg_json_writer_name(w, name);
+  bit = 1 << w->hjw_depth++;
+  w->hjw_first |= bit;
+  if (islist)
+    w->hjw_list |= bit;
+  else
+    w->hjw_list &= ~bit;
+  htsbuf_append(w->hjw_hq, islist ? "[" : "{", 1);
+}
+
+void
+htsmsg_json_writer_map_start(htsmsg_json_writer_t *w, const char *name)
+{
+  htsmsg_json_writer_start(w, name, 0);
+}
+
+void
+htsmsg_json_writer_list_start(htsmsg_json_writer_t *w, const char *name)
+{
+  htsmsg_json_writer_start(w, name, 1);
+}
+
+void
+htsmsg_json_writer_end(htsmsg_json_writer_t *w)
+{
+  assert(w->hjw_depth > 0);
+  w->hjw_depth--;
+  htsbuf_append(w->hjw_hq, (w->hjw_list & (1 << w->hjw_depth)) ? "]" : "}", 1);
+}
+
+void
+htsmsg_json_writer_add_msg(htsmsg_json_writer_t *w, const char *name,
+                           htsmsg_t *msg)
+{
+  htsmsg_json_writer_name(w, name);
+  htsmsg_json_write(msg, w->hjw_hq, msg->hm_islist, 2, 0);
+}
+
+void
+htsmsg_json_writer_add_s64(htsmsg_json_writer_t *w, const char *name,
+                           int64_t s64)
+{
+  char buf[32];
+
+  htsmsg_json_writer_name(w, name);
+  snprintf(buf, sizeof(buf), "%" PRId64, s64);
+  htsbuf_append_str(w->hjw_hq, buf);
+}
+
+/**
+ * Pass the buffered output to the flush callback, the callers must not
+ * hold the locks which the flush (network write) might block
+ */
+void
+htsmsg_json_writer_flush(htsmsg_json_writer_t *w)
+{
+  if (w->hjw_flush && w->hjw_hq->hq_size > 0)
+    w->hjw_flush(w->hjw_opaque, w->hjw_hq);
+}
+
+
 /**
  *
  */
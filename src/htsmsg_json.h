@@ -33,4 +33,39 @@ char *htsmsg_json_serialize_to_str(htsmsg_t *msg, int pretty);
 
 struct rstr *htsmsg_json_serialize_to_rstr(htsmsg_t *msg, const char *prefix);
 
+/**
+ * Streaming writer
+ */
+typedef struct htsmsg_json_writer {
+  htsbuf_queue_t *hjw_hq;
+  size_t          hjw_flush_size;
+  void          (*hjw_flush)(void *opaque, htsbuf_queue_t *hq);
+  void           *hjw_opaque;
+  int             hjw_depth;
+  uint32_t        hjw_list;   /* bit per depth: list */
+  uint32_t        hjw_first;  /* bit per depth: no element written yet */
+} htsmsg_json_writer_t;
+
+void htsmsg_json_writer_init(htsmsg_json_writer_t *w, htsbuf_queue_t *hq,
+                             size_t flush_size,
+                             void (*flush)(void *opaque, htsbuf_queue_t *hq),
+                             void *opaque);
+
+void htsmsg_json_writer_map_start(htsmsg_json_writer_t *w, const char *name);
+
+void htsmsg_json_writer_list_start(htsmsg_json_writer_t *w, const char *name);
+
+void htsmsg_json_writer_end(htsmsg_json_writer_t *w);
+
+void htsmsg_json_writer_add_msg(htsmsg_json_writer_t *w, const char *name,
+                                htsmsg_t *msg);
+
+void htsmsg_json_writer_add_s64(htsmsg_json_writer_t *w, const char *name,
+                                int64_t s64);
+
+void htsmsg_json_writer_flush(htsmsg_json_writer_t *w);
+
+static inline int htsmsg_json_writer_full(htsmsg_json_writer_t *w)
+  { return w->hjw_hq->hq_size >= w->hjw_flush_size; }
+
 #endif /* HTSMSG_JSON_H_ */
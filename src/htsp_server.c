@@ -74,12 +74,14 @@ static struct htsp_connection_list htsp_connections;
 
 static void htsp_streaming_input(void *opaque, streaming_message_t *sm);
 static htsmsg_t *htsp_streaming_input_info(void *opaque, htsmsg_t *list);
+static int htsp_streaming_input_pressure(void *opaque, streaming_pressure_t *bp);
 const char * _htsp_get_subscription_status(int smcode);
 static void htsp_epg_send_waiting(struct htsp_connection *, int64_t mintime);
 
 static streaming_ops_t htsp_streaming_input_ops = {
-  .st_cb   = htsp_streaming_input,
-  .st_info = htsp_streaming_input_info
+  .st_cb       = htsp_streaming_input,
+  .st_info     = htsp_streaming_input_info,
+  .st_pressure = htsp_streaming_input_pressure
 };
 
 /**
@@ -188,7 +190,11 @@ typedef struct htsp_subscription {
 
   int64_t hs_last_report; /* Last queue status report sent */
 
-  int hs_dropstats[PKT_NTYPES];
+  int hs_dropstats[PKT_NTYPES]; /* [0] = not video */
+  uint64_t hs_drop_bytes;
+  int64_t hs_gop_skip;
+  int64_t hs_queue_delay;  /* Last queue status report */
+  int64_t hs_peak_delay;
 
   int hs_wait_for_video;
 
@@ -4015,6 +4021,37 @@ static const char frametypearray[PKT_NTYPES] = {
   [PKT_B_FRAME] = 'B',
 };
 
+/**
+ * Real time queue delay in the packet time units (htsp_out_mutex is held)
+ */
+static int64_t
+htsp_queue_delay(htsp_subscription_t *hs)
+{
+  htsp_msg_t *hm;
+  int64_t ts;
+  int64_t min_dts = PTS_UNSET;
+  int64_t max_dts = PTS_UNSET;
+  TAILQ_FOREACH(hm, &hs->hs_q.hmq_q, hm_link) {
+    if(!hm->hm_msg)
+      continue;
+    if(htsmsg_get_s64(hm->hm_msg, "dts", &ts))
+      continue;
+    if(ts == PTS_UNSET)
+      continue;
+
+    if(min_dts == PTS_UNSET)
+      min_dts = ts;
+    else
+      min_dts = MIN(ts, min_dts);
+
+    if(max_dts == PTS_UNSET)
+      max_dts = ts;
+    else
+      max_dts = MAX(ts, max_dts);
+  }
+  return max_dts - min_dts;
+}
+
 /**
  * Build a htsmsg from a th_pkt and enqueue it on our HTSP service
  */
@@ -4022,12 +4059,12 @@ static void
 htsp_stream_deliver(htsp_subscription_t *hs, th_pkt_t *pkt)
 {
   htsmsg_t *m;
-  htsp_msg_t *hm;
   htsp_connection_t *htsp = hs->hs_htsp;
   int64_t ts;
   int qlen = hs->hs_q.hmq_payload;
   int video = SCT_ISVIDEO(pkt->pkt_type);
   size_t payloadlen;
+  streaming_pressure_t bp = { 0 };
 
   if (pkt->pkt_err)
     hs->hs_data_errors += pkt->pkt_err;
@@ -4040,14 +4077,14 @@ htsp_stream_deliver(htsp_subscription_t *hs, th_pkt_t *pkt)
     return;
   }
 
-  if(video &&
-     ((qlen > hs->hs_queue_depth     && pkt->v.pkt_frametype == PKT_B_FRAME) ||
-      (qlen > hs->hs_queue_depth * 2 && pkt->v.pkt_frametype == PKT_P_FRAME) ||
-      (qlen > hs->hs_queue_depth * 3))) {
-
-    hs->hs_dropstats[pkt->v.pkt_frametype]++;
-
-    /* Queue size protection */
+  /* Queue size protection, queueDepth 0 drops the video over any backlog */
+  bp.bp_bytes = qlen;
+  bp.bp_max_bytes = hs->hs_queue_depth;
+  if (hs->hs_queue_depth == 0 ? video && qlen > 0 :
+      streaming_pressure_drop(SQ_POLICY_FRAME, streaming_pressure_level(&bp),
+                              pkt, &hs->hs_gop_skip)) {
+    hs->hs_dropstats[video ? pkt->v.pkt_frametype : 0]++;
+    hs->hs_drop_bytes += pktbuf_len(pkt->pkt_payload);
     pkt_ref_dec(pkt);
     return;
   }
@@ -4104,28 +4141,10 @@ htsp_stream_deliver(htsp_subscription_t *hs, th_pkt_t *pkt)
     
     tvh_mutex_lock(&htsp->htsp_out_mutex);
 
-    int64_t min_dts = PTS_UNSET;
-    int64_t max_dts = PTS_UNSET;
-    TAILQ_FOREACH(hm, &hs->hs_q.hmq_q, hm_link) {
-      if(!hm->hm_msg)
-	continue;
-      if(htsmsg_get_s64(hm->hm_msg, "dts", &ts))
-	continue;
-      if(ts == PTS_UNSET)
-	continue;
-  
-      if(min_dts == PTS_UNSET)
-	min_dts = ts;
-      else
-	min_dts = MIN(ts, min_dts);
-
-      if(max_dts == PTS_UNSET)
-	max_dts = ts;
-      else
-	max_dts = MAX(ts, max_dts);
-    }
-
-    htsmsg_add_s64(m, "delay", max_dts - min_dts);
+    ts = hs->hs_queue_delay = htsp_queue_delay(hs);
+    if (ts > hs->hs_peak_delay)
+      hs->hs_peak_delay = ts;
+    htsmsg_add_s64(m, "delay", ts);
 
     tvh_mutex_unlock(&htsp->htsp_out_mutex);
 
@@ -4561,3 +4580,29 @@ htsp_streaming_input_info(void *opaque, htsmsg_t *list)
   htsmsg_add_str(list, NULL, buf);
   return list;
 }
+
+static int
+htsp_streaming_input_pressure(void *opaque, streaming_pressure_t *bp)
+{
+  htsp_subscription_t *hs = opaque;
+  htsp_connection_t *htsp = hs->hs_htsp;
+  int64_t delay, peak;
+  int i;
+
+  tvh_mutex_lock(&htsp->htsp_out_mutex);
+  bp->bp_bytes = hs->hs_q.hmq_payload;
+  delay = hs->hs_queue_delay;
+  peak = hs->hs_peak_delay;
+  tvh_mutex_unlock(&htsp->htsp_out_mutex);
+  if (hs->hs_90khz) {
+    delay = ts_rescale(delay, 1000000);
+    peak = ts_rescale(peak, 1000000);
+  }
+  bp->bp_delay = delay;
+  bp->bp_peak_delay = peak;
+  bp->bp_max_bytes = hs->hs_queue_depth;
+  for (i = 0; i < PKT_NTYPES; i++)
+    bp->bp_drops += hs->hs_dropstats[i];
+  bp->bp_drop_bytes = hs->hs_drop_bytes;
+  return 0;
+}
@@ -192,6 +192,7 @@ http_rc2str(int code)
   case HTTP_STATUS_OK:              /* 200 */ return "OK";
   case HTTP_STATUS_PARTIAL_CONTENT: /* 206 */ return "Partial Content";
   case HTTP_STATUS_FOUND:           /* 302 */ return "Found";
+  case HTTP_STATUS_NOT_MODIFIED:    /* 304 */ return "Not Modified";
   case HTTP_STATUS_BAD_REQUEST:     /* 400 */ return "Bad Request";
   case HTTP_STATUS_UNAUTHORIZED:    /* 401 */ return "Unauthorized";
   case HTTP_STATUS_FORBIDDEN:       /* 403 */ return "Forbidden";
@@ -739,6 +740,159 @@ http_output_content(http_connection_t *hc, const char *content)
   return http_send_reply(hc, HTTP_STATUS_OK, content, NULL, NULL, 0);
 }
 
+/**
+ * Send a prepared reply with an entity tag, data_gz is the optional
+ * gzip encoded variant of data; answers 304 when the client has it
+ */
+void
+http_output_content_etag(http_connection_t *hc, const char *content,
+                         const void *data, size_t size,
+                         const void *data_gz, size_t size_gz,
+                         const char *etag)
+{
+  http_arg_list_t args;
+  const char *encoding = NULL, *inm;
+  int rc = HTTP_STATUS_OK;
+
+  http_arg_init(&args);
+  http_arg_set(&args, "ETag", etag);
+  if ((hc->hc_cmd == HTTP_CMD_GET || hc->hc_cmd == HTTP_CMD_HEAD) &&
+      (inm = http_arg_get(&hc->hc_args, "If-None-Match")) != NULL &&
+      (strstr(inm, etag) || strcmp(inm, "*") == 0)) {
+    rc = HTTP_STATUS_NOT_MODIFIED;
+    content = NULL;
+    size = 0;
+  } else if (data_gz) {
+    http_arg_set(&args, "Vary", "Accept-Encoding");
+    if (http_encoding_valid(hc, "gzip")) {
+      data = data_gz;
+      size = size_gz;
+      encoding = "gzip";
+    }
+  }
+
+  http_send_begin(hc);
+  http_send_header(hc, rc, content,
+                   rc == HTTP_STATUS_OK && size == 0 ? INT64_MIN : size,
+                   encoding, NULL, 0, NULL, NULL, &args);
+  if (!hc->hc_no_output && size > 0)
+    tvh_write(hc->hc_fd, data, size);
+  http_send_end(hc);
+
+  http_arg_flush(&args);
+}
+
+
+
+/**
+ * Streamed reply, the body is sent while it is generated using
+ * the chunked transfer encoding (HTTP/1.1) or until the connection
+ * is closed (HTTP/1.0)
+ */
+void
+http_stream_begin(http_connection_t *hc, http_stream_t *hs, const char *content)
+{
+  http_arg_list_t args;
+  const char *encoding = NULL;
+
+  memset(hs, 0, sizeof(*hs));
+  hs->hs_hc = hc;
+  hs->hs_chunked = hc->hc_version == HTTP_VERSION_1_1;
+  if (!hs->hs_chunked)
+    hc->hc_keep_alive = 0;
+  http_arg_init(&args);
+  if (hs->hs_chunked)
+    http_arg_set(&args, "Transfer-Encoding", "chunked");
+#if ENABLE_ZLIB
+  http_arg_set(&args, "Vary", "Accept-Encoding");
+  if (http_encoding_valid(hc, "gzip") &&
+      (hs->hs_gzip = tvh_gzip_stream_create(6)) != NULL)
+    encoding = "gzip";
+#endif
+  http_send_begin(hc);
+  http_send_header(hc, HTTP_STATUS_OK, content, 0, encoding,
+                   NULL, 0, NULL, NULL, &args);
+  http_arg_flush(&args);
+}
+
+static int
+http_stream_chunk(http_stream_t *hs, htsbuf_queue_t *q)
+{
+  htsbuf_queue_t hq;
+
+  if (hs->hs_error || q->hq_size == 0)
+    return hs->hs_error;
+  hs->hs_size += q->hq_size;
+  if (hs->hs_chunked) {
+    htsbuf_queue_init(&hq, 0);
+    htsbuf_qprintf(&hq, "%x\r\n", q->hq_size);
+    htsbuf_appendq(&hq, q);
+    htsbuf_append(&hq, "\r\n", 2);
+    hs->hs_error = tcp_write_queue(hs->hs_hc->hc_fd, &hq);
+  } else {
+    hs->hs_error = tcp_write_queue(hs->hs_hc->hc_fd, q);
+  }
+  return hs->hs_error;
+}
+
+/**
+ * Send the queued data, the queue is emptied
+ */
+int
+http_stream_write(http_stream_t *hs, htsbuf_queue_t *q)
+{
+#if ENABLE_ZLIB
+  htsbuf_queue_t zq;
+  htsbuf_data_t *hd;
+#endif
+
+  if (hs->hs_hc->hc_no_output || hs->hs_error) {
+    htsbuf_queue_flush(q);
+    return hs->hs_error;
+  }
+#if ENABLE_ZLIB
+  if (hs->hs_gzip) {
+    htsbuf_queue_init(&zq, 0);
+    TAILQ_FOREACH(hd, &q->hq_q, hd_link)
+      if (tvh_gzip_stream_write(hs->hs_gzip, hd->hd_data + hd->hd_data_off,
+                                hd->hd_data_len - hd->hd_data_off,
+                                TAILQ_NEXT(hd, hd_link) == NULL, &zq)) {
+        hs->hs_error = EIO;
+        break;
+      }
+    htsbuf_queue_flush(q);
+    http_stream_chunk(hs, &zq);
+    htsbuf_queue_flush(&zq);
+    return hs->hs_error;
+  }
+#endif
+  return http_stream_chunk(hs, q);
+}
+
+int
+http_stream_end(http_stream_t *hs)
+{
+  http_connection_t *hc = hs->hs_hc;
+  htsbuf_queue_t q;
+
+  htsbuf_queue_init(&q, 0);
+#if ENABLE_ZLIB
+  if (hs->hs_gzip) {
+    if (!hc->hc_no_output && !hs->hs_error &&
+        tvh_gzip_stream_write(hs->hs_gzip, NULL, 0, 2, &q) == 0)
+      http_stream_chunk(hs, &q);
+    htsbuf_queue_flush(&q);
+    tvh_gzip_stream_destroy(hs->hs_gzip);
+    hs->hs_gzip = NULL;
+  }
+#endif
+  if (hs->hs_chunked && !hc->hc_no_output && !hs->hs_error) {
+    htsbuf_append_str(&q, "0\r\n\r\n");
+    hs->hs_error = tcp_write_queue(hc->hc_fd, &q);
+  }
+  http_send_end(hc);
+  return hs->hs_error;
+}
 
 
 /**
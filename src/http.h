@@ -243,6 +243,26 @@ void http_output_html(http_connection_t *hc);
 
 void http_output_content(http_connection_t *hc, const char *content);
 
+void http_output_content_etag(http_connection_t *hc, const char *content,
+                              const void *data, size_t size,
+                              const void *data_gz, size_t size_gz,
+                              const char *etag);
+
+typedef struct http_stream {
+  http_connection_t      *hs_hc;
+  int                     hs_chunked;
+  int                     hs_error;
+  int64_t                 hs_size;
+  struct tvh_gzip_stream *hs_gzip;
+} http_stream_t;
+
+void http_stream_begin(http_connection_t *hc, http_stream_t *hs,
+                       const char *content);
+
+int http_stream_write(http_stream_t *hs, htsbuf_queue_t *q);
+
+int http_stream_end(http_stream_t *hs);
+
 void http_redirect(http_connection_t *hc, const char *location,
                    struct http_arg_list *req_args, int external);
 
@@ -363,6 +383,7 @@ struct http_client {
   int          hc_port;
   char        *hc_bindaddr;
   tvhpoll_t   *hc_efd;
+  struct http_client_thread *hc_thread;
   int          hc_pevents;
   int          hc_pevents_pause;
 
@@ -396,6 +417,7 @@ struct http_client {
   char        *hc_location;
   uint8_t      hc_running;	/* outside hc_mutex */
   uint8_t      hc_shutdown_wait;/* outside hc_mutex */
+  uint8_t      hc_registered;   /* outside hc_mutex */
   int          hc_refcnt;       /* callback protection - outside hc_mutex */
   int          hc_redirects;
   int          hc_result;
@@ -82,13 +82,31 @@ http_client_testsuite_run( void );
 
 /*
  * Global state
+ *
+ * The registered clients are spread across the data threads. The poll
+ * events carry the client pointer, the closed clients are released by
+ * the owning thread when it enters the next poll wait, so an event
+ * returned before the close never refers to the freed memory.
  */
+typedef struct http_client_thread {
+  pthread_t                 tid;
+  tvhpoll_t                *poll;
+  th_pipe_t                 pipe;
+  tvh_mutex_t               lock;
+  tvh_cond_t                cond;
+  TAILQ_HEAD(,http_client)  clients;
+  TAILQ_HEAD(,http_client)  dead;
+  int                       count;
+} http_client_thread_t;
+
 static int                      http_running;
-static tvhpoll_t               *http_poll;
-static TAILQ_HEAD(,http_client) http_clients;
-static tvh_mutex_t          http_lock;
-static tvh_cond_t               http_cond;
-static th_pipe_t                http_pipe;
+static http_client_thread_t    *http_threads;
+static int                      http_threads_count;
+
+static inline int http_threads_safe_count(void)
+{
+  return MINMAX(config.http_client_threads, 1, 64);
+}
 
 /*
  *
@@ -181,11 +199,11 @@ http_client_shutdown ( http_client_t *hc, int force, int reconnect )
   }
   if (hc->hc_efd) {
     tvhpoll_rem1(hc->hc_efd, hc->hc_fd);
-    if (hc->hc_efd == http_poll && !reconnect) {
-      tvh_mutex_lock(&http_lock);
-      TAILQ_REMOVE(&http_clients, hc, hc_link);
+    if (hc->hc_thread && !reconnect) {
+      tvh_mutex_lock(&hc->hc_thread->lock);
+      hc->hc_registered = 0;
       hc->hc_efd = NULL;
-      tvh_mutex_unlock(&http_lock);
+      tvh_mutex_unlock(&hc->hc_thread->lock);
     } else {
       hc->hc_efd  = NULL;
     }
@@ -1414,50 +1432,64 @@ http_client_ssl_peer_verify( http_client_t *hc, int verify )
 /*
  * Data thread
  */
+static void
+http_client_thread_reap ( http_client_thread_t *ht )
+{
+  http_client_t *hc;
+
+  tvh_mutex_lock(&ht->lock);
+  while ((hc = TAILQ_FIRST(&ht->dead)) != NULL) {
+    TAILQ_REMOVE(&ht->dead, hc, hc_link);
+    free(hc);
+  }
+  tvh_mutex_unlock(&ht->lock);
+}
+
 static void *
 http_client_thread ( void *p )
 {
+  http_client_thread_t *ht = p;
   int n;
   tvhpoll_event_t ev;
   http_client_t *hc;
   char c;
 
   while (atomic_get(&http_running)) {
-    n = tvhpoll_wait(http_poll, &ev, 1, -1);
+    if (!TAILQ_EMPTY(&ht->dead))
+      http_client_thread_reap(ht);
+    n = tvhpoll_wait(ht->poll, &ev, 1, -1);
     if (n < 0) {
       if (atomic_get(&http_running) && !ERRNO_AGAIN(errno))
         tvherror(LS_HTTPC, "tvhpoll_wait() error");
     } else if (n > 0) {
-      if (&http_pipe == ev.ptr) {
-        if (read(http_pipe.rd, &c, 1) == 1) {
+      if (&ht->pipe == ev.ptr) {
+        if (read(ht->pipe.rd, &c, 1) == 1 && c == 'q') {
           /* end-of-task */
           break;
         }
         continue;
       }
-      tvh_mutex_lock(&http_lock);
-      TAILQ_FOREACH(hc, &http_clients, hc_link)
-        if (hc == ev.ptr)
-          break;
-      if (hc == NULL) {
-        tvh_mutex_unlock(&http_lock);
+      hc = ev.ptr;
+      tvh_mutex_lock(&ht->lock);
+      if (!hc->hc_registered) {
+        tvh_mutex_unlock(&ht->lock);
         continue;
       }
       if (hc->hc_shutdown_wait) {
-        tvh_cond_signal(&http_cond, 1);
+        tvh_cond_signal(&ht->cond, 1);
         /* Disable the poll looping for this moment */
         http_client_poll_dir(hc, 0, 0);
-        tvh_mutex_unlock(&http_lock);
+        tvh_mutex_unlock(&ht->lock);
         continue;
       }
       hc->hc_running = 1;
-      tvh_mutex_unlock(&http_lock);
+      tvh_mutex_unlock(&ht->lock);
       http_client_run(hc);
-      tvh_mutex_lock(&http_lock);
+      tvh_mutex_lock(&ht->lock);
       hc->hc_running = 0;
       if (hc->hc_shutdown_wait)
-        tvh_cond_signal(&http_cond, 1);
-      tvh_mutex_unlock(&http_lock);
+        tvh_cond_signal(&ht->cond, 1);
+      tvh_mutex_unlock(&ht->lock);
     }
   }
 
@@ -1606,16 +1638,28 @@ http_client_connect
 void
 http_client_register( http_client_t *hc )
 {
+  http_client_thread_t *ht;
+  int i;
+
   assert(hc->hc_data_received || hc->hc_conn_closed || hc->hc_data_complete);
   assert(hc->hc_efd == NULL);
-  
-  tvh_mutex_lock(&http_lock);
 
-  TAILQ_INSERT_TAIL(&http_clients, hc, hc_link);
+  /* the least loaded thread */
+  ht = http_threads;
+  for (i = 1; i < http_threads_count; i++)
+    if (atomic_get(&http_threads[i].count) < atomic_get(&ht->count))
+      ht = &http_threads[i];
+
+  tvh_mutex_lock(&ht->lock);
 
-  hc->hc_efd  = http_poll;
+  TAILQ_INSERT_TAIL(&ht->clients, hc, hc_link);
+  atomic_add(&ht->count, 1);
 
-  tvh_mutex_unlock(&http_lock);
+  hc->hc_thread = ht;
+  hc->hc_efd  = ht->poll;
+  hc->hc_registered = 1;
+
+  tvh_mutex_unlock(&ht->lock);
 }
 
 /*
@@ -1627,22 +1671,25 @@ http_client_register( http_client_t *hc )
 void
 http_client_close ( http_client_t *hc )
 {
+  http_client_thread_t *ht;
   http_client_wcmd_t *wcmd;
 
   if (hc == NULL)
     return;
 
-  if (hc->hc_efd == http_poll) { /* http_client_thread */
-    tvh_mutex_lock(&http_lock);
+  if ((ht = hc->hc_thread) != NULL) { /* http_client_thread */
+    tvh_mutex_lock(&ht->lock);
     hc->hc_shutdown_wait = 1;
     while (hc->hc_running)
-      tvh_cond_wait(&http_cond, &http_lock);
-    if (hc->hc_efd) {
+      tvh_cond_wait(&ht->cond, &ht->lock);
+    if (hc->hc_registered) {
       tvhpoll_rem1(hc->hc_efd, hc->hc_fd);
-      TAILQ_REMOVE(&http_clients, hc, hc_link);
+      hc->hc_registered = 0;
       hc->hc_efd = NULL;
     }
-    tvh_mutex_unlock(&http_lock);
+    TAILQ_REMOVE(&ht->clients, hc, hc_link);
+    atomic_dec(&ht->count, 1);
+    tvh_mutex_unlock(&ht->lock);
   }
   tvh_mutex_lock(&hc->hc_mutex);
   while (http_client_busy(hc)) {
@@ -1668,38 +1715,42 @@ http_client_close ( http_client_t *hc )
   free(hc->hc_bindaddr);
   free(hc->hc_rtsp_user);
   free(hc->hc_rtsp_pass);
-#ifdef CLANG_SANITIZER
-  tvh_mutex_lock(&http_lock);
-#endif
-  free(hc);
-#ifdef CLANG_SANITIZER
-  tvh_mutex_unlock(&http_lock);
-#endif
+  if (ht) {
+    /* released by the owning thread before the next poll wait */
+    tvh_mutex_lock(&ht->lock);
+    TAILQ_INSERT_TAIL(&ht->dead, hc, hc_link);
+    tvh_mutex_unlock(&ht->lock);
+    tvh_write(ht->pipe.wr, "w", 1);
+  } else {
+    free(hc);
+  }
 }
 
 /*
  * Initialise subsystem
  */
-pthread_t http_client_tid;
-
 void
 http_client_init ( void )
 {
-  /* Setup list */
-  tvh_mutex_init(&http_lock, NULL);
-  tvh_cond_init(&http_cond, 1);
-  TAILQ_INIT(&http_clients);
-
-  /* Setup pipe */
-  tvh_pipe(O_NONBLOCK, &http_pipe);
+  http_client_thread_t *ht;
+  int i;
 
-  /* Setup poll */
-  http_poll   = tvhpoll_create(10);
-  tvhpoll_add1(http_poll, http_pipe.rd, TVHPOLL_IN, &http_pipe);
+  http_threads_count = http_threads_safe_count();
+  http_threads = calloc(http_threads_count, sizeof(*http_threads));
 
-  /* Setup thread */
   atomic_set(&http_running, 1);
-  tvh_thread_create(&http_client_tid, NULL, http_client_thread, NULL, "httpc");
+  for (i = 0; i < http_threads_count; i++) {
+    ht = &http_threads[i];
+    tvh_mutex_init(&ht->lock, NULL);
+    tvh_cond_init(&ht->cond, 1);
+    TAILQ_INIT(&ht->clients);
+    TAILQ_INIT(&ht->dead);
+    tvh_pipe(O_NONBLOCK, &ht->pipe);
+    ht->poll = tvhpoll_create(10);
+    tvhpoll_add1(ht->poll, ht->pipe.rd, TVHPOLL_IN, &ht->pipe);
+    tvh_thread_create(&ht->tid, NULL, http_client_thread, ht, "httpc");
+  }
+  tvhinfo(LS_HTTPC, "Using %d client thread(s)", http_threads_count);
 #if HTTPCLIENT_TESTSUITE
   http_client_testsuite_run();
 #endif
@@ -1708,19 +1759,32 @@ http_client_init ( void )
 void
 http_client_done ( void )
 {
+  http_client_thread_t *ht;
   http_client_t *hc;
+  int i;
 
   atomic_set(&http_running, 0);
-  tvh_write(http_pipe.wr, "", 1);
-  pthread_join(http_client_tid, NULL);
-  tvh_pipe_close(&http_pipe);
-  tvh_mutex_lock(&http_lock);
-  TAILQ_FOREACH(hc, &http_clients, hc_link)
-    if (hc->hc_efd == http_poll)
+  for (i = 0; i < http_threads_count; i++) {
+    ht = &http_threads[i];
+    tvh_write(ht->pipe.wr, "q", 1);
+    pthread_join(ht->tid, NULL);
+    http_client_thread_reap(ht);
+    tvh_pipe_close(&ht->pipe);
+    tvh_mutex_lock(&ht->lock);
+    TAILQ_FOREACH(hc, &ht->clients, hc_link) {
+      hc->hc_thread = NULL;
+      hc->hc_registered = 0;
       hc->hc_efd = NULL;
-  tvhpoll_destroy(http_poll);
-  http_poll = NULL;
-  tvh_mutex_unlock(&http_lock);
+    }
+    tvhpoll_destroy(ht->poll);
+    ht->poll = NULL;
+    tvh_mutex_unlock(&ht->lock);
+    tvh_cond_destroy(&ht->cond);
+    tvh_mutex_destroy(&ht->lock);
+  }
+  free(http_threads);
+  http_threads = NULL;
+  http_threads_count = 0;
 }
 
 /*
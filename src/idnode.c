@@ -30,6 +30,8 @@
 #include "settings.h"
 #include "uuid.h"
 #include "access.h"
+#include "memoryinfo.h"
+#include "tprofile.h"
 
 static const idnodes_rb_t * idnode_domain ( const idclass_t *idc );
 static idnodes_rb_t * idclass_find_domain ( const idclass_t *idc );
@@ -51,6 +53,13 @@ static tvh_cond_t save_cond;
 static pthread_t  save_tid;
 static int        save_running;
 static mtimer_t   save_timer;
+static int        save_queued;
+static tprofile_t save_profile;
+static qprofile_t save_qprofile;
+
+memoryinfo_t idnode_save_memoryinfo = { .my_name = "Idnode save queue" };
+
+#define IDNODE_SAVE_BATCH 256
 
 static tvh_mutex_t idnode_lnotify_mutex = TVH_THREAD_MUTEX_INITIALIZER;
 static tvh_uuid_set_t  idnode_lnotify_set;
@@ -356,11 +365,10 @@ idnode_get_display
 /*
  * Get field as string
  */
-const char *
-idnode_get_str
-  ( idnode_t *self, const char *key )
+static const char *
+idnode_prop_get_str
+  ( idnode_t *self, const property_t *p )
 {
-  const property_t *p = idnode_find_prop(self, key);
   if (p && p->type == PT_STR) {
     const void *ptr;
     if (p->get)
@@ -373,14 +381,20 @@ idnode_get_str
   return NULL;
 }
 
+const char *
+idnode_get_str
+  ( idnode_t *self, const char *key )
+{
+  return idnode_prop_get_str(self, idnode_find_prop(self, key));
+}
+
 /*
  * Get field as unsigned int
  */
-int
-idnode_get_u32
-  ( idnode_t *self, const char *key, uint32_t *u32 )
+static int
+idnode_prop_get_u32
+  ( idnode_t *self, const property_t *p, uint32_t *u32 )
 {
-  const property_t *p = idnode_find_prop(self, key);
   if (p) {
     const void *ptr;
     if (p->islist)
@@ -407,14 +421,20 @@ idnode_get_u32
   return 1;
 }
 
+int
+idnode_get_u32
+  ( idnode_t *self, const char *key, uint32_t *u32 )
+{
+  return idnode_prop_get_u32(self, idnode_find_prop(self, key), u32);
+}
+
 /*
  * Get field as signed 64-bit int
  */
-int
-idnode_get_s64
-  ( idnode_t *self, const char *key, int64_t *s64 )
+static int
+idnode_prop_get_s64
+  ( idnode_t *self, const property_t *p, int64_t *s64 )
 {
-  const property_t *p = idnode_find_prop(self, key);
   if (p) {
     const void *ptr;
     if (p->islist)
@@ -450,14 +470,20 @@ idnode_get_s64
   return 1;
 }
 
+int
+idnode_get_s64
+  ( idnode_t *self, const char *key, int64_t *s64 )
+{
+  return idnode_prop_get_s64(self, idnode_find_prop(self, key), s64);
+}
+
 /*
  * Get field as signed 64-bit int
  */
-int
-idnode_get_s64_atomic
-  ( idnode_t *self, const char *key, int64_t *s64 )
+static int
+idnode_prop_get_s64_atomic
+  ( idnode_t *self, const property_t *p, int64_t *s64 )
 {
-  const property_t *p = idnode_find_prop(self, key);
   if (p) {
     const void *ptr;
     if (p->islist)
@@ -477,14 +503,20 @@ idnode_get_s64_atomic
   return 1;
 }
 
+int
+idnode_get_s64_atomic
+  ( idnode_t *self, const char *key, int64_t *s64 )
+{
+  return idnode_prop_get_s64_atomic(self, idnode_find_prop(self, key), s64);
+}
+
 /*
  * Get field as double
  */
-int
-idnode_get_dbl
-  ( idnode_t *self, const char *key, double *dbl )
+static int
+idnode_prop_get_dbl
+  ( idnode_t *self, const property_t *p, double *dbl )
 {
-  const property_t *p = idnode_find_prop(self, key);
   if (p) {
     const void *ptr;
     if (p->islist)
@@ -520,6 +552,13 @@ idnode_get_dbl
   return 1;
 }
 
+int
+idnode_get_dbl
+  ( idnode_t *self, const char *key, double *dbl )
+{
+  return idnode_prop_get_dbl(self, idnode_find_prop(self, key), dbl);
+}
+
 /*
  * Get field as BOOL
  */
@@ -550,11 +589,10 @@ idnode_get_bool
 /*
  * Get field as time
  */
-int
-idnode_get_time
-  ( idnode_t *self, const char *key, time_t *tm )
+static int
+idnode_prop_get_time
+  ( idnode_t *self, const property_t *p, time_t *tm )
 {
-  const property_t *p = idnode_find_prop(self, key);
   if (p) {
     const void *ptr;
     if (p->islist)
@@ -574,6 +612,13 @@ idnode_get_time
   return 1;
 }
 
+int
+idnode_get_time
+  ( idnode_t *self, const char *key, time_t *tm )
+{
+  return idnode_prop_get_time(self, idnode_find_prop(self, key), tm);
+}
+
 /* **************************************************************************
  * Lookup
  * *************************************************************************/
@@ -723,118 +768,285 @@ idnode_cmp_title
 
 #define safecmp(a, b) ((a) > (b) ? 1 : ((a) < (b) ? -1 : 0))
 
-static int
-idnode_cmp_sort
-  ( const void *a, const void *b, void *s )
-{
-  idnode_t      *ina  = *(idnode_t**)a;
-  idnode_t      *inb  = *(idnode_t**)b;
-  idnode_sort_t *sort = s;
-  const property_t *p = idnode_find_prop(ina, sort->key);
-  if (!p) return 0;
-
-  /* Get display string */
-  if (p->islist || (p->list && !(p->opts & PO_SORTKEY))) {
-    int r;
-    char *stra = idnode_get_display(ina, p, sort->lang);
-    char *strb = idnode_get_display(inb, p, sort->lang);
-    if (sort->dir == IS_ASC)
-      r = strcmp(stra ?: "", strb ?: "");
-    else
-      r = strcmp(strb ?: "", stra ?: "");
-    free(stra);
-    free(strb);
-    return r;
+/*
+ * Property lookup cache, the nodes in one set share mostly one class
+ */
+static inline const property_t *
+idnode_find_prop_cached
+  ( idnode_t *in, const char *key,
+    const idclass_t **cls, const property_t **prop )
+{
+  if (*cls != in->in_class) {
+    *cls = in->in_class;
+    *prop = idnode_find_prop(in, key);
   }
+  return *prop;
+}
 
+/*
+ * Sort keys, the values are extracted once per node
+ */
+typedef struct idnode_sort_key {
+  idnode_t      *in;
+  tvh_uuid_t     uuid;
+  union {
+    int64_t      s64;
+    double       dbl;
+    char        *str;
+  } u;
+} idnode_sort_key_t;
+
+struct idnode_sort_keys {
+  idnode_sort_key_t *keys;
+  size_t             count;
+  size_t             sorted;     ///< The first entries in the final order
+  int                dir;
+  enum {
+    ISK_NONE,
+    ISK_STR,
+    ISK_S64,
+    ISK_DBL
+  }                  type;
+};
+
+static int
+idnode_sort_key_type ( const property_t *p )
+{
+  if (p == NULL)
+    return ISK_NONE;
+  if (p->islist || (p->list && !(p->opts & PO_SORTKEY)))
+    return ISK_STR;
   switch (p->type) {
     case PT_STR:
-      {
-        int r;
-        const char *stra = tvh_strdupa(idnode_get_str(ina, sort->key) ?: "");
-        const char *strb = idnode_get_str(inb, sort->key) ?: "";
-        if (sort->dir == IS_ASC)
-          r = strcmp(stra, strb);
-        else
-          r = strcmp(strb, stra);
-        return r;
-      }
-      break;
+      return ISK_STR;
     case PT_INT:
     case PT_U16:
     case PT_BOOL:
     case PT_PERM:
-      {
-        int32_t i32a = 0, i32b = 0;
-        idnode_get_u32(ina, sort->key, (uint32_t *)&i32a);
-        idnode_get_u32(inb, sort->key, (uint32_t *)&i32b);
-        if (sort->dir == IS_ASC)
-          return safecmp(i32a, i32b);
-        else
-          return safecmp(i32b, i32a);
-      }
-      break;
     case PT_U32:
-      {
-        uint32_t u32a = 0, u32b = 0;
-        idnode_get_u32(ina, sort->key, &u32a);
-        idnode_get_u32(inb, sort->key, &u32b);
-        if (sort->dir == IS_ASC)
-          return safecmp(u32a, u32b);
-        else
-          return safecmp(u32b, u32a);
-      }
-      break;
     case PT_S64:
-      {
-        int64_t s64a = 0, s64b = 0;
-        idnode_get_s64(ina, sort->key, &s64a);
-        idnode_get_s64(inb, sort->key, &s64b);
-        if (sort->dir == IS_ASC)
-          return safecmp(s64a, s64b);
-        else
-          return safecmp(s64b, s64a);
-      }
-      break;
     case PT_S64_ATOMIC:
-      {
-        int64_t s64a = 0, s64b = 0;
-        idnode_get_s64_atomic(ina, sort->key, &s64a);
-        idnode_get_s64_atomic(inb, sort->key, &s64b);
-        if (sort->dir == IS_ASC)
-          return safecmp(s64a, s64b);
-        else
-          return safecmp(s64b, s64a);
-      }
-      break;
-    case PT_DBL:
-      {
-        double dbla = 0, dblb = 0;
-        idnode_get_dbl(ina, sort->key, &dbla);
-        idnode_get_dbl(inb, sort->key, &dblb);
-        if (sort->dir == IS_ASC)
-          return safecmp(dbla, dblb);
-        else
-          return safecmp(dblb, dbla);
-      }
-      break;
     case PT_TIME:
-      {
-        time_t ta = 0, tb = 0;
-        idnode_get_time(ina, sort->key, &ta);
-        idnode_get_time(inb, sort->key, &tb);
-        if (sort->dir == IS_ASC)
-          return safecmp(ta, tb);
-        else
-          return safecmp(tb, ta);
-      }
-      break;
+      return ISK_S64;
+    case PT_DBL:
+      return ISK_DBL;
     case PT_LANGSTR:
       // TODO?
     case PT_NONE:
       break;
   }
-  return 0;
+  return ISK_NONE;
+}
+
+static void
+idnode_sort_key_get
+  ( idnode_sort_keys_t *sk, idnode_sort_key_t *k,
+    const property_t *p, const char *lang )
+{
+  idnode_t *in = k->in;
+  uint32_t u32 = 0;
+  int64_t s64 = 0;
+  double dbl = 0;
+  time_t t = 0;
+
+  if (p == NULL || idnode_sort_key_type(p) != sk->type)
+    p = NULL;
+  switch (sk->type) {
+    case ISK_STR:
+      if (p && (p->islist || (p->list && !(p->opts & PO_SORTKEY))))
+        k->u.str = idnode_get_display(in, p, lang);
+      else
+        k->u.str = strdup(idnode_prop_get_str(in, p) ?: "");
+      break;
+    case ISK_S64:
+      if (p) {
+        switch (p->type) {
+          case PT_U32:
+            idnode_prop_get_u32(in, p, &u32);
+            s64 = u32;
+            break;
+          case PT_S64:
+            idnode_prop_get_s64(in, p, &s64);
+            break;
+          case PT_S64_ATOMIC:
+            idnode_prop_get_s64_atomic(in, p, &s64);
+            break;
+          case PT_TIME:
+            idnode_prop_get_time(in, p, &t);
+            s64 = t;
+            break;
+          default:
+            idnode_prop_get_u32(in, p, &u32);
+            s64 = (int32_t)u32;
+            break;
+        }
+      }
+      k->u.s64 = s64;
+      break;
+    case ISK_DBL:
+      if (p)
+        idnode_prop_get_dbl(in, p, &dbl);
+      k->u.dbl = dbl;
+      break;
+    case ISK_NONE:
+      break;
+  }
+}
+
+static int
+idnode_sort_key_cmp
+  ( const void *a, const void *b, void *s )
+{
+  const idnode_sort_key_t *ka = a, *kb = b;
+  idnode_sort_keys_t *sk = s;
+  int r;
+
+  switch (sk->type) {
+    case ISK_STR:
+      r = strcmp(ka->u.str ?: "", kb->u.str ?: "");
+      break;
+    case ISK_S64:
+      r = safecmp(ka->u.s64, kb->u.s64);
+      break;
+    case ISK_DBL:
+      r = safecmp(ka->u.dbl, kb->u.dbl);
+      break;
+    default:
+      return 0;
+  }
+  if (r == 0) /* total order, the pages must not overlap */
+    return uuid_cmp(&ka->uuid, &kb->uuid);
+  return sk->dir == IS_ASC ? r : -r;
+}
+
+/*
+ * Move the count smallest keys to the front (three-way quickselect)
+ */
+static void
+idnode_sort_keys_select
+  ( idnode_sort_keys_t *sk, size_t lo, size_t hi, size_t count )
+{
+  idnode_sort_key_t *a = sk->keys, pivot, tmp;
+  size_t lt, gt, i;
+  int c;
+
+  while (hi - lo > 1) {
+    pivot = a[lo + (hi - lo) / 2];
+    lt = i = lo;
+    gt = hi;
+    while (i < gt) {
+      c = idnode_sort_key_cmp(&a[i], &pivot, sk);
+      if (c < 0) {
+        tmp = a[lt]; a[lt++] = a[i]; a[i++] = tmp;
+      } else if (c > 0) {
+        tmp = a[--gt]; a[gt] = a[i]; a[i] = tmp;
+      } else {
+        i++;
+      }
+    }
+    if (count <= lt)
+      hi = lt;
+    else if (count <= gt)
+      break;
+    else
+      lo = gt;
+  }
+}
+
+/*
+ * Extract the sort keys (global_lock must be held)
+ */
+idnode_sort_keys_t *
+idnode_sort_keys_create
+  ( idnode_set_t *is, idnode_sort_t *sort )
+{
+  idnode_sort_keys_t *sk = calloc(1, sizeof(*sk));
+  const idclass_t *cls = NULL;
+  const property_t *p = NULL;
+  idnode_sort_key_t *k;
+  size_t i;
+
+  sk->dir = sort->dir;
+  sk->count = is->is_count;
+  sk->keys = malloc(MAX(1, sk->count) * sizeof(idnode_sort_key_t));
+  sk->type = ISK_NONE;
+  for (i = 0; sort->key && i < sk->count && sk->type == ISK_NONE; i++)
+    sk->type = idnode_sort_key_type(
+                 idnode_find_prop_cached(is->is_array[i], sort->key, &cls, &p));
+  for (i = 0, k = sk->keys; i < sk->count; i++, k++) {
+    k->in = is->is_array[i];
+    k->uuid = k->in->in_uuid;
+    k->u.str = NULL;
+    if (sk->type != ISK_NONE)
+      idnode_sort_key_get(sk, k,
+                          idnode_find_prop_cached(k->in, sort->key, &cls, &p),
+                          sort->lang);
+  }
+  if (sk->type == ISK_NONE)
+    sk->sorted = sk->count;
+  return sk;
+}
+
+/*
+ * Sort the first count entries, the keys do not reference the nodes,
+ * so global_lock is not required here
+ */
+void
+idnode_sort_keys_sort
+  ( idnode_sort_keys_t *sk, size_t count )
+{
+  size_t lo = sk->sorted;
+
+  if (count > sk->count)
+    count = sk->count;
+  if (count <= lo)
+    return;
+  if (count < sk->count)
+    idnode_sort_keys_select(sk, lo, sk->count, count);
+  tvh_qsort_r(sk->keys + lo, count - lo, sizeof(idnode_sort_key_t),
+              idnode_sort_key_cmp, sk);
+  sk->sorted = count;
+}
+
+size_t
+idnode_sort_keys_count ( idnode_sort_keys_t *sk )
+{
+  return sk->count;
+}
+
+/*
+ * Return the node at the sorted position, when lookup is set the node is
+ * verified using the uuid (the node might be removed when the lock was
+ * released), returns NULL in this case
+ */
+idnode_t *
+idnode_sort_keys_get
+  ( idnode_sort_keys_t *sk, size_t i, int lookup )
+{
+  idnode_sort_key_t *k;
+
+  if (i >= sk->count)
+    return NULL;
+  if (i >= sk->sorted)
+    idnode_sort_keys_sort(sk, MAX(i + 1, MIN(sk->count, sk->sorted * 2)));
+  k = &sk->keys[i];
+  if (lookup && idnode_find0(&k->uuid, NULL, NULL) != k->in)
+    return NULL;
+  return k->in;
+}
+
+void
+idnode_sort_keys_destroy ( idnode_sort_keys_t *sk )
+{
+  size_t i;
+
+  if (sk == NULL)
+    return;
+  if (sk->type == ISK_STR)
+    for (i = 0; i < sk->count; i++)
+      free(sk->keys[i].u.str);
+  free(sk->keys);
+  free(sk);
 }
 
 static void
@@ -867,17 +1079,19 @@ idnode_filter
   ( idnode_t *in, idnode_filter_t *filter, const char *lang )
 {
   idnode_filter_ele_t *f;
-  
+  const property_t *p;
+
   LIST_FOREACH(f, filter, link) {
     if (!f->checked)
       idnode_filter_init(in, filter);
+    p = idnode_find_prop_cached(in, f->key, &f->cls, &f->prop);
     if (f->type == IF_STR) {
       const char *str;
       char *strdisp;
       int r = 1;
-      str = strdisp = idnode_get_display(in, idnode_find_prop(in, f->key), lang);
+      str = strdisp = idnode_get_display(in, p, lang);
       if (!str)
-        if (!(str = idnode_get_str(in, f->key)))
+        if (!(str = idnode_prop_get_str(in, p)))
           return 1;
       switch(f->comp) {
         case IC_IN: r = strstr(str, f->u.s) == NULL; break;
@@ -892,7 +1106,7 @@ idnode_filter
         return r;
     } else if (f->type == IF_NUM || f->type == IF_BOOL) {
       int64_t a, b;
-      if (idnode_get_s64(in, f->key, &a))
+      if (idnode_prop_get_s64(in, p, &a))
         return 1;
       b = (f->type == IF_NUM) ? f->u.n.n : f->u.b;
       switch (f->comp) {
@@ -914,7 +1128,7 @@ idnode_filter
       }
     } else if (f->type == IF_DBL) {
       double a, b;
-      if (idnode_get_dbl(in, f->key, &a))
+      if (idnode_prop_get_dbl(in, p, &a))
         return 1;
       b = f->u.dbl;
       switch (f->comp) {
@@ -1090,7 +1304,13 @@ void
 idnode_set_sort
   ( idnode_set_t *is, idnode_sort_t *sort )
 {
-  tvh_qsort_r(is->is_array, is->is_count, sizeof(idnode_t*), idnode_cmp_sort, (void*)sort);
+  idnode_sort_keys_t *sk = idnode_sort_keys_create(is, sort);
+  size_t i;
+
+  idnode_sort_keys_sort(sk, sk->count);
+  for (i = 0; i < sk->count; i++)
+    is->is_array[i] = sk->keys[i].in;
+  idnode_sort_keys_destroy(sk);
 }
 
 void
@@ -1200,6 +1420,17 @@ idnode_save_queue ( idnode_t *self )
     mtimer_arm_rel(&save_timer, idnode_save_trigger_thread_cb, NULL, IDNODE_SAVE_DELAY);
   TAILQ_INSERT_TAIL(&idnodes_save, ise, ise_link);
   self->in_save = ise;
+  save_queued++;
+  memoryinfo_alloc(&idnode_save_memoryinfo, sizeof(*ise));
+}
+
+static void
+idnode_save_dequeue ( idnode_save_t *ise )
+{
+  TAILQ_REMOVE(&idnodes_save, ise, ise_link);
+  save_queued--;
+  memoryinfo_free(&idnode_save_memoryinfo, sizeof(*ise));
+  free(ise);
 }
 
 void
@@ -1211,8 +1442,7 @@ idnode_save_check ( idnode_t *self, int weak )
   if (self->in_save == NULL || self->in_save == SAVEPTR_OUTOFSERVICE)
     return;
 
-  TAILQ_REMOVE(&idnodes_save, self->in_save, ise_link);
-  free(self->in_save);
+  idnode_save_dequeue(self->in_save);
   self->in_save = SAVEPTR_OUTOFSERVICE;
 
   if (weak)
@@ -1936,15 +2166,66 @@ idnode_notify_title_changed_lang (void *in, const char *lang)
  * Save thread
  * *************************************************************************/
 
+/*
+ * Take the snapshots of the due nodes (all with force) and write them
+ * as one batch, the global lock is released while writing
+ */
+static void
+save_thread_batch ( int force )
+{
+  idnode_save_t *ise;
+  htsmsg_t *m, *records[IDNODE_SAVE_BATCH];
+  char *paths[IDNODE_SAVE_BATCH];
+  char filename[PATH_MAX];
+  int64_t now = mclk(), reqtime = 0, t0, t1, t2;
+  int i, nodes = 0, count = 0, queued = save_queued;
+
+  t0 = getfastmonoclock();
+  while (nodes < IDNODE_SAVE_BATCH && (ise = TAILQ_FIRST(&idnodes_save)) != NULL) {
+    if (!force && ise->ise_reqtime + IDNODE_SAVE_DELAY > now)
+      break;
+    if (nodes++ == 0)
+      reqtime = ise->ise_reqtime;
+    m = idnode_savefn(ise->ise_node, filename, sizeof(filename));
+    ise->ise_node->in_save = NULL;
+    idnode_save_dequeue(ise);
+    if (m) {
+      records[count] = m;
+      paths[count++] = strdup(filename);
+    }
+  }
+  if (count)
+    hts_settings_save_begin();
+  tvh_mutex_unlock(&global_lock);
+
+  t1 = getfastmonoclock();
+  tprofile_queue_set(&save_qprofile, "save", queued);
+  if (count) {
+    tprofile_start(&save_profile, "save");
+    hts_settings_save_batch(records, paths, count);
+    tprofile_finish(&save_profile);
+  }
+  for (i = 0; i < count; i++) {
+    htsmsg_destroy(records[i]);
+    free(paths[i]);
+  }
+  t2 = getfastmonoclock();
+  if (nodes)
+    tvhdebug(LS_IDNODE, "saved %d of %d queued nodes in %"PRId64" ms "
+                        "(snapshot %"PRId64" ms), waited %"PRId64" ms",
+             nodes, queued, mono2ms(t2 - t0), mono2ms(t1 - t0),
+             mono2ms(now - reqtime));
+
+  tvh_mutex_lock(&global_lock);
+}
+
 static void *
 save_thread ( void *aux )
 {
   idnode_save_t *ise;
   idnode_t *in;
-  htsmsg_t *m;
   uint32_t u32;
   tvh_uuid_t *uuid;
-  char filename[PATH_MAX];
   tvh_uuid_set_t set, tset;
   int lnotify;
 
@@ -1970,18 +2251,8 @@ save_thread ( void *aux )
       tvh_cond_wait(&save_cond, &global_lock);
       continue;
     }
-    if (ise) {
-      m = idnode_savefn(ise->ise_node, filename, sizeof(filename));
-      ise->ise_node->in_save = NULL;
-      TAILQ_REMOVE(&idnodes_save, ise, ise_link);
-      tvh_mutex_unlock(&global_lock);
-      free(ise);
-      if (m) {
-        hts_settings_save(m, "%s", filename);
-        htsmsg_destroy(m);
-      }
-      tvh_mutex_lock(&global_lock);
-    }
+    if (ise)
+      save_thread_batch(0);
 lnotifygo:
     tvh_mutex_lock(&idnode_lnotify_mutex);
     if (!uuid_set_empty(&idnode_lnotify_set)) {
@@ -2013,18 +2284,8 @@ lnotifygo:
 
   mtimer_disarm(&save_timer);
 
-  while ((ise = TAILQ_FIRST(&idnodes_save)) != NULL) {
-    m = idnode_savefn(ise->ise_node, filename, sizeof(filename));
-    ise->ise_node->in_save = NULL;
-    TAILQ_REMOVE(&idnodes_save, ise, ise_link);
-    tvh_mutex_unlock(&global_lock);
-    free(ise);
-    if (m) {
-      hts_settings_save(m, "%s", filename);
-      htsmsg_destroy(m);
-    }
-    tvh_mutex_lock(&global_lock);
-  }
+  while (!TAILQ_EMPTY(&idnodes_save))
+    save_thread_batch(1);
 
   tvh_mutex_unlock(&global_lock);
   return NULL;
@@ -2070,6 +2331,8 @@ idnode_boot(void)
 void
 idnode_init(void)
 {
+  tprofile_init(&save_profile, "idnode save");
+  tprofile_queue_init(&save_qprofile, "idnode save queue");
   atomic_set(&save_running, 1);
   tvh_thread_create(&save_tid, NULL, save_thread, NULL, "save");
 }
@@ -2084,6 +2347,8 @@ idnode_done(void)
   tvh_cond_signal(&save_cond, 0);
   tvh_mutex_unlock(&global_lock);
   pthread_join(save_tid, NULL);
+  tprofile_queue_done(&save_qprofile);
+  tprofile_done(&save_profile);
 
   tvh_mutex_lock(&global_lock);
 
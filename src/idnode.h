@@ -160,6 +160,8 @@ typedef struct idnode_sort {
   }           dir;  ///< Sort direction
 } idnode_sort_t;
 
+typedef struct idnode_sort_keys idnode_sort_keys_t;
+
 /*
  * Filter definition
  */
@@ -169,6 +171,8 @@ typedef struct idnode_filter_ele
 
   int checked;
   char *key;                          ///< Filter key
+  const idclass_t *cls;               ///< Class of the cached property
+  const property_t *prop;             ///< Cached property
   enum {
     IF_STR,
     IF_NUM,
@@ -200,6 +204,9 @@ extern idnode_t tvhlog_conf;
 extern const idclass_t tvhlog_conf_class;
 extern tvh_mutex_t idnode_mutex;
 
+struct memoryinfo;
+extern struct memoryinfo idnode_save_memoryinfo;
+
 void idnode_boot(void);
 void idnode_init(void);
 void idnode_done(void);
@@ -325,6 +332,11 @@ static inline int idnode_set_exists ( idnode_set_t *is, idnode_t *in )
 static inline int idnode_set_empty ( idnode_set_t *is )
   { return is->is_count == 0; }
 void idnode_set_sort ( idnode_set_t *is, idnode_sort_t *s );
+idnode_sort_keys_t *idnode_sort_keys_create ( idnode_set_t *is, idnode_sort_t *s );
+void idnode_sort_keys_sort ( idnode_sort_keys_t *sk, size_t count );
+size_t idnode_sort_keys_count ( idnode_sort_keys_t *sk );
+idnode_t *idnode_sort_keys_get ( idnode_sort_keys_t *sk, size_t i, int lookup );
+void idnode_sort_keys_destroy ( idnode_sort_keys_t *sk );
 void idnode_set_sort_by_title ( idnode_set_t *is, const char *lang );
 htsmsg_t *idnode_set_as_htsmsg ( idnode_set_t *is );
 void idnode_set_clear ( idnode_set_t *is );
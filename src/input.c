@@ -147,6 +147,8 @@ tvh_input_stream_create_msg
   htsmsg_add_u32(m, "tc_bit", st->stats.tc_bit);
   htsmsg_add_u32(m, "ec_block", st->stats.ec_block);
   htsmsg_add_u32(m, "tc_block", st->stats.tc_block);
+  htsmsg_add_u32(m, "seg_latency", st->stats.seg_latency);
+  htsmsg_add_u32(m, "seg_depth", st->stats.seg_depth);
   return m;
 }
 
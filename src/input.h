@@ -66,6 +66,9 @@ struct tvh_input_stream_stats
   /* Note: PER = ec_block / tc_block (0...1) */
   int ec_block;  ///< ERROR_BLOCK_COUNT
   int tc_block;  ///< TOTAL_BLOCK_COUNT
+
+  int seg_latency; ///< HLS segment time to first byte (ms)
+  int seg_depth;   ///< HLS segments downloaded ahead of the playback
 };
 
 struct tvh_input_stream {
@@ -1004,6 +1004,8 @@ void mpegts_input_save ( mpegts_input_t *mi, htsmsg_t *c );
 
 void mpegts_input_flush_mux ( mpegts_input_t *mi, mpegts_mux_t *mm );
 
+int mpegts_input_queue_level ( mpegts_input_t *mi );
+
 mpegts_pid_t * mpegts_input_open_pid
   ( mpegts_input_t *mi, mpegts_mux_t *mm, int pid, int type, int weight,
     void *owner, int reopen );
@@ -29,6 +29,72 @@
 #endif
 
 #define HLS_SI_TBL_ANALYZE (4*188)
+#define HLS_LIVE_EDGE      3
+#define HLS_DELIVER_CHUNK  (128*1024)
+#define HLS_SEGMENT_RETRY  2
+#define HLS_KEY_RETRY      3
+
+/*
+ * HLS prefetch - the playlist, the keys and up to hls_prefetch media
+ * segments are fetched in parallel by the fetchers, the segments are
+ * decrypted as the data arrive and passed to the mux in sequence order
+ */
+typedef enum {
+  HLS_JOB_NONE = 0,
+  HLS_JOB_PLAYLIST,
+  HLS_JOB_KEY,
+  HLS_JOB_SEGMENT
+} hls_job_t;
+
+typedef enum {
+  HLS_STATE_PENDING = 0,
+  HLS_STATE_FETCHING,
+  HLS_STATE_DONE,
+  HLS_STATE_FAILED
+} hls_state_t;
+
+typedef struct hls_key {
+  LIST_ENTRY(hls_key) link;
+  char          *url;
+  hls_state_t    state;
+  int            refcnt;
+  int            retries;
+  AES_KEY        key;
+} hls_key_t;
+
+typedef struct hls_segment {
+  TAILQ_ENTRY(hls_segment) link;
+  int64_t        seq;
+  char          *url;
+  hls_key_t     *key;
+  unsigned char  iv[AES_BLOCK_SIZE];
+  hls_state_t    state;
+  int            retries;
+  uint8_t        started;
+  sbuf_t         sbuf;
+  int            rpos;
+} hls_segment_t;
+
+typedef struct hls_fetcher {
+  LIST_ENTRY(hls_fetcher) link;
+  struct http_priv *hp;
+  http_client_t *hc;
+  hls_job_t      job;
+  hls_segment_t *seg;
+  hls_key_t     *key;
+  uint8_t        idle;
+  uint8_t        reconnect;
+  int64_t        start;
+  int64_t        ttfb;
+  sbuf_t         sbuf;
+  sbuf_t         dbuf;
+  struct {
+    char          tmp[AES_BLOCK_SIZE];
+    int           tmp_len;
+    AES_KEY       key;
+    unsigned char iv[AES_BLOCK_SIZE];
+  } aes128;
+} hls_fetcher_t;
 
 typedef struct http_priv {
   iptv_input_t  *mi;
@@ -57,11 +123,32 @@ typedef struct http_priv {
     AES_KEY       key;
     unsigned char iv[AES_BLOCK_SIZE];
   } hls_aes128;
+  /* prefetch */
+  tvh_mutex_t    hls_lock;
+  mtimer_t       hls_timer;
+  uint32_t       hls_prefetch;
+  uint8_t        hls_active;
+  uint8_t        hls_kick;
+  uint8_t        hls_paused;
+  uint8_t        hls_resume;
+  uint8_t        hls_unpause;
+  uint8_t        hls_endlist;
+  uint8_t        hls_reload;
+  uint8_t        hls_reload_busy;
+  int64_t        hls_reload_time;
+  int64_t        hls_seq_next;
+  int            hls_latency;
+  int            hls_fetchers_count;
+  TAILQ_HEAD(, hls_segment) hls_segments;
+  LIST_HEAD(, hls_key) hls_keys;
+  LIST_HEAD(, hls_fetcher) hls_fetchers;
 } http_priv_t;
 
 /***/
 
 static int iptv_http_complete_key ( http_client_t *hc );
+static int iptv_http_hls_start
+  ( http_priv_t *hp, http_client_t *hc, htsmsg_t *m );
 
 /*
  *
@@ -371,6 +458,8 @@ iptv_http_complete
     }
     m = parse_m3u((char *)hp->m3u_sbuf.sb_data, NULL, hp->host_url);
     sbuf_free(&hp->m3u_sbuf);
+    if (hp->hls_prefetch && iptv_http_hls_start(hp, hc, m))
+      return 0;
 url:
     url = iptv_http_get_url(hp, m);
     if (hp->hls_m3u == m)
@@ -462,6 +551,663 @@ iptv_http_complete_key
   return 0;
 }
 
+/*
+ * HLS prefetch
+ */
+static void iptv_http_hls_manage ( void *aux );
+
+static inline void
+iptv_http_hls_kick ( http_priv_t *hp )
+{
+  if (!hp->hls_kick && !hp->shutdown) {
+    hp->hls_kick = 1;
+    mtimer_arm_rel(&hp->hls_timer, iptv_http_hls_manage, hp, 0);
+  }
+}
+
+static void
+iptv_http_hls_key_put ( hls_key_t *key )
+{
+  if (key)
+    key->refcnt--;
+}
+
+static void
+iptv_http_hls_segment_free ( http_priv_t *hp, hls_segment_t *seg )
+{
+  TAILQ_REMOVE(&hp->hls_segments, seg, link);
+  iptv_http_hls_key_put(seg->key);
+  sbuf_free(&seg->sbuf);
+  free(seg->url);
+  free(seg);
+}
+
+/*
+ * Pass the buffered data to the mux in the sequence order,
+ * the hls_lock must be held
+ */
+static void
+iptv_http_hls_deliver ( http_priv_t *hp, int resume )
+{
+  iptv_mux_t *im = hp->im;
+  mpegts_mux_instance_t *mmi;
+  hls_segment_t *seg;
+  int len, depth = 0;
+
+  tvh_mutex_lock(&iptv_lock);
+  if (hp->shutdown)
+    goto end;
+  if (resume && im->mm_iptv_buffer.sb_ptr > 0 &&
+      iptv_input_recv_packets(im, 0) == 1)
+    goto pause;
+  while (!hp->hls_paused &&
+         (seg = TAILQ_FIRST(&hp->hls_segments)) != NULL &&
+         seg->state != HLS_STATE_PENDING) {
+    if (!seg->started) {
+      seg->started = 1;
+      iptv_input_recv_flush(im);
+    }
+    len = MIN(seg->sbuf.sb_ptr - seg->rpos, HLS_DELIVER_CHUNK);
+    if (len > 0) {
+      sbuf_append(&im->mm_iptv_buffer, seg->sbuf.sb_data + seg->rpos, len);
+      seg->rpos += len;
+      if (seg->rpos == seg->sbuf.sb_ptr)
+        seg->rpos = seg->sbuf.sb_ptr = 0;
+      if (iptv_input_recv_packets(im, len) == 1)
+        goto pause;
+      continue;
+    }
+    if (seg->state == HLS_STATE_FETCHING)
+      break;
+    iptv_http_hls_segment_free(hp, seg);
+    iptv_http_hls_kick(hp);
+  }
+  goto stats;
+pause:
+  hp->hls_paused = 1;
+  hp->hls_unpause = 1;
+  iptv_http_hls_kick(hp);
+stats:
+  if ((mmi = im->mm_active) != NULL) {
+    TAILQ_FOREACH(seg, &hp->hls_segments, link)
+      if (seg->state == HLS_STATE_DONE)
+        depth++;
+    tvh_mutex_lock(&mmi->tii_stats_mutex);
+    mmi->tii_stats.seg_latency = hp->hls_latency;
+    mmi->tii_stats.seg_depth = depth;
+    tvh_mutex_unlock(&mmi->tii_stats_mutex);
+  }
+end:
+  tvh_mutex_unlock(&iptv_lock);
+}
+
+/*
+ * Merge the media playlist to the segment queue,
+ * the hls_lock must be held
+ */
+static void
+iptv_http_hls_playlist ( http_priv_t *hp, htsmsg_t *m )
+{
+  htsmsg_t *items, *item, *xkey;
+  htsmsg_field_t *f;
+  hls_segment_t *seg;
+  hls_key_t *key;
+  int64_t seq, target;
+  int n = 0, i = -1, j, added = 0, start;
+  const char *url, *s;
+
+  items = htsmsg_get_list(m, "items");
+  seq = htsmsg_get_s64_or_default(m, "media-sequence", 0);
+  target = htsmsg_get_s64_or_default(m, "targetduration", 10);
+  target = MINMAX(target, 1, 60);
+  hp->hls_endlist = htsmsg_get_bool_or_default(m, "x-endlist", 0);
+
+  if (items)
+    HTSMSG_FOREACH(f, items)
+      if ((item = htsmsg_field_get_map(f)) != NULL &&
+          tvh_str_default(htsmsg_get_str(item, "m3u-url"), NULL))
+        n++;
+
+  if (hp->hls_seq_next < 0 || seq + n < hp->hls_seq_next - n) {
+    start = hp->hls_endlist ? 0 : MAX(0, n - HLS_LIVE_EDGE);
+    if (hp->hls_seq_next >= 0)
+      tvhwarn(LS_IPTV, "HLS - media sequence restarted (%"PRId64" -> %"PRId64")",
+              hp->hls_seq_next, seq);
+    hp->hls_seq_next = seq + start;
+    tvhdebug(LS_IPTV, "HLS - starting at sequence %"PRId64" (segment %d of %d)",
+             hp->hls_seq_next, start + 1, n);
+  }
+
+  if (items)
+    HTSMSG_FOREACH(f, items) {
+      if ((item = htsmsg_field_get_map(f)) == NULL) continue;
+      url = htsmsg_get_str(item, "m3u-url");
+      if (tvh_str_default(url, NULL) == NULL) continue;
+      i++;
+      if (seq + i < hp->hls_seq_next) continue;
+      hp->hls_seq_next = seq + i + 1;
+      key = NULL;
+      xkey = htsmsg_get_map(item, "x-key");
+      s = xkey ? htsmsg_get_str(xkey, "METHOD") : NULL;
+      if (s && strcmp(s, "NONE")) {
+        if (strcmp(s, "AES-128")) {
+          tvherror(LS_IPTV, "unknown crypto method '%s'", s);
+          continue;
+        }
+        s = htsmsg_get_str(xkey, "URI");
+        if (s == NULL) {
+          tvherror(LS_IPTV, "no URI in KEY attribute");
+          continue;
+        }
+        LIST_FOREACH(key, &hp->hls_keys, link)
+          if (strcmp(key->url, s) == 0)
+            break;
+        if (key == NULL) {
+          key = calloc(1, sizeof(*key));
+          key->url = strdup(s);
+          LIST_INSERT_HEAD(&hp->hls_keys, key, link);
+        }
+      }
+      seg = calloc(1, sizeof(*seg));
+      seg->seq = seq + i;
+      seg->url = strdup(url);
+      if (key) {
+        key->refcnt++;
+        seg->key = key;
+        s = htsmsg_get_str(xkey, "IV");
+        if (s && (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) &&
+            strlen(s) == (AES_BLOCK_SIZE * 2) + 2) {
+          hex2bin(seg->iv, sizeof(seg->iv), s + 2);
+        } else {
+          if (s)
+            tvherror(LS_IPTV, "unknown IV type or length (%s)", s);
+          /* the media sequence number is the default IV */
+          for (j = 0; j < 8; j++)
+            seg->iv[AES_BLOCK_SIZE - 1 - j] = (seg->seq >> (j * 8)) & 0xff;
+        }
+      }
+      sbuf_init(&seg->sbuf);
+      TAILQ_INSERT_TAIL(&hp->hls_segments, seg, link);
+      added++;
+    }
+
+  tvhtrace(LS_IPTV, "HLS - playlist sequence %"PRId64", %d segments, %d new",
+           seq, n, added);
+  hp->hls_reload_time = mclk() + (added ? sec2mono(target) : ms2mono(target * 500));
+  iptv_http_hls_kick(hp);
+}
+
+/*
+ * Assign the next job to the fetcher, the playlist reload and the keys
+ * have priority, the segments are started in the sequence order,
+ * the hls_lock must be held
+ */
+static char *
+iptv_http_hls_job ( http_priv_t *hp, hls_fetcher_t *f )
+{
+  hls_segment_t *seg;
+  hls_key_t *key;
+  uint32_t inflight = 0;
+
+  f->job = HLS_JOB_NONE;
+  f->seg = NULL;
+  f->key = NULL;
+  if (hp->shutdown)
+    return NULL;
+  sbuf_reset(&f->sbuf, 16384);
+  if (hp->hls_reload && !hp->hls_reload_busy) {
+    hp->hls_reload = 0;
+    hp->hls_reload_busy = 1;
+    f->job = HLS_JOB_PLAYLIST;
+    return strdup(hp->hls_url);
+  }
+  LIST_FOREACH(key, &hp->hls_keys, link)
+    if (key->state == HLS_STATE_PENDING && key->refcnt > 0) {
+      key->state = HLS_STATE_FETCHING;
+      f->job = HLS_JOB_KEY;
+      f->key = key;
+      return strdup(key->url);
+    }
+  TAILQ_FOREACH(seg, &hp->hls_segments, link) {
+    if (seg->state != HLS_STATE_PENDING) {
+      inflight++;
+      continue;
+    }
+    if (inflight >= hp->hls_prefetch)
+      break;
+    if (seg->key) {
+      if (seg->key->state == HLS_STATE_FAILED) {
+        seg->state = HLS_STATE_DONE;
+        inflight++;
+        continue;
+      }
+      if (seg->key->state != HLS_STATE_DONE)
+        break;
+      f->aes128.key = seg->key->key;
+      memcpy(f->aes128.iv, seg->iv, AES_BLOCK_SIZE);
+      f->aes128.tmp_len = 0;
+    }
+    seg->state = HLS_STATE_FETCHING;
+    sbuf_reset(&seg->sbuf, 16384);
+    seg->rpos = 0;
+    f->job = HLS_JOB_SEGMENT;
+    f->seg = seg;
+    f->start = getfastmonoclock();
+    f->ttfb = 0;
+    return strdup(seg->url);
+  }
+  return NULL;
+}
+
+/*
+ * the hls_lock must be held
+ */
+static void
+iptv_http_hls_job_failed ( http_priv_t *hp, hls_fetcher_t *f )
+{
+  hls_segment_t *seg = f->seg;
+  hls_key_t *key = f->key;
+
+  switch (f->job) {
+  case HLS_JOB_NONE:
+    return;
+  case HLS_JOB_PLAYLIST:
+    hp->hls_reload_busy = 0;
+    hp->hls_reload_time = mclk() + sec2mono(1);
+    break;
+  case HLS_JOB_KEY:
+    if (++key->retries >= HLS_KEY_RETRY) {
+      tvherror(LS_IPTV, "HLS - unable to fetch key '%s'", key->url);
+      key->state = HLS_STATE_FAILED;
+    } else {
+      key->state = HLS_STATE_PENDING;
+    }
+    break;
+  case HLS_JOB_SEGMENT:
+    /* the head segment might be passed partially to the mux */
+    if (seg->started || ++seg->retries > HLS_SEGMENT_RETRY) {
+      tvhwarn(LS_IPTV, "HLS - segment %"PRId64" fetch failed", seg->seq);
+      seg->state = HLS_STATE_DONE;
+      iptv_http_hls_deliver(hp, 0);
+    } else {
+      seg->state = HLS_STATE_PENDING;
+    }
+    break;
+  }
+  f->job = HLS_JOB_NONE;
+  f->seg = NULL;
+  f->key = NULL;
+  iptv_http_hls_kick(hp);
+}
+
+/*
+ * Decrypt AES-128 data as they arrive, the last block is kept back
+ * until the end of the segment to remove the padding
+ */
+static void
+iptv_http_hls_decrypt ( hls_fetcher_t *f, const uint8_t *buf, size_t len, int last )
+{
+  sbuf_t *sb = &f->dbuf;
+  size_t total = f->aes128.tmp_len + len, n, rem;
+
+  sb->sb_ptr = 0;
+  if (last)
+    n = total - (total % AES_BLOCK_SIZE);
+  else
+    n = total > AES_BLOCK_SIZE ? ((total - 1) / AES_BLOCK_SIZE) * AES_BLOCK_SIZE : 0;
+  if (n > 0) {
+    sbuf_append(sb, f->aes128.tmp, f->aes128.tmp_len);
+    rem = n - f->aes128.tmp_len;
+    sbuf_append(sb, buf, rem);
+    buf += rem;
+    len -= rem;
+    f->aes128.tmp_len = 0;
+    AES_cbc_encrypt(sb->sb_data, sb->sb_data, n, &f->aes128.key,
+                    f->aes128.iv, AES_DECRYPT);
+    if (last && sb->sb_data[n - 1] >= 1 && sb->sb_data[n - 1] <= AES_BLOCK_SIZE)
+      sb->sb_ptr -= sb->sb_data[n - 1];
+  }
+  memcpy(f->aes128.tmp + f->aes128.tmp_len, buf, len);
+  f->aes128.tmp_len += len;
+}
+
+static void
+iptv_http_hls_create_header
+  ( http_client_t *hc, http_arg_list_t *h, const url_t *url, int keepalive )
+{
+  hls_fetcher_t *f = hc->hc_aux;
+
+  /* keep the connection for the next job */
+  http_client_basic_args(hc, h, url, 1);
+  http_client_add_args(hc, h, f->hp->im->mm_iptv_hdr);
+}
+
+static int
+iptv_http_hls_header ( http_client_t *hc )
+{
+  hls_fetcher_t *f = hc->hc_aux;
+
+  if (hc->hc_code == HTTP_STATUS_OK && f->job == HLS_JOB_SEGMENT && !f->ttfb)
+    f->ttfb = getfastmonoclock() - f->start;
+  return 0;
+}
+
+static int
+iptv_http_hls_data ( http_client_t *hc, void *buf, size_t len )
+{
+  hls_fetcher_t *f = hc->hc_aux;
+  http_priv_t *hp = f->hp;
+  hls_segment_t *seg = f->seg;
+
+  if (hp->shutdown || hc->hc_code != HTTP_STATUS_OK || f->job == HLS_JOB_NONE)
+    return 0;
+  if (f->job != HLS_JOB_SEGMENT) {
+    sbuf_append(&f->sbuf, buf, len);
+    return 0;
+  }
+  if (seg->key) {
+    iptv_http_hls_decrypt(f, buf, len, 0);
+    buf = f->dbuf.sb_data;
+    len = f->dbuf.sb_ptr;
+    if (len == 0)
+      return 0;
+  }
+  tvh_mutex_lock(&hp->hls_lock);
+  sbuf_append(&seg->sbuf, buf, len);
+  if (seg == TAILQ_FIRST(&hp->hls_segments))
+    iptv_http_hls_deliver(hp, 0);
+  tvh_mutex_unlock(&hp->hls_lock);
+  return 0;
+}
+
+static void
+iptv_http_hls_request ( hls_fetcher_t *f, char *url )
+{
+  http_priv_t *hp = f->hp;
+  http_client_t *hc = f->hc;
+  url_t u;
+  int r = -EINVAL;
+
+  urlinit(&u);
+  if (!urlparse(url, &u)) {
+    tvh_mutex_lock(&hc->hc_mutex);
+    f->reconnect = 1;
+    r = http_client_simple_reconnect(hc, &u, HTTP_VERSION_1_1);
+    f->reconnect = 0;
+    tvh_mutex_unlock(&hc->hc_mutex);
+  }
+  urlreset(&u);
+  if (r < 0) {
+    tvherror(LS_IPTV, "HLS - cannot request '%s': %d", url, r);
+    tvh_mutex_lock(&hp->hls_lock);
+    iptv_http_hls_job_failed(hp, f);
+    f->idle = 1;
+    tvh_mutex_unlock(&hp->hls_lock);
+  }
+  free(url);
+}
+
+static int
+iptv_http_hls_complete ( http_client_t *hc )
+{
+  hls_fetcher_t *f = hc->hc_aux;
+  http_priv_t *hp = f->hp;
+  hls_segment_t *seg = f->seg;
+  htsmsg_t *m = NULL;
+  char *url = NULL;
+  int ms;
+
+  if (hp->shutdown || f->job == HLS_JOB_NONE)
+    return 0;
+  if (hc->hc_code == HTTP_STATUS_MOVED ||
+      hc->hc_code == HTTP_STATUS_FOUND ||
+      hc->hc_code == HTTP_STATUS_SEE_OTHER ||
+      hc->hc_code == HTTP_STATUS_NOT_MODIFIED)
+    return 0;  /* redirected, wait for the new location */
+  if (hc->hc_code == HTTP_STATUS_OK) {
+    if (f->job == HLS_JOB_PLAYLIST) {
+      sbuf_append(&f->sbuf, "", 1);
+      m = parse_m3u((char *)f->sbuf.sb_data, NULL, hc->hc_url);
+    } else if (f->job == HLS_JOB_SEGMENT && seg->key) {
+      iptv_http_hls_decrypt(f, NULL, 0, 1);
+    }
+  }
+
+  tvh_mutex_lock(&hp->hls_lock);
+  if (hc->hc_code != HTTP_STATUS_OK) {
+    tvhwarn(LS_IPTV, "HLS - HTTP error %d for '%s'", hc->hc_code, hc->hc_url);
+    iptv_http_hls_job_failed(hp, f);
+    f->idle = 1;
+    goto unlock;
+  }
+  switch (f->job) {
+  case HLS_JOB_PLAYLIST:
+    hp->hls_reload_busy = 0;
+    iptv_http_hls_playlist(hp, m);
+    break;
+  case HLS_JOB_KEY:
+    if (f->sbuf.sb_ptr != AES_BLOCK_SIZE) {
+      tvherror(LS_IPTV, "AES-128 key wrong length (%d)", f->sbuf.sb_ptr);
+      iptv_http_hls_job_failed(hp, f);
+      break;
+    }
+    AES_set_decrypt_key(f->sbuf.sb_data, 128, &f->key->key);
+    f->key->state = HLS_STATE_DONE;
+    break;
+  case HLS_JOB_SEGMENT:
+    if (seg->key && f->dbuf.sb_ptr > 0)
+      sbuf_append(&seg->sbuf, f->dbuf.sb_data, f->dbuf.sb_ptr);
+    seg->state = HLS_STATE_DONE;
+    ms = mono2ms(f->ttfb);
+    hp->hls_latency = hp->hls_latency ? (hp->hls_latency * 3 + ms) / 4 : MAX(ms, 1);
+    tvhtrace(LS_IPTV, "HLS - segment %"PRId64" done, first byte %d ms, total %"PRId64" ms",
+             seg->seq, ms, mono2ms(getfastmonoclock() - f->start));
+    iptv_http_hls_deliver(hp, 0);
+    break;
+  default:
+    break;
+  }
+  url = iptv_http_hls_job(hp, f);
+  if (url == NULL) {
+    f->idle = 1;
+    iptv_http_hls_kick(hp);
+  }
+unlock:
+  tvh_mutex_unlock(&hp->hls_lock);
+  htsmsg_destroy(m);
+  if (url)
+    iptv_http_hls_request(f, url);
+  return 0;
+}
+
+static void
+iptv_http_hls_conn_closed ( http_client_t *hc, int err )
+{
+  hls_fetcher_t *f = hc->hc_aux;
+  http_priv_t *hp = f->hp;
+
+  if (f->reconnect)
+    return;
+  tvh_mutex_lock(&hp->hls_lock);
+  if (f->job != HLS_JOB_NONE && !hp->shutdown) {
+    tvhwarn(LS_IPTV, "HLS - connection closed (%d)", err);
+    iptv_http_hls_job_failed(hp, f);
+    f->idle = 1;
+  }
+  tvh_mutex_unlock(&hp->hls_lock);
+}
+
+static void
+iptv_http_hls_setup ( hls_fetcher_t *f, http_client_t *hc )
+{
+  hc->hc_aux             = f;
+  hc->hc_hdr_create      = iptv_http_hls_create_header;
+  hc->hc_hdr_received    = iptv_http_hls_header;
+  hc->hc_data_received   = iptv_http_hls_data;
+  hc->hc_data_complete   = iptv_http_hls_complete;
+  hc->hc_conn_closed     = iptv_http_hls_conn_closed;
+  hc->hc_handle_location = 1;
+  hc->hc_io_size         = 128*1024;
+  f->hc = hc;
+}
+
+static hls_fetcher_t *
+iptv_http_hls_fetcher_create ( http_priv_t *hp )
+{
+  hls_fetcher_t *f = calloc(1, sizeof(*f));
+  f->hp = hp;
+  sbuf_init(&f->sbuf);
+  sbuf_init(&f->dbuf);
+  return f;
+}
+
+static void
+iptv_http_hls_fetcher_destroy ( hls_fetcher_t *f )
+{
+  if (f->hc)
+    http_client_close(f->hc);
+  sbuf_free(&f->sbuf);
+  sbuf_free(&f->dbuf);
+  free(f);
+}
+
+static int
+iptv_http_hls_connect ( hls_fetcher_t *f, const char *url )
+{
+  http_client_t *hc;
+  url_t u;
+  int r = -EINVAL;
+
+  urlinit(&u);
+  if (urlparse(url, &u)) {
+    tvherror(LS_IPTV, "HLS - invalid url '%s'", url);
+    goto end;
+  }
+  hc = http_client_connect(f, HTTP_VERSION_1_1, u.scheme, u.host, u.port, NULL);
+  if (hc == NULL) {
+    r = -EIO;
+    goto end;
+  }
+  iptv_http_hls_setup(f, hc);
+  http_client_register(hc);
+  r = http_client_simple(hc, &u);
+end:
+  urlreset(&u);
+  return r;
+}
+
+/*
+ * Reload the playlist, release the idle fetchers and start the new ones
+ */
+static void
+iptv_http_hls_manage ( void *aux )
+{
+  http_priv_t *hp = aux;
+  iptv_mux_t *im = hp->im;
+  hls_fetcher_t *f, *f_next;
+  hls_key_t *key, *key_next;
+  LIST_HEAD(, hls_fetcher) idle;
+  char *url;
+  int r;
+
+  LIST_INIT(&idle);
+  tvh_mutex_lock(&hp->hls_lock);
+  if (hp->shutdown)
+    goto unlock;
+  hp->hls_kick = 0;
+  if (hp->hls_unpause) {
+    hp->hls_unpause = 0;
+    if (im->mm_active)
+      mtimer_arm_rel(&im->im_pause_timer, iptv_input_unpause, im, sec2mono(1));
+  }
+  if (hp->hls_resume) {
+    hp->hls_resume = 0;
+    hp->hls_paused = 0;
+    iptv_http_hls_deliver(hp, 1);
+  }
+  if (!hp->hls_endlist && !hp->hls_reload_busy && hp->hls_reload_time <= mclk())
+    hp->hls_reload = 1;
+  for (f = LIST_FIRST(&hp->hls_fetchers); f; f = f_next) {
+    f_next = LIST_NEXT(f, link);
+    if (!f->idle) continue;
+    LIST_REMOVE(f, link);
+    hp->hls_fetchers_count--;
+    LIST_INSERT_HEAD(&idle, f, link);
+  }
+  for (key = LIST_FIRST(&hp->hls_keys); key; key = key_next) {
+    key_next = LIST_NEXT(key, link);
+    if (key->refcnt > 0 || key->state == HLS_STATE_FETCHING) continue;
+    LIST_REMOVE(key, link);
+    free(key->url);
+    free(key);
+  }
+  /* one fetcher more for the playlist and keys */
+  while (hp->hls_fetchers_count <= hp->hls_prefetch) {
+    f = iptv_http_hls_fetcher_create(hp);
+    if ((url = iptv_http_hls_job(hp, f)) == NULL) {
+      iptv_http_hls_fetcher_destroy(f);
+      break;
+    }
+    LIST_INSERT_HEAD(&hp->hls_fetchers, f, link);
+    hp->hls_fetchers_count++;
+    tvh_mutex_unlock(&hp->hls_lock);
+    r = iptv_http_hls_connect(f, url);
+    free(url);
+    tvh_mutex_lock(&hp->hls_lock);
+    if (r < 0) {
+      iptv_http_hls_job_failed(hp, f);
+      f->idle = 1;
+      break;
+    }
+  }
+  if (!hp->hls_kick && !hp->hls_endlist && !hp->hls_reload && !hp->hls_reload_busy)
+    mtimer_arm_abs(&hp->hls_timer, iptv_http_hls_manage, hp, hp->hls_reload_time);
+unlock:
+  tvh_mutex_unlock(&hp->hls_lock);
+  while ((f = LIST_FIRST(&idle)) != NULL) {
+    LIST_REMOVE(f, link);
+    iptv_http_hls_fetcher_destroy(f);
+  }
+}
+
+/*
+ * Switch to the prefetch mode when the media playlist is received,
+ * the playlist client becomes the first fetcher
+ */
+static int
+iptv_http_hls_start ( http_priv_t *hp, http_client_t *hc, htsmsg_t *m )
+{
+  hls_fetcher_t *f;
+  char *url = NULL;
+
+  if (htsmsg_get_s64_or_default(m, "targetduration", 0) <= 0 || hc->hc_url == NULL)
+    return 0;
+  f = iptv_http_hls_fetcher_create(hp);
+  tvh_mutex_lock(&hp->hls_lock);
+  if (hp->shutdown) {
+    tvh_mutex_unlock(&hp->hls_lock);
+    iptv_http_hls_fetcher_destroy(f);
+    htsmsg_destroy(m);
+    return 1;
+  }
+  tvhdebug(LS_IPTV, "HLS - prefetch %u segments from '%s'", hp->hls_prefetch, hc->hc_url);
+  hp->hls_active = 1;
+  free(hp->hls_url);
+  hp->hls_url = strdup(hc->hc_url);
+  iptv_http_hls_playlist(hp, m);
+  iptv_http_hls_setup(f, hc);
+  hp->hc = NULL;
+  LIST_INSERT_HEAD(&hp->hls_fetchers, f, link);
+  hp->hls_fetchers_count++;
+  if ((url = iptv_http_hls_job(hp, f)) == NULL)
+    f->idle = 1;
+  tvh_mutex_unlock(&hp->hls_lock);
+  htsmsg_destroy(m);
+  if (url)
+    iptv_http_hls_request(f, url);
+  return 1;
+}
+
 /*
  * Custom headers
  */
@@ -483,8 +1229,18 @@ iptv_http_create_header
 static void
 iptv_http_free( http_priv_t *hp )
 {
+  hls_key_t *key;
+
   if (hp->hc)
     http_client_close(hp->hc);
+  while (!TAILQ_EMPTY(&hp->hls_segments))
+    iptv_http_hls_segment_free(hp, TAILQ_FIRST(&hp->hls_segments));
+  while ((key = LIST_FIRST(&hp->hls_keys)) != NULL) {
+    LIST_REMOVE(key, link);
+    free(key->url);
+    free(key);
+  }
+  tvh_mutex_destroy(&hp->hls_lock);
   sbuf_free(&hp->m3u_sbuf);
   sbuf_free(&hp->key_sbuf);
   htsmsg_destroy(hp->hls_m3u);
@@ -512,6 +1268,10 @@ iptv_http_start
   hp = calloc(1, sizeof(*hp));
   hp->mi = mi;
   hp->im = im;
+  tvh_mutex_init(&hp->hls_lock, NULL);
+  TAILQ_INIT(&hp->hls_segments);
+  hp->hls_prefetch = MIN(im->mm_iptv_hls_prefetch, 32);
+  hp->hls_seq_next = -1;
   if (!(hc = http_client_connect(hp, HTTP_VERSION_1_1, u->scheme,
                                  u->host, u->port, NULL))) {
     iptv_http_free(hp);
@@ -548,13 +1308,39 @@ iptv_http_stop
   ( iptv_input_t *mi, iptv_mux_t *im )
 {
   http_priv_t *hp = im->im_data;
+  mpegts_mux_instance_t *mmi;
+  LIST_HEAD(, hls_fetcher) fetchers;
+  hls_fetcher_t *f;
+  http_client_t *hc;
 
   hp->shutdown = 1;
   gtimer_disarm(&hp->kick_timer);
   tvh_mutex_unlock(&iptv_lock);
-  http_client_close(hp->hc);
-  tvh_mutex_lock(&iptv_lock);
+  tvh_mutex_lock(&hp->hls_lock);
+  hp->shutdown = 1;
+  hc = hp->hc;
   hp->hc = NULL;
+  LIST_INIT(&fetchers);
+  while ((f = LIST_FIRST(&hp->hls_fetchers)) != NULL) {
+    LIST_REMOVE(f, link);
+    LIST_INSERT_HEAD(&fetchers, f, link);
+  }
+  hp->hls_fetchers_count = 0;
+  tvh_mutex_unlock(&hp->hls_lock);
+  mtimer_disarm(&hp->hls_timer);
+  if (hc)
+    http_client_close(hc);
+  while ((f = LIST_FIRST(&fetchers)) != NULL) {
+    LIST_REMOVE(f, link);
+    iptv_http_hls_fetcher_destroy(f);
+  }
+  tvh_mutex_lock(&iptv_lock);
+  if (hp->hls_active && (mmi = im->mm_active) != NULL) {
+    tvh_mutex_lock(&mmi->tii_stats_mutex);
+    mmi->tii_stats.seg_latency = 0;
+    mmi->tii_stats.seg_depth = 0;
+    tvh_mutex_unlock(&mmi->tii_stats_mutex);
+  }
   im->im_data = NULL;
   iptv_http_free(hp);
 }
@@ -570,7 +1356,14 @@ iptv_http_pause
   http_priv_t *hp = im->im_data;
 
   assert(pause == 0);
-  http_client_unpause(hp->hc);
+  if (hp->hls_active) {
+    /* called from the unpause timer, the manager runs in the same thread */
+    hp->hls_resume = 1;
+    mtimer_arm_rel(&hp->hls_timer, iptv_http_hls_manage, hp, 0);
+    return;
+  }
+  if (hp->hc)
+    http_client_unpause(hp->hc);
 }
 
 /*
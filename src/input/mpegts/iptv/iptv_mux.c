@@ -301,6 +301,17 @@ const idclass_t iptv_mux_class =
       .off      = offsetof(iptv_mux_t, mm_iptv_buffer_limit),
       .opts     = PO_ADVANCED,
     },
+    {
+      .type     = PT_U32,
+      .id       = "iptv_hls_prefetch",
+      .name     = N_("HLS prefetch segments"),
+      .desc     = N_("Number of HLS media segments fetched in parallel "
+                     "and buffered ahead of the playback. Live "
+                     "playlists start three segments from the end. "
+                     "Zero fetches the segments one by one."),
+      .off      = offsetof(iptv_mux_t, mm_iptv_hls_prefetch),
+      .opts     = PO_ADVANCED,
+    },
     {}
   }
 };
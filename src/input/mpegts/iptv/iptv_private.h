@@ -176,6 +176,7 @@ struct iptv_mux
   sbuf_t                im_temp_buffer;
 
   uint32_t              mm_iptv_buffer_limit;
+  uint32_t              mm_iptv_hls_prefetch;
 
   iptv_handler_t       *im_handler;
   mtimer_t              im_pause_timer;
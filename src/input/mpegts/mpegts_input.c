@@ -27,6 +27,9 @@
 memoryinfo_t mpegts_input_queue_memoryinfo = { .my_name = "MPEG-TS input queue" };
 memoryinfo_t mpegts_input_table_memoryinfo = { .my_name = "MPEG-TS table queue" };
 
+/* the new data are dropped over four times this limit (50MB) */
+#define MPEGTS_INPUT_QUEUE_LIMIT (50*1024*1024 / 4)
+
 static void
 mpegts_input_del_network ( mpegts_network_link_t *mnl );
 
@@ -1174,10 +1177,13 @@ mpegts_input_queue_packets
   mpegts_input_t *mi = mmi->mmi_input;
   const char *id = SRCLINEID();
   int len = mp->mp_len;
+  streaming_pressure_t bp = { .bp_max_bytes = MPEGTS_INPUT_QUEUE_LIMIT };
 
   tvh_mutex_lock(&mi->mi_input_lock);
   if (mmi->mmi_mux->mm_active == mmi) {
-    if (mi->mi_input_queue_size < 50*1024*1024) {
+    bp.bp_bytes = mi->mi_input_queue_size;
+    if (!streaming_pressure_drop(SQ_POLICY_PAUSE,
+                                 streaming_pressure_level(&bp), NULL, NULL)) {
       mi->mi_input_queue_size += len;
       memoryinfo_alloc(&mpegts_input_queue_memoryinfo, sizeof(mpegts_packet_t) + len);
       mpegts_mux_grab(mp->mp_mux);
@@ -1197,6 +1203,21 @@ mpegts_input_queue_packets
   tvh_mutex_unlock(&mi->mi_input_lock);
 }
 
+/*
+ * Input queue backpressure - the live inputs lose the data at the hard
+ * limit, the file-backed inputs should pause when the level is non-zero
+ */
+int
+mpegts_input_queue_level ( mpegts_input_t *mi )
+{
+  streaming_pressure_t bp = { .bp_max_bytes = MPEGTS_INPUT_QUEUE_LIMIT };
+
+  tvh_mutex_lock(&mi->mi_input_lock);
+  bp.bp_bytes = mi->mi_input_queue_size;
+  tvh_mutex_unlock(&mi->mi_input_lock);
+  return streaming_pressure_level(&bp);
+}
+
 void
 mpegts_input_recv_packets
   ( mpegts_mux_instance_t *mmi, sbuf_t *sb,
@@ -1914,6 +1935,8 @@ mpegts_input_stream_status
   st->stats.tc_bit   = mmi->tii_stats.tc_bit;
   st->stats.ec_block = mmi->tii_stats.ec_block;
   st->stats.tc_block = mmi->tii_stats.tc_block;
+  st->stats.seg_latency = mmi->tii_stats.seg_latency;
+  st->stats.seg_depth   = mmi->tii_stats.seg_depth;
   tvh_mutex_unlock(&mmi->tii_stats_mutex);
   st->stats.unc   = atomic_get(&mmi->tii_stats.unc);
   st->stats.cc    = atomic_get(&mmi->tii_stats.cc);
@@ -37,7 +37,7 @@ extern const idclass_t mpegts_input_class;
 static void *
 tsfile_input_thread ( void *aux )
 {
-  int fd = -1, nfds;
+  int fd = -1, nfds, paused;
   size_t len, rem;
   ssize_t c;
   tvhpoll_t *efd;
@@ -102,9 +102,11 @@ tsfile_input_thread ( void *aux )
       tvh_mutex_unlock(&tsfile_lock);
     }
     
-    /* Check for terminate */
-    nfds = tvhpoll_wait(efd, &ev, 1, 0);
+    /* Check for terminate, pause while the input queue is full */
+    paused = mpegts_input_queue_level((mpegts_input_t *)mi) > 0;
+    nfds = tvhpoll_wait(efd, &ev, 1, paused ? 10 : 0);
     if (nfds == 1) break;
+    if (paused) continue;
     
     /* Read */
     c = sbuf_read(&buf, fd);
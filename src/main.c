@@ -47,6 +47,7 @@
 #include "spawn.h"
 #include "subscriptions.h"
 #include "service_mapper.h"
+#include "hotchannel.h"
 #include "descrambler/descrambler.h"
 #include "dvr/dvr.h"
 #include "htsp_server.h"
@@ -852,6 +853,8 @@ main(int argc, char **argv)
               opt_dbus         = 0,
               opt_dbus_session = 0,
               opt_nobackup     = 0,
+              opt_config_pack  = 0,
+              opt_config_unpack = 0,
               opt_nobat        = 0,
               opt_subsystems   = 0,
               opt_tprofile     = 0,
@@ -882,6 +885,12 @@ main(int argc, char **argv)
     {   0, NULL,        N_("Service configuration"),   OPT_BOOL, NULL         },
     { 'c', "config",    N_("Alternate configuration path"), OPT_STR,  &opt_config  },
     { 'B', "nobackup",  N_("Don't backup configuration tree at upgrade"), OPT_BOOL, &opt_nobackup },
+    {   0, "config_pack", N_("Keep the configuration in one packed file\n"
+                             "(the directory tree is imported on load)"),
+      OPT_BOOL, &opt_config_pack },
+    {   0, "config_unpack", N_("Export the packed configuration back\n"
+                               "to the directory tree"),
+      OPT_BOOL, &opt_config_unpack },
     { 'f', "fork",      N_("Fork and run as daemon"),  OPT_BOOL, &opt_fork    },
     { 'u', "user",      N_("Run as user"),             OPT_STR,  &opt_user    },
     { 'g', "group",     N_("Run as group"),            OPT_STR,  &opt_group   },
@@ -1154,7 +1163,10 @@ main(int argc, char **argv)
   tprofile_init(&mtimer_profile, "mtimer");
   uuid_init();
   idnode_boot();
-  config_boot(opt_config, gid, uid, opt_user_agent);
+  config_boot(opt_config, gid, uid, opt_user_agent,
+              opt_config_unpack ? HTS_SETTINGS_PACK_EXPORT :
+              opt_config_pack ? HTS_SETTINGS_PACK_ENABLE :
+                                HTS_SETTINGS_PACK_AUTO);
   tcp_server_preinit(opt_ipv6);
   http_server_init(opt_bindaddr);    // bind to ports only
   htsp_init(opt_bindaddr);	     // bind to ports only
@@ -1257,6 +1269,7 @@ main(int argc, char **argv)
   /* Memoryinfo */
   idclass_register(&memoryinfo_class);
   memoryinfo_register(&tasklet_memoryinfo);
+  memoryinfo_register(&idnode_save_memoryinfo);
 #if ENABLE_SLOW_MEMORYINFO
   memoryinfo_register(&htsmsg_memoryinfo);
   memoryinfo_register(&htsmsg_field_memoryinfo);
@@ -1264,6 +1277,8 @@ main(int argc, char **argv)
   memoryinfo_register(&pkt_memoryinfo);
   memoryinfo_register(&pktbuf_memoryinfo);
   memoryinfo_register(&pktref_memoryinfo);
+  memoryinfo_register(&pktbuf_slice_memoryinfo);
+  memoryinfo_register(&pktbuf_copy_memoryinfo);
 
   /**
    * Initialize subsystems
@@ -1314,8 +1329,10 @@ main(int argc, char **argv)
   tvhftrace(LS_MAIN, upnp_server_init, opt_bindaddr);
 #endif
   tvhftrace(LS_MAIN, service_mapper_init);
+  tvhftrace(LS_MAIN, hotchannel_init);
   tvhftrace(LS_MAIN, epggrab_init);
   tvhftrace(LS_MAIN, epg_init);
+  tvhftrace(LS_MAIN, muxer_wbuf_init);
   tvhftrace(LS_MAIN, dvr_init);
   tvhftrace(LS_MAIN, dbus_server_start);
   tvhftrace(LS_MAIN, http_server_register);
@@ -1331,6 +1348,8 @@ main(int argc, char **argv)
   tvhftrace(LS_MAIN, epg_updated); // cleanup now all prev ref's should have been created
   epg_in_load = 0;
 
+  hts_settings_boot_done();
+
   tvh_mutex_unlock(&global_lock);
 
   tvhftrace(LS_MAIN, watchdog_init);
@@ -1391,11 +1410,13 @@ main(int argc, char **argv)
 #endif
   tvh_mutex_unlock(&global_lock);
 
+  tvhftrace(LS_MAIN, hotchannel_done);
   tvhftrace(LS_MAIN, epggrab_done);
 #if ENABLE_MPEGTS
   tvhftrace(LS_MAIN, mpegts_done);
 #endif
   tvhftrace(LS_MAIN, dvr_done);
+  tvhftrace(LS_MAIN, muxer_wbuf_done);
   tvhftrace(LS_MAIN, descrambler_done);
   tvhftrace(LS_MAIN, service_mapper_done);
   tvhftrace(LS_MAIN, service_done);
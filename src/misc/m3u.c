@@ -220,6 +220,9 @@ multi:
       if (strcmp(multi_name, "x-key") == 0) {
         htsmsg_destroy(key);
         key = t;
+        x = (char *)htsmsg_get_str(key, "URI");
+        if (x && (y = (char *)get_url(buf, sizeof(buf), x, url)) != x)
+          htsmsg_set_str(key, "URI", y);
       } else {
         if (item == NULL)
           item = htsmsg_create_map();
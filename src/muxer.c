@@ -400,7 +400,13 @@ muxer_cache_txt2type(const char *str)
 void
 muxer_cache_update(muxer_t *m, int fd, off_t pos, size_t size)
 {
-  switch (m->m_config.m_cache) {
+  muxer_cache_update_fd(m->m_config.m_cache, fd, pos, size);
+}
+
+void
+muxer_cache_update_fd(int cache, int fd, off_t pos, size_t size)
+{
+  switch (cache) {
   case MC_CACHE_UNKNOWN:
   case MC_CACHE_SYSTEM:
     break;
@@ -57,6 +57,7 @@ typedef enum {
 typedef struct muxer_config {
   int                  m_type; /* MC_* */
   int                  m_cache;
+  int                  m_write_buffer; /* write-behind buffer in MB, 0 = off */
 
   /*
    * directory_permissions should really be in dvr.h as it's not really
@@ -100,6 +101,9 @@ struct streaming_start;
 struct th_pkt;
 struct epg_broadcast;
 struct service;
+struct muxer_wbuf;
+
+typedef struct muxer_wbuf muxer_wbuf_t;
 
 typedef struct muxer {
   int         (*m_open_stream)(struct muxer *, int fd);                 /* Open for socket streaming */
@@ -125,6 +129,7 @@ typedef struct muxer {
   int                    m_caps;       /* Capabilities */
   muxer_config_t         m_config;     /* general configuration */
   muxer_hints_t         *m_hints;      /* other hints */
+  muxer_wbuf_t          *m_wbuf;       /* write-behind buffer (files only) */
 } muxer_t;
 
 
@@ -186,6 +191,15 @@ const char* muxer_suffix      (muxer_t *m, const struct streaming_start *ss);
 const char *       muxer_cache_type2txt(muxer_cache_type_t t);
 muxer_cache_type_t muxer_cache_txt2type(const char *str);
 void               muxer_cache_update(muxer_t *m, int fd, off_t off, size_t size);
+void               muxer_cache_update_fd(int cache, int fd, off_t off, size_t size);
 int                muxer_cache_list(htsmsg_t *array);
 
+/* Write-behind buffer */
+void          muxer_wbuf_init(void);
+void          muxer_wbuf_done(void);
+muxer_wbuf_t *muxer_wbuf_create(int fd, int cache, int size, const char *name);
+int           muxer_wbuf_write(muxer_wbuf_t *wb, const void *data, size_t len);
+int           muxer_wbuf_destroy(muxer_wbuf_t *wb);
+void          muxer_wbuf_stats(muxer_wbuf_t *wb, uint32_t *depth, int64_t *latency);
+
 #endif
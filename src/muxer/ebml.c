@@ -25,43 +25,70 @@
 #include <stdio.h>
 #include "ebml.h"
 
-void
-ebml_append_id(htsbuf_queue_t *q, uint32_t id)
+int
+ebml_put_id(uint8_t *dst, uint32_t id)
 {
   uint8_t u8[4] = {id >> 24, id >> 16, id >> 8, id};
+  int l = u8[0] ? 4 : u8[1] ? 3 : u8[2] ? 2 : 1;
 
-  if(u8[0])
-    return htsbuf_append(q, u8, 4);
-  if(u8[1])
-    return htsbuf_append(q, u8+1, 3);
-  if(u8[2])
-    return htsbuf_append(q, u8+2, 2);
-  return htsbuf_append(q, u8+3, 1);
+  memcpy(dst, u8 + 4 - l, l);
+  return l;
 }
 
-void
-ebml_append_size(htsbuf_queue_t *q, uint32_t size)
+int
+ebml_put_size(uint8_t *dst, uint32_t size)
 {
   uint8_t u8[5] = { 0x08, size >> 24, size >> 16, size >> 8, size };
 
   if(size < 0x7f) {
-    u8[4] |= 0x80;
-    return htsbuf_append(q, u8+4, 1);
+    dst[0] = u8[4] | 0x80;
+    return 1;
   }
-
   if(size < 0x3fff) {
     u8[3] |= 0x40;
-    return htsbuf_append(q, u8+3, 2);
+    memcpy(dst, u8+3, 2);
+    return 2;
   }
   if(size < 0x1fffff) {
     u8[2] |= 0x20;
-    return htsbuf_append(q, u8+2, 3);
+    memcpy(dst, u8+2, 3);
+    return 3;
   }
   if(size < 0x0fffffff) {
     u8[1] |= 0x10;
-    return htsbuf_append(q, u8+1, 4);
+    memcpy(dst, u8+1, 4);
+    return 4;
   }
-  return htsbuf_append(q, u8, 5);
+  memcpy(dst, u8, 5);
+  return 5;
+}
+
+int
+ebml_put_uint(uint8_t *dst, unsigned id, int64_t ui)
+{
+  uint8_t u8[8] = {ui >> 56, ui >> 48, ui >> 40, ui >> 32,
+		   ui >> 24, ui >> 16, ui >>  8, ui };
+  int i = 0, l;
+  while( i < 7 && !u8[i] )
+    ++i;
+  l = ebml_put_id(dst, id);
+  l += ebml_put_size(dst + l, 8 - i);
+  memcpy(dst + l, u8 + i, 8 - i);
+  return l + 8 - i;
+}
+
+void
+ebml_append_id(htsbuf_queue_t *q, uint32_t id)
+{
+  uint8_t u8[4];
+  htsbuf_append(q, u8, ebml_put_id(u8, id));
+}
+
+void
+ebml_append_size(htsbuf_queue_t *q, uint32_t size)
+{
+  uint8_t u8[5];
+  htsbuf_append(q, u8, ebml_put_size(u8, size));
 }
 
 
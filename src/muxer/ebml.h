@@ -3,6 +3,12 @@
 
 #include "htsbuf.h"
 
+int ebml_put_id(uint8_t *dst, uint32_t id);
+
+int ebml_put_size(uint8_t *dst, uint32_t size);
+
+int ebml_put_uint(uint8_t *dst, unsigned id, int64_t ui);
+
 void ebml_append_id(htsbuf_queue_t *q, uint32_t id);
 
 void ebml_append_size(htsbuf_queue_t *q, uint32_t size);
@@ -85,6 +85,28 @@ typedef struct mk_cue {
   off_t cluster_pos;
 } mk_cue_t;
 
+/**
+ * Cluster under construction: the small EBML headers are collected
+ * in one buffer, the frame payloads are referenced (not copied) and
+ * everything is written out with writev() when the cluster is closed
+ */
+typedef struct mk_cluster_vec {
+  pktbuf_t *pb;       /* NULL - header bytes */
+  size_t off;
+  size_t len;
+} mk_cluster_vec_t;
+
+typedef struct mk_cluster {
+  uint8_t *hdr;
+  size_t hdr_len;
+  size_t hdr_size;
+  mk_cluster_vec_t *vec;
+  struct iovec *iov;
+  int nvec;
+  int vec_size;
+  size_t size;
+} mk_cluster_t;
+
 /**
  *
  */
@@ -108,7 +130,8 @@ typedef struct mk_muxer {
 
   int64_t totduration;
 
-  htsbuf_queue_t *cluster;
+  mk_cluster_t *cluster;
+  mk_cluster_t cluster_data;
   int64_t cluster_tc;
   off_t cluster_pos;
   int64_t cluster_last_close;
@@ -990,14 +1013,153 @@ mk_add_chapter(mk_muxer_t *mk, int64_t ts)
   mk_add_chapter0(mk, uuid, ts);
 }
 
+/**
+ *
+ */
+static mk_cluster_vec_t *
+mk_cluster_vec_add(mk_cluster_t *c)
+{
+  if(c->nvec == c->vec_size) {
+    c->vec_size = MAX(64, c->vec_size * 2);
+    c->vec = realloc(c->vec, c->vec_size * sizeof(*c->vec));
+    c->iov = realloc(c->iov, (c->vec_size + 1) * sizeof(*c->iov));
+  }
+  return &c->vec[c->nvec++];
+}
+
+
+/**
+ * Append header bytes, merged with the previous header chunk
+ */
+static void
+mk_cluster_append(mk_cluster_t *c, const void *data, size_t len)
+{
+  mk_cluster_vec_t *v = c->nvec ? &c->vec[c->nvec - 1] : NULL;
+
+  if(c->hdr_len + len > c->hdr_size) {
+    c->hdr_size = MAX(4096, (c->hdr_len + len) * 2);
+    c->hdr = realloc(c->hdr, c->hdr_size);
+  }
+  memcpy(c->hdr + c->hdr_len, data, len);
+  if(v == NULL || v->pb || v->off + v->len != c->hdr_len) {
+    v = mk_cluster_vec_add(c);
+    v->pb = NULL;
+    v->off = c->hdr_len;
+    v->len = 0;
+  }
+  v->len += len;
+  c->hdr_len += len;
+  c->size += len;
+}
+
+
+/**
+ * Append a reference to the frame payload
+ */
+static void
+mk_cluster_append_pb(mk_cluster_t *c, pktbuf_t *pb, size_t off, size_t len)
+{
+  mk_cluster_vec_t *v = mk_cluster_vec_add(c);
+
+  v->pb = pktbuf_ref_inc(pb);
+  v->off = off;
+  v->len = len;
+  c->size += len;
+}
+
+
+/**
+ *
+ */
+static void
+mk_cluster_reset(mk_cluster_t *c)
+{
+  int i;
+
+  for(i = 0; i < c->nvec; i++)
+    if(c->vec[i].pb)
+      pktbuf_ref_dec(c->vec[i].pb);
+  c->nvec = 0;
+  c->hdr_len = 0;
+  c->size = 0;
+}
+
+
+/**
+ *
+ */
+static void
+mk_cluster_free(mk_cluster_t *c)
+{
+  mk_cluster_reset(c);
+  free(c->hdr);
+  free(c->vec);
+  free(c->iov);
+}
+
+
+/**
+ * Write the cluster element, the payloads go directly from the packets
+ */
+static int
+mk_write_cluster(mk_muxer_t *mk, mk_cluster_t *c)
+{
+  uint8_t master[16];
+  struct iovec *iov = c->iov;
+  mk_cluster_vec_t *v;
+  off_t oldpos = mk->fdpos;
+  ssize_t r;
+  int i, iovcnt;
+
+  iov[0].iov_base = master;
+  iov[0].iov_len  = ebml_put_id(master, 0x1f43b675);
+  iov[0].iov_len += ebml_put_size(master + iov[0].iov_len, c->size);
+  for(i = 0, v = c->vec; i < c->nvec; i++, v++) {
+    iov[i+1].iov_base = (v->pb ? pktbuf_ptr(v->pb) : c->hdr) + v->off;
+    iov[i+1].iov_len  = v->len;
+  }
+
+  i = c->nvec + 1;
+  while(i > 0) {
+    iovcnt = i < dvr_iov_max ? i : dvr_iov_max;
+    if((r = writev(mk->fd, iov, iovcnt)) == -1) {
+      if (ERRNO_AGAIN(errno))
+        continue;
+      mk->error = errno;
+      return -1;
+    }
+    mk->fdpos += r;
+    /* skip the written vectors, continue a partial write */
+    while(i > 0 && r >= iov->iov_len) {
+      r -= iov->iov_len;
+      iov++;
+      i--;
+    }
+    if(r > 0) {
+      iov->iov_base = (uint8_t *)iov->iov_base + r;
+      iov->iov_len -= r;
+    }
+  }
+
+  if (mk->seekable)
+    muxer_cache_update((muxer_t *)mk, mk->fd, oldpos, 0);
+
+  return 0;
+}
+
+
 /**
  *
  */
 static void
 mk_close_cluster(mk_muxer_t *mk)
 {
-  if(mk->cluster != NULL)
-    mk_write_master(mk, 0x1f43b675, mk->cluster);
+  if(mk->cluster != NULL) {
+    if(!mk->error && mk_write_cluster(mk, mk->cluster) &&
+       !MC_IS_EOS_ERROR(mk->error))
+      tvherror(LS_MKV, "%s: Write failed -- %s", mk->filename, strerror(errno));
+    mk_cluster_reset(mk->cluster);
+  }
   mk->cluster = NULL;
   mk->cluster_last_close = mclk();
 }
@@ -1010,7 +1172,8 @@ static void
 mk_write_frame_i(mk_muxer_t *mk, mk_track_t *t, th_pkt_t *pkt)
 {
   int64_t pts = pkt->pkt_pts, delta, nxt;
-  unsigned char c_delta_flags[3];
+  uint8_t hdr[32];
+  size_t off = 0, l;
   const int video = t->tracktype == 1;
   const int audio = t->tracktype == 2;
   int keyframe = 0, skippable = 0;
@@ -1020,10 +1183,9 @@ mk_write_frame_i(mk_muxer_t *mk, mk_track_t *t, th_pkt_t *pkt)
     skippable = pkt->v.pkt_frametype == PKT_B_FRAME;
   }
 
-  uint8_t *data = pktbuf_ptr(pkt->pkt_payload);
   size_t len = pktbuf_len(pkt->pkt_payload);
 
-  if(!data || len <= 0)
+  if(!pktbuf_ptr(pkt->pkt_payload) || len <= 0)
     return;
 
   if(pts == PTS_UNSET)
@@ -1050,28 +1212,29 @@ mk_write_frame_i(mk_muxer_t *mk, mk_track_t *t, th_pkt_t *pkt)
   if(mk->cluster) {
 
     if(keyframe &&
-       (mk->cluster->hq_size > mk->cluster_maxsize ||
+       (mk->cluster->size > mk->cluster_maxsize ||
         mk->cluster_last_close + sec2mono(1) < mclk()))
       mk_close_cluster(mk);
 
     else if(!mk->has_video &&
-            (mk->cluster->hq_size > mk->cluster_maxsize/40 ||
+            (mk->cluster->size > mk->cluster_maxsize/40 ||
              mk->cluster_last_close + sec2mono(1) < mclk()))
       mk_close_cluster(mk);
 
-    else if(mk->cluster->hq_size > mk->cluster_maxsize)
+    else if(mk->cluster->size > mk->cluster_maxsize)
       mk_close_cluster(mk);
 
   }
 
   if(mk->cluster == NULL) {
     mk->cluster_tc = pts;
-    mk->cluster = htsbuf_queue_alloc(0);
+    mk->cluster = &mk->cluster_data;
 
     mk->cluster_pos = mk->fdpos;
     mk->addcue = 1;
 
-    ebml_append_uint(mk->cluster, 0xe7, mk->cluster_tc);
+    l = ebml_put_uint(hdr, 0xe7, mk->cluster_tc);
+    mk_cluster_append(mk->cluster, hdr, l);
     delta = 0;
   }
 
@@ -1086,19 +1249,19 @@ mk_write_frame_i(mk_muxer_t *mk, mk_track_t *t, th_pkt_t *pkt)
       return;
 
     len -= 7;
-    data += 7;
+    off = 7;
   }
 
-  ebml_append_id(mk->cluster, 0xa3 ); // SimpleBlock
-  ebml_append_size(mk->cluster, len + 4);
-  ebml_append_size(mk->cluster, t->tracknum);
+  l  = ebml_put_id(hdr, 0xa3); // SimpleBlock
+  l += ebml_put_size(hdr + l, len + 4);
+  l += ebml_put_size(hdr + l, t->tracknum);
 
-  c_delta_flags[0] = delta >> 8;
-  c_delta_flags[1] = delta;
+  hdr[l++] = delta >> 8;
+  hdr[l++] = delta;
   if (audio && pkt->a.pkt_keyframe) keyframe = 1;
-  c_delta_flags[2] = (keyframe << 7) | skippable;
-  htsbuf_append(mk->cluster, c_delta_flags, 3);
-  htsbuf_append(mk->cluster, data, len);
+  hdr[l++] = (keyframe << 7) | skippable;
+  mk_cluster_append(mk->cluster, hdr, l);
+  mk_cluster_append_pb(mk->cluster, pkt->pkt_payload, off, len);
 }
 
 
@@ -1519,6 +1682,7 @@ mkv_muxer_destroy(muxer_t *m)
   mk_chapter_t *ch;
 
   pktref_clear_queue(&mk->holdq);
+  mk_cluster_free(&mk->cluster_data);
 
   while((ch = TAILQ_FIRST(&mk->chapters)) != NULL) {
     TAILQ_REMOVE(&mk->chapters, ch, link);
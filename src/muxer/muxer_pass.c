@@ -572,7 +572,15 @@ pass_muxer_open_file(muxer_t *m, const char *filename)
   pm->pm_ofd      = fd;
   pm->pm_filename = strdup(filename);
 
-  return pass_muxer_open2(pm);
+  if (pass_muxer_open2(pm))
+    return -1;
+
+  /* buffer the direct file writes only (no spawned pipe) */
+  if (pm->pm_fd == pm->pm_ofd)
+    pm->m_wbuf = muxer_wbuf_create(pm->pm_fd, pm->m_config.m_cache,
+                                   pm->m_config.m_write_buffer,
+                                   pm->pm_filename);
+  return 0;
 }
 
 
@@ -586,6 +594,11 @@ pass_muxer_write(muxer_t *m, const void *data, size_t size)
 
   if(pm->pm_error) {
     pm->m_errors++;
+  } else if(m->m_wbuf) {
+    if ((pm->pm_error = muxer_wbuf_write(m->m_wbuf, data, size)) != 0)
+      m->m_errors++;
+    else
+      pm->pm_off += size;
   } else if(tvh_write(pm->pm_fd, data, size)) {
     pm->pm_error = errno;
     if (!MC_IS_EOS_ERROR(errno))
@@ -726,10 +739,19 @@ static int
 pass_muxer_close(muxer_t *m)
 {
   pass_muxer_t *pm = (pass_muxer_t*)m;
+  int r;
 
   if(pm->pm_spawn_pid > 0)
     spawn_kill(pm->pm_spawn_pid, tvh_kill_to_sig(pm->m_config.u.pass.m_killsig),
                pm->m_config.u.pass.m_killtimeout);
+  if(m->m_wbuf) {
+    r = muxer_wbuf_destroy(m->m_wbuf);
+    m->m_wbuf = NULL;
+    if (r && !pm->pm_error) {
+      pm->pm_error = r;
+      pm->m_errors++;
+    }
+  }
   if(pm->pm_seekable && close(pm->pm_ofd)) {
     pm->pm_error = errno;
     tvherror(LS_PASS, "%s: Unable to close file, close failed -- %s",
@@ -750,6 +772,9 @@ pass_muxer_destroy(muxer_t *m)
 {
   pass_muxer_t *pm = (pass_muxer_t*)m;
 
+  if(m->m_wbuf)
+    muxer_wbuf_destroy(m->m_wbuf);
+
   if(pm->pm_filename)
     free(pm->pm_filename);
 
@@ -0,0 +1,393 @@
+/*
+ *  tvheadend, write-behind buffer for the recording muxers
+ *  Copyright (C) 2026 Tvheadend Foundation CIC
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "tvheadend.h"
+#include "memoryinfo.h"
+#include "tvhio.h"
+#include "muxer.h"
+
+/*
+ * The producer (recording thread) copies the muxed data into fixed size
+ * aligned chunks. Full chunks are queued and written by a small shared
+ * pool of I/O threads. All chunks queued for one file are written in one
+ * pass and the cache scheme (fdatasync / fadvise) is applied once per
+ * flushed extent instead of once per write.
+ */
+
+#define MUXER_WBUF_THREADS   2
+#define MUXER_WBUF_ALIGN     4096
+#define MUXER_WBUF_MIN_CHUNK (64*1024)
+#define MUXER_WBUF_MAX_CHUNK (2*1024*1024)
+#define MUXER_WBUF_MAX_SIZE  64 /* MB */
+#define MUXER_WBUF_MAX_REQS  (MUXER_WBUF_MAX_SIZE * 1024 * 1024 / MUXER_WBUF_MAX_CHUNK + 4)
+
+typedef struct muxer_wbuf_chunk {
+  TAILQ_ENTRY(muxer_wbuf_chunk) link;
+  size_t   len;
+  uint8_t *data;
+} muxer_wbuf_chunk_t;
+
+TAILQ_HEAD(muxer_wbuf_chunk_queue, muxer_wbuf_chunk);
+
+struct muxer_wbuf {
+  TAILQ_ENTRY(muxer_wbuf) wb_link;
+  struct muxer_wbuf_chunk_queue wb_queue;  /* waiting for the I/O thread */
+  struct muxer_wbuf_chunk_queue wb_free;   /* recycled chunks */
+  muxer_wbuf_chunk_t *wb_cur;              /* filled by the producer */
+  char    *wb_name;
+  int      wb_fd;
+  int      wb_cache;
+  int      wb_scheduled;
+  int      wb_error;
+  size_t   wb_chunk;
+  size_t   wb_limit;
+  size_t   wb_queued;
+  off_t    wb_off;
+  uint32_t wb_depth;
+  int64_t  wb_latency;
+  int64_t  wb_latency_max;
+};
+
+static TAILQ_HEAD(, muxer_wbuf) muxer_wbuf_work;
+static tvh_mutex_t muxer_wbuf_lock;
+static tvh_cond_t  muxer_wbuf_cond;
+static tvh_cond_t  muxer_wbuf_done_cond;
+static pthread_t   muxer_wbuf_tid[MUXER_WBUF_THREADS];
+static int         muxer_wbuf_threads;
+static int         muxer_wbuf_running;
+
+static memoryinfo_t muxer_wbuf_memoryinfo = { .my_name = "Write-behind buffers" };
+
+/**
+ *
+ */
+static muxer_wbuf_chunk_t *
+muxer_wbuf_chunk_alloc(muxer_wbuf_t *wb)
+{
+  muxer_wbuf_chunk_t *c;
+  void *p;
+
+  tvh_mutex_lock(&muxer_wbuf_lock);
+  c = TAILQ_FIRST(&wb->wb_free);
+  if (c)
+    TAILQ_REMOVE(&wb->wb_free, c, link);
+  tvh_mutex_unlock(&muxer_wbuf_lock);
+  if (c == NULL) {
+    if (posix_memalign(&p, MUXER_WBUF_ALIGN, wb->wb_chunk))
+      return NULL;
+    c = malloc(sizeof(*c));
+    if (c == NULL) {
+      free(p);
+      return NULL;
+    }
+    c->data = p;
+    memoryinfo_alloc(&muxer_wbuf_memoryinfo, sizeof(*c) + wb->wb_chunk);
+  }
+  c->len = 0;
+  return c;
+}
+
+/**
+ *
+ */
+static void
+muxer_wbuf_chunk_free(muxer_wbuf_t *wb, muxer_wbuf_chunk_t *c)
+{
+  memoryinfo_free(&muxer_wbuf_memoryinfo, sizeof(*c) + wb->wb_chunk);
+  free(c->data);
+  free(c);
+}
+
+/**
+ * Write all queued chunks of one file, the lock must be held
+ */
+static void
+muxer_wbuf_flush(muxer_wbuf_t *wb, tvhio_t *io, tvhio_req_t *reqs)
+{
+  struct muxer_wbuf_chunk_queue q;
+  muxer_wbuf_chunk_t *c;
+  uint32_t depth = 0;
+  size_t total = 0;
+  off_t off = wb->wb_off;
+  int64_t t;
+  int err = wb->wb_error, n = 0;
+
+  TAILQ_INIT(&q);
+  while ((c = TAILQ_FIRST(&wb->wb_queue)) != NULL &&
+         n < MUXER_WBUF_MAX_REQS - 2) {
+    TAILQ_REMOVE(&wb->wb_queue, c, link);
+    TAILQ_INSERT_TAIL(&q, c, link);
+    n++;
+  }
+  tvh_mutex_unlock(&muxer_wbuf_lock);
+
+  /* one batch: the writes followed by the cache scheme calls */
+  n = 0;
+  TAILQ_FOREACH(c, &q, link) {
+    tvhio_req(&reqs[n++], TVHIO_WRITE, wb->wb_fd, c->data, c->len, off + total);
+    total += c->len;
+    depth++;
+  }
+  if (wb->wb_cache == MC_CACHE_SYNC || wb->wb_cache == MC_CACHE_SYNCDONTKEEP)
+    tvhio_req(&reqs[n++], TVHIO_FDATASYNC, wb->wb_fd, NULL, 0, 0);
+  if (wb->wb_cache == MC_CACHE_DONTKEEP || wb->wb_cache == MC_CACHE_SYNCDONTKEEP)
+    tvhio_req(&reqs[n++], TVHIO_DONTNEED, wb->wb_fd, NULL, total, off);
+
+  t = getmonoclock();
+  if (!err)
+    err = -tvhio_submit(io, reqs, n);
+  t = getmonoclock() - t;
+
+  tvh_mutex_lock(&muxer_wbuf_lock);
+  if (err && !wb->wb_error) {
+    wb->wb_error = err;
+    tvherror(LS_MUXER, "%s: Write failed -- %s", wb->wb_name, strerror(err));
+  }
+  wb->wb_off += total;
+  wb->wb_queued -= total;
+  wb->wb_depth -= depth;
+  wb->wb_latency = t;
+  if (t > wb->wb_latency_max)
+    wb->wb_latency_max = t;
+  TAILQ_CONCAT(&wb->wb_free, &q, link);
+}
+
+/**
+ *
+ */
+static void *
+muxer_wbuf_thread(void *aux)
+{
+  muxer_wbuf_t *wb;
+  tvhio_t *io = tvhio_create(MUXER_WBUF_MAX_REQS);
+  tvhio_req_t *reqs = malloc(MUXER_WBUF_MAX_REQS * sizeof(*reqs));
+
+  tvhdebug(LS_MUXER, "write-behind thread uses %s file I/O", tvhio_backend(io));
+  tvh_mutex_lock(&muxer_wbuf_lock);
+  while (muxer_wbuf_running || TAILQ_FIRST(&muxer_wbuf_work)) {
+    wb = TAILQ_FIRST(&muxer_wbuf_work);
+    if (wb == NULL) {
+      tvh_cond_wait(&muxer_wbuf_cond, &muxer_wbuf_lock);
+      continue;
+    }
+    TAILQ_REMOVE(&muxer_wbuf_work, wb, wb_link);
+    muxer_wbuf_flush(wb, io, reqs);
+    if (TAILQ_FIRST(&wb->wb_queue))
+      TAILQ_INSERT_TAIL(&muxer_wbuf_work, wb, wb_link);
+    else
+      wb->wb_scheduled = 0;
+    tvh_cond_signal(&muxer_wbuf_done_cond, 1);
+  }
+  tvh_mutex_unlock(&muxer_wbuf_lock);
+  free(reqs);
+  tvhio_destroy(io);
+  return NULL;
+}
+
+/**
+ * Hand the current chunk to the I/O threads
+ */
+static int
+muxer_wbuf_queue(muxer_wbuf_t *wb)
+{
+  muxer_wbuf_chunk_t *c = wb->wb_cur;
+  int err;
+
+  wb->wb_cur = NULL;
+  tvh_mutex_lock(&muxer_wbuf_lock);
+  while (!wb->wb_error && wb->wb_queued > 0 &&
+         wb->wb_queued + c->len > wb->wb_limit)
+    tvh_cond_wait(&muxer_wbuf_done_cond, &muxer_wbuf_lock);
+  /* an I/O thread might still flush this file, do not write at its offset */
+  if (!atomic_get(&muxer_wbuf_running))
+    while (wb->wb_scheduled)
+      tvh_cond_wait(&muxer_wbuf_done_cond, &muxer_wbuf_lock);
+  if ((err = wb->wb_error) == 0) {
+    TAILQ_INSERT_TAIL(&wb->wb_queue, c, link);
+    wb->wb_queued += c->len;
+    wb->wb_depth++;
+    if (!atomic_get(&muxer_wbuf_running)) {
+      /* the I/O threads are gone, write synchronously */
+      tvhio_req_t reqs[MUXER_WBUF_MAX_REQS];
+      muxer_wbuf_flush(wb, NULL, reqs);
+      err = wb->wb_error;
+    } else if (!wb->wb_scheduled) {
+      wb->wb_scheduled = 1;
+      TAILQ_INSERT_TAIL(&muxer_wbuf_work, wb, wb_link);
+      tvh_cond_signal(&muxer_wbuf_cond, 0);
+    }
+  } else {
+    TAILQ_INSERT_TAIL(&wb->wb_free, c, link);
+  }
+  tvh_mutex_unlock(&muxer_wbuf_lock);
+  return err;
+}
+
+/**
+ * Create the write-behind buffer for a file opened at offset zero,
+ * returns NULL when the buffered writes cannot be used
+ */
+muxer_wbuf_t *
+muxer_wbuf_create(int fd, int cache, int size, const char *name)
+{
+  muxer_wbuf_t *wb;
+  size_t chunk;
+
+  if (size <= 0 || !atomic_get(&muxer_wbuf_running))
+    return NULL;
+  if (size > MUXER_WBUF_MAX_SIZE)
+    size = MUXER_WBUF_MAX_SIZE;
+
+  /* at least four chunks in flight, keep the write size aligned */
+  chunk = ((size_t)size * 1024 * 1024) / 4;
+  chunk = MINMAX(chunk, MUXER_WBUF_MIN_CHUNK, MUXER_WBUF_MAX_CHUNK);
+  chunk &= ~((size_t)MUXER_WBUF_ALIGN - 1);
+
+  wb = calloc(1, sizeof(*wb));
+  TAILQ_INIT(&wb->wb_queue);
+  TAILQ_INIT(&wb->wb_free);
+  wb->wb_name  = strdup(name ?: "");
+  wb->wb_fd    = fd;
+  wb->wb_cache = cache;
+  wb->wb_chunk = chunk;
+  wb->wb_limit = (size_t)size * 1024 * 1024;
+  wb->wb_off   = lseek(fd, 0, SEEK_CUR);
+  if (wb->wb_off < 0)
+    wb->wb_off = 0;
+  tvhdebug(LS_MUXER, "%s: write-behind buffer %dMB (chunk %zu bytes)",
+           wb->wb_name, size, chunk);
+  return wb;
+}
+
+/**
+ * Append data, returns the errno value of a failed background write
+ */
+int
+muxer_wbuf_write(muxer_wbuf_t *wb, const void *data, size_t len)
+{
+  const uint8_t *p = data;
+  size_t l;
+  int err;
+
+  while (len > 0) {
+    if (wb->wb_cur == NULL) {
+      if ((wb->wb_cur = muxer_wbuf_chunk_alloc(wb)) == NULL)
+        return ENOMEM;
+    }
+    l = MIN(len, wb->wb_chunk - wb->wb_cur->len);
+    memcpy(wb->wb_cur->data + wb->wb_cur->len, p, l);
+    wb->wb_cur->len += l;
+    p += l;
+    len -= l;
+    if (wb->wb_cur->len == wb->wb_chunk)
+      if ((err = muxer_wbuf_queue(wb)) != 0)
+        return err;
+  }
+  return 0;
+}
+
+/**
+ * Flush everything to the disk and free the buffer
+ */
+int
+muxer_wbuf_destroy(muxer_wbuf_t *wb)
+{
+  muxer_wbuf_chunk_t *c;
+  int err = 0;
+
+  if (wb->wb_cur) {
+    if (wb->wb_cur->len > 0)
+      err = muxer_wbuf_queue(wb);
+    else
+      TAILQ_INSERT_TAIL(&wb->wb_free, wb->wb_cur, link);
+    wb->wb_cur = NULL;
+  }
+  tvh_mutex_lock(&muxer_wbuf_lock);
+  while (wb->wb_scheduled)
+    tvh_cond_wait(&muxer_wbuf_done_cond, &muxer_wbuf_lock);
+  if (!err)
+    err = wb->wb_error;
+  tvh_mutex_unlock(&muxer_wbuf_lock);
+  while ((c = TAILQ_FIRST(&wb->wb_free)) != NULL) {
+    TAILQ_REMOVE(&wb->wb_free, c, link);
+    muxer_wbuf_chunk_free(wb, c);
+  }
+  tvhdebug(LS_MUXER, "%s: write-behind buffer closed, max latency %"PRId64" ms",
+           wb->wb_name, wb->wb_latency_max / 1000);
+  free(wb->wb_name);
+  free(wb);
+  return err;
+}
+
+/**
+ * Queue depth (chunks waiting for write) and the last flush latency (us)
+ */
+void
+muxer_wbuf_stats(muxer_wbuf_t *wb, uint32_t *depth, int64_t *latency)
+{
+  tvh_mutex_lock(&muxer_wbuf_lock);
+  *depth = wb->wb_depth;
+  *latency = wb->wb_latency;
+  tvh_mutex_unlock(&muxer_wbuf_lock);
+}
+
+/**
+ *
+ */
+void
+muxer_wbuf_init(void)
+{
+  memoryinfo_register(&muxer_wbuf_memoryinfo);
+  TAILQ_INIT(&muxer_wbuf_work);
+  tvh_mutex_init(&muxer_wbuf_lock, NULL);
+  tvh_cond_init(&muxer_wbuf_cond, 1);
+  tvh_cond_init(&muxer_wbuf_done_cond, 1);
+  atomic_set(&muxer_wbuf_running, 1);
+  for ( ; muxer_wbuf_threads < MUXER_WBUF_THREADS; muxer_wbuf_threads++)
+    if (tvh_thread_create(&muxer_wbuf_tid[muxer_wbuf_threads], NULL,
+                          muxer_wbuf_thread, NULL, "muxer-io"))
+      break;
+  if (muxer_wbuf_threads == 0)
+    atomic_set(&muxer_wbuf_running, 0);
+}
+
+/**
+ *
+ */
+void
+muxer_wbuf_done(void)
+{
+  int i;
+
+  tvh_mutex_lock(&muxer_wbuf_lock);
+  atomic_set(&muxer_wbuf_running, 0);
+  tvh_cond_signal(&muxer_wbuf_cond, 1);
+  tvh_mutex_unlock(&muxer_wbuf_lock);
+  for (i = 0; i < muxer_wbuf_threads; i++)
+    pthread_join(muxer_wbuf_tid[i], NULL);
+  muxer_wbuf_threads = 0;
+  tvh_cond_destroy(&muxer_wbuf_done_cond);
+  tvh_cond_destroy(&muxer_wbuf_cond);
+  tvh_mutex_destroy(&muxer_wbuf_lock);
+  tvh_mutex_lock(&global_lock);
+  memoryinfo_unregister(&muxer_wbuf_memoryinfo);
+  tvh_mutex_unlock(&global_lock);
+}
@@ -45,6 +45,7 @@ void
 notify_reload(const char *class)
 {
   htsmsg_t *m = htsmsg_create_map();
+  webui_api_cache_invalidate(class);
   htsmsg_add_u32(m, "reload", 1);
   notify_by_msg(class, m, 0);
 }
@@ -58,6 +59,8 @@ notify_delayed(const char *id, const char *event, const char *action)
   if (!tvheadend_is_running())
     return;
 
+  webui_api_cache_invalidate(event);
+
   tvh_mutex_lock(&notify_mutex);
   if (notify_queue == NULL) {
     notify_queue = htsmsg_create_map();
@@ -31,6 +31,9 @@
 memoryinfo_t pkt_memoryinfo = { .my_name = "Packets" };
 memoryinfo_t pktbuf_memoryinfo = { .my_name = "Packet buffers" };
 memoryinfo_t pktref_memoryinfo = { .my_name = "Packet references" };
+memoryinfo_t pktbuf_slice_memoryinfo = { .my_name = "Packet buffer slices" };
+/* cumulative: the size is the total of copied bytes, count the copies */
+memoryinfo_t pktbuf_copy_memoryinfo = { .my_name = "Packet data copies" };
 
 /*
  *
@@ -333,8 +336,13 @@ void
 pktbuf_destroy(pktbuf_t *pb)
 {
   if (pb) {
-    memoryinfo_free(&pktbuf_memoryinfo, sizeof(*pb) + pb->pb_size);
-    free(pb->pb_data);
+    if (pb->pb_parent) {
+      memoryinfo_free(&pktbuf_slice_memoryinfo, pb->pb_size);
+      pktbuf_ref_dec(pb->pb_parent);
+    } else {
+      memoryinfo_free(&pktbuf_memoryinfo, sizeof(*pb) + pb->pb_size);
+      free(pb->pb_data);
+    }
     free(pb);
   }
 }
@@ -343,11 +351,8 @@ void
 pktbuf_ref_dec(pktbuf_t *pb)
 {
   if (pb) {
-    if((atomic_add(&pb->pb_refcount, -1)) == 1) {
-      memoryinfo_free(&pktbuf_memoryinfo, sizeof(*pb) + pb->pb_size);
-      free(pb->pb_data);
-      free(pb);
-    }
+    if((atomic_add(&pb->pb_refcount, -1)) == 1)
+      pktbuf_destroy(pb);
   }
 }
 
@@ -369,8 +374,10 @@ pktbuf_alloc(const uint8_t *data, size_t size)
 
   buffer = size > 0 ? malloc(size) : NULL;
   if (buffer) {\
-    if (data != NULL)
+    if (data != NULL) {
       memcpy(buffer, data, size);
+      memoryinfo_alloc(&pktbuf_copy_memoryinfo, size);
+    }
   } else if (size > 0) {
     return NULL;
   }
@@ -383,6 +390,7 @@ pktbuf_alloc(const uint8_t *data, size_t size)
   pb->pb_data = buffer;
   pb->pb_size = size;
   pb->pb_err = 0;
+  pb->pb_parent = NULL;
   memoryinfo_alloc(&pktbuf_memoryinfo, sizeof(*pb) + size);
   return pb;
 }
@@ -395,6 +403,8 @@ pktbuf_make(void *data, size_t size)
     pb->pb_refcount = 1;
     pb->pb_size = size;
     pb->pb_data = data;
+    pb->pb_err = 0;
+    pb->pb_parent = NULL;
     memoryinfo_alloc(&pktbuf_memoryinfo, sizeof(*pb) + pb->pb_size);
   }
   return pb;
@@ -403,15 +413,50 @@ pktbuf_make(void *data, size_t size)
 pktbuf_t *
 pktbuf_append(pktbuf_t *pb, const void *data, size_t size)
 {
+  pktbuf_t *npb;
   void *ndata;
   if (pb == NULL)
     return pktbuf_alloc(data, size);
+  if (pb->pb_parent) {
+    npb = pktbuf_alloc(NULL, pb->pb_size + size);
+    if (npb == NULL)
+      return pb;
+    memcpy(npb->pb_data, pb->pb_data, pb->pb_size);
+    memcpy(npb->pb_data + pb->pb_size, data, size);
+    memoryinfo_alloc(&pktbuf_copy_memoryinfo, pb->pb_size + size);
+    npb->pb_err = pb->pb_err;
+    pktbuf_ref_dec(pb);
+    return npb;
+  }
   ndata = realloc(pb->pb_data, pb->pb_size + size);
   if (ndata) {
     pb->pb_data = ndata;
     memcpy(ndata + pb->pb_size, data, size);
     pb->pb_size += size;
     memoryinfo_append(&pktbuf_memoryinfo, size);
+    memoryinfo_alloc(&pktbuf_copy_memoryinfo, size);
+  }
+  return pb;
+}
+
+/*
+ * Reference a part of the parent buffer without copying the data
+ */
+pktbuf_t *
+pktbuf_slice(pktbuf_t *parent, const uint8_t *data, size_t size)
+{
+  pktbuf_t *pb;
+
+  assert(data >= parent->pb_data &&
+         data + size <= parent->pb_data + parent->pb_size);
+  pb = malloc(sizeof(pktbuf_t));
+  if (pb) {
+    pb->pb_refcount = 1;
+    pb->pb_err = 0;
+    pb->pb_data = (uint8_t *)data;
+    pb->pb_size = size;
+    pb->pb_parent = pktbuf_ref_inc(parent);
+    memoryinfo_alloc(&pktbuf_slice_memoryinfo, size);
   }
   return pb;
 }
@@ -31,6 +31,7 @@ typedef struct pktbuf {
   int pb_err;
   uint8_t *pb_data;
   size_t pb_size;
+  struct pktbuf *pb_parent;   /* pb_data points into the parent buffer */
 } pktbuf_t;
 
 /**
@@ -98,6 +99,8 @@ TAILQ_HEAD(th_pktref_queue, th_pktref);
 extern struct memoryinfo pkt_memoryinfo;
 extern struct memoryinfo pktbuf_memoryinfo;
 extern struct memoryinfo pktref_memoryinfo;
+extern struct memoryinfo pktbuf_slice_memoryinfo;
+extern struct memoryinfo pktbuf_copy_memoryinfo;
 
 /**
  *
@@ -163,6 +166,8 @@ pktbuf_t *pktbuf_make(void *data, size_t size);
 
 pktbuf_t *pktbuf_append(pktbuf_t *pb, const void *data, size_t size);
 
+pktbuf_t *pktbuf_slice(pktbuf_t *parent, const uint8_t *data, size_t size);
+
 static inline size_t   pktbuf_len(pktbuf_t *pb) { return pb ? pb->pb_size : 0; }
 static inline uint8_t *pktbuf_ptr(pktbuf_t *pb) { return pb->pb_data; }
 
@@ -18,6 +18,17 @@
 
 #include <stdio.h>
 #include <inttypes.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BS_AVX2_DISPATCH 1
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 #include "bitstream.h"
 
 
@@ -143,3 +154,162 @@ put_bits(bitstream_t *bs, uint32_t val, uint32_t num)
     bs->offset++;
   }
 }
+
+
+/*
+ * Start code (00 00 01) scanner
+ *
+ * The vector loops compare the block at p, p+1 and p+2 against 00, 00, 01,
+ * so every bit set in the resulting mask is a complete start code.
+ */
+
+static inline const uint8_t *
+bs_find_startcode_c(const uint8_t *p, const uint8_t *end)
+{
+  uint32_t x;
+
+  for ( ; end - p >= 6; p += 4) {
+    memcpy(&x, p, 4);
+    if (((x - 0x01010101) & ~x & 0x80808080) == 0)
+      continue;
+    if (p[1] == 0) {
+      if (p[0] == 0 && p[2] == 1)
+        return p;
+      if (p[2] == 0 && p[3] == 1)
+        return p + 1;
+    }
+    if (p[3] == 0) {
+      if (p[2] == 0 && p[4] == 1)
+        return p + 2;
+      if (p[4] == 0 && p[5] == 1)
+        return p + 3;
+    }
+  }
+  for ( ; end - p >= 3; p++)
+    if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+      return p;
+  return end;
+}
+
+#if BS_AVX2_DISPATCH
+__attribute__((target("avx2")))
+static const uint8_t *
+bs_find_startcode_avx2(const uint8_t *p, const uint8_t *end)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi8(1);
+  __m256i a, b, c;
+  uint32_t m;
+
+  for ( ; end - p >= 34; p += 32) {
+    a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), zero);
+    b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 1)), zero);
+    c = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 2)), one);
+    m = _mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(a, b), c));
+    if (m)
+      return p + __builtin_ctz(m);
+  }
+  return bs_find_startcode_c(p, end);
+}
+#endif
+
+static const uint8_t *
+bs_find_startcode_simd(const uint8_t *p, const uint8_t *end)
+{
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi8(1);
+  __m128i a, b, c;
+  uint32_t m;
+
+  for ( ; end - p >= 18; p += 16) {
+    a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), zero);
+    b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 1)), zero);
+    c = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 2)), one);
+    m = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(a, b), c));
+    if (m)
+      return p + __builtin_ctz(m);
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  const uint8x16_t zero = vdupq_n_u8(0);
+  const uint8x16_t one = vdupq_n_u8(1);
+  uint8x16_t v;
+  uint64x2_t m;
+
+  for ( ; end - p >= 18; p += 16) {
+    v = vandq_u8(vandq_u8(vceqq_u8(vld1q_u8(p), zero),
+                          vceqq_u8(vld1q_u8(p + 1), zero)),
+                 vceqq_u8(vld1q_u8(p + 2), one));
+    m = vreinterpretq_u64_u8(v);
+    if ((vgetq_lane_u64(m, 0) | vgetq_lane_u64(m, 1)) == 0)
+      continue;
+    break;
+  }
+#endif
+  return bs_find_startcode_c(p, end);
+}
+
+static const uint8_t *(*bs_find_startcode_fcn)
+  (const uint8_t *p, const uint8_t *end);
+
+/**
+ * Returns the first 00 00 01 sequence in the [p, end) range or end
+ */
+const uint8_t *
+bs_find_startcode(const uint8_t *p, const uint8_t *end)
+{
+  const uint8_t *(*fcn)(const uint8_t *, const uint8_t *);
+
+  fcn = __atomic_load_n(&bs_find_startcode_fcn, __ATOMIC_RELAXED);
+  if (fcn == NULL) {
+    fcn = bs_find_startcode_simd;
+#if BS_AVX2_DISPATCH
+    if (__builtin_cpu_supports("avx2"))
+      fcn = bs_find_startcode_avx2;
+#endif
+    __atomic_store_n(&bs_find_startcode_fcn, fcn, __ATOMIC_RELAXED);
+  }
+  return fcn(p, end);
+}
+
+/**
+ * Shift data[i..len) to the start code state 'sc' (it holds the preceding
+ * bytes, also from the previous blocks) until a start code is found.
+ * Returns the index after the start code or -1, the state is the same
+ * as from the byte-by-byte loop.
+ */
+int
+bs_scan_startcode(const uint8_t *data, int i, int len, uint_fast32_t *_sc)
+{
+  uint_fast32_t sc = *_sc;
+  const uint8_t *d;
+  int j = i, k;
+
+  /* start code spanning the previous data */
+  for ( ; i < len && i - j < 3; ) {
+    sc = (sc << 8) | data[i++];
+    if ((sc & 0xffffff00) == 0x00000100)
+      goto found;
+  }
+
+  /* quick scan, there is no start code in data[j..d), the state is
+     rebuilt from the contiguous bytes before d (the 0xff filler
+     cannot form a start code) */
+  d = bs_find_startcode(data + j, data + len);
+  k = d - data - 8;
+  if (k > i) {
+    i = k;
+    sc = ~(uint_fast32_t)0;
+  }
+  for ( ; i < len; ) {
+    sc = (sc << 8) | data[i++];
+    if ((sc & 0xffffff00) == 0x00000100)
+      goto found;
+  }
+  *_sc = sc;
+  return -1;
+
+found:
+  *_sc = sc;
+  return i;
+}
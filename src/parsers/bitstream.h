@@ -69,6 +69,10 @@ RB24(const uint8_t *d)
   return (d[0] << 16) | (d[1] << 8) | d[2];
 }
 
+const uint8_t *bs_find_startcode(const uint8_t *p, const uint8_t *end);
+
+int bs_scan_startcode(const uint8_t *data, int i, int len, uint_fast32_t *sc);
+
 #define RB16(x) ((((const uint8_t*)(x))[0] << 8) | ((const uint8_t*)(x))[1])
 
 #endif /* BITSTREAM_H_ */
@@ -321,6 +321,54 @@ static void parser_input_start(parser_t *prs, streaming_message_t *sm)
   }
 }
 
+/**
+ * GOP cache, keeps the packets from the last video I-frame onward
+ */
+#define PARSER_GOP_MAX_BYTES    (8*1024*1024)
+#define PARSER_GOP_MAX_DURATION (10*90000)
+
+static void
+parser_gop_clear(parser_t *prs)
+{
+  pktref_clear_queue(&prs->prs_gop);
+  prs->prs_gop_bytes = 0;
+  prs->prs_gop_packets = 0;
+}
+
+static void
+parser_gop_add(parser_t *prs, th_pkt_t *pkt)
+{
+  th_pkt_t *first;
+
+  if (SCT_ISVIDEO(pkt->pkt_type) && pkt->v.pkt_frametype == PKT_I_FRAME &&
+      (prs->prs_gop_index < 0 ||
+       prs->prs_gop_index == pkt->pkt_componentindex)) {
+    parser_gop_clear(prs);
+    prs->prs_gop_index = pkt->pkt_componentindex;
+  } else if ((first = pktref_first(&prs->prs_gop)) == NULL) {
+    /* wait for the next I-frame */
+    return;
+  } else if (prs->prs_gop_bytes > PARSER_GOP_MAX_BYTES ||
+             pts_diff(first->pkt_dts, pkt->pkt_dts) > PARSER_GOP_MAX_DURATION) {
+    tvhtrace(LS_PARSER, "%s: GOP cache overflow (%d packets, %zu bytes)",
+             service_nicename(prs->prs_service),
+             prs->prs_gop_packets, prs->prs_gop_bytes);
+    parser_gop_clear(prs);
+    return;
+  }
+  pkt_ref_inc(pkt);
+  pktref_enqueue(&prs->prs_gop, pkt);
+  prs->prs_gop_bytes += pktbuf_len(pkt->pkt_payload);
+  prs->prs_gop_packets++;
+}
+
+static void
+parser_gop_reset(parser_t *prs)
+{
+  parser_gop_clear(prs);
+  prs->prs_gop_index = -1;
+}
+
 /**
  *
  */
@@ -328,15 +376,27 @@ static void
 parser_input(void *opaque, streaming_message_t *sm)
 {
   parser_t *prs = opaque;
+  pktbuf_t *pb;
+  int64_t t;
 
   switch(sm->sm_type) {
   case SMT_MPEGTS:
-    parser_input_mpegts(prs, (pktbuf_t *)sm->sm_data);
+    pb = sm->sm_data;
+    t = getmonoclock();
+    streaming_batch_begin();
+    parser_input_mpegts(prs, pb);
+    streaming_batch_end();
+    prs->prs_parse_time += getmonoclock() - t;
+    prs->prs_parse_bytes += pktbuf_len(pb);
     streaming_msg_free(sm);
     break;
   case SMT_START:
+    parser_gop_reset(prs);
     parser_input_start(prs, sm);
     break;
+  case SMT_STOP:
+    parser_gop_reset(prs);
+    /* fall through */
   default:
     streaming_target_deliver2(prs->prs_output, sm);
     break;
@@ -352,49 +412,161 @@ parser_input_info(void *opaque, htsmsg_t *list)
   return st->st_ops.st_info(st->st_opaque, list);
 }
 
+static int
+parser_input_pressure(void *opaque, streaming_pressure_t *bp)
+{
+  parser_t *prs = opaque;
+  return streaming_target_pressure(prs->prs_output, bp);
+}
+
 static streaming_ops_t parser_input_ops = {
-  .st_cb   = parser_input,
-  .st_info = parser_input_info
+  .st_cb       = parser_input,
+  .st_info     = parser_input_info,
+  .st_pressure = parser_input_pressure
 };
 
 /**
- * Parser get output target
+ * Join latency, the subscription joins at the first video I-frame
+ * (or at the first packet for the services without video)
  */
-streaming_target_t *
-parser_output(streaming_target_t *pad)
+static void
+parser_tap_join(parser_tap_t *pt, th_pkt_t *pkt)
 {
-  return ((parser_t *)pad)->prs_output;
+  elementary_stream_t *es;
+
+  if (!SCT_ISVIDEO(pkt->pkt_type)) {
+    TAILQ_FOREACH(es, &pt->pt_parser->prs_components.set_filter, es_filter_link)
+      if (SCT_ISVIDEO(es->es_type))
+        return;
+  } else if (pkt->v.pkt_frametype != PKT_I_FRAME) {
+    return;
+  }
+  pt->pt_subscription->ths_join_latency = MAX(getmonoclock() - pt->pt_join_start, 1);
+  pt->pt_join_start = 0;
 }
 
 /**
- * Parser create
+ * Shared parser output, the packets are passed to all started subscribers,
+ * the control messages are delivered through the subscriptions
  */
-streaming_target_t *
-parser_create(streaming_target_t *output, th_subscription_t *ts)
+static void
+parser_fanout(void *opaque, streaming_message_t *sm)
+{
+  parser_t *prs = opaque;
+  parser_tap_t *pt;
+  th_pkt_t *pkt;
+
+  if (sm->sm_type == SMT_PACKET) {
+    pkt = sm->sm_data;
+    if (prs->prs_gop_users)
+      parser_gop_add(prs, pkt);
+    LIST_FOREACH(pt, &prs->prs_taps, pt_link)
+      if (pt->pt_started) {
+        if (pt->pt_join_start)
+          parser_tap_join(pt, pkt);
+        streaming_target_deliver2(pt->pt_output, streaming_msg_create_pkt(pkt));
+      }
+  }
+  streaming_msg_free(sm);
+}
+
+static htsmsg_t *
+parser_fanout_info(void *opaque, htsmsg_t *list)
+{
+  htsmsg_add_str(list, NULL, "parser shared output");
+  return list;
+}
+
+static streaming_ops_t parser_fanout_ops = {
+  .st_cb   = parser_fanout,
+  .st_info = parser_fanout_info
+};
+
+/**
+ * Subscription input for the shared parser
+ */
+static void
+parser_tap_input(void *opaque, streaming_message_t *sm)
+{
+  parser_tap_t *pt = opaque;
+
+  switch(sm->sm_type) {
+  case SMT_MPEGTS:
+    /* parsed once by the shared parser */
+    streaming_msg_free(sm);
+    return;
+  case SMT_START:
+    pt->pt_started = 1;
+    break;
+  case SMT_STOP:
+    pt->pt_started = 0;
+    break;
+  default:
+    break;
+  }
+  streaming_target_deliver2(pt->pt_output, sm);
+}
+
+static htsmsg_t *
+parser_tap_input_info(void *opaque, htsmsg_t *list)
+{
+  parser_tap_t *pt = opaque;
+  streaming_target_t *st = pt->pt_output;
+  htsmsg_add_str(list, NULL, "parser shared input");
+  return st->st_ops.st_info(st->st_opaque, list);
+}
+
+static int
+parser_tap_input_pressure(void *opaque, streaming_pressure_t *bp)
+{
+  parser_tap_t *pt = opaque;
+  return streaming_target_pressure(pt->pt_output, bp);
+}
+
+static streaming_ops_t parser_tap_input_ops = {
+  .st_cb       = parser_tap_input,
+  .st_info     = parser_tap_input_info,
+  .st_pressure = parser_tap_input_pressure
+};
+
+/**
+ *
+ */
+static parser_t *
+parser_alloc(streaming_target_t *output, th_subscription_t *ts, service_t *t)
 {
   parser_t *prs = calloc(1, sizeof(parser_t));
-  service_t *t = ts->ths_service;
 
   prs->prs_output = output;
   prs->prs_subscription = ts;
   prs->prs_service = t;
   TAILQ_INIT(&prs->prs_rstlog);
+  LIST_INIT(&prs->prs_taps);
+  TAILQ_INIT(&prs->prs_gop);
+  prs->prs_gop_index = -1;
   elementary_set_init(&prs->prs_components, LS_PARSER, service_nicename(t), t);
   streaming_target_init(&prs->prs_input, &parser_input_ops, prs, 0);
-  return &prs->prs_input;
-
+  return prs;
 }
 
-/*
- * Parser destroy
+/**
+ *
  */
-void
-parser_destroy(streaming_target_t *pad)
+static void
+parser_free(parser_t *prs)
 {
-  parser_t *prs = (parser_t *)pad;
   elementary_stream_t *es;
   parser_es_t *pes;
+
+  tvhdebug(LS_PARSER, "%s: %sparser done, parsed %"PRId64" kB in %"PRId64" ms"
+                      " (%d subscribers max, %d of %d joins from the GOP cache)",
+           service_nicename(prs->prs_service), prs->prs_shared ? "shared " : "",
+           prs->prs_parse_bytes / 1024, prs->prs_parse_time / 1000,
+           prs->prs_shared ? prs->prs_ntaps_max : 1,
+           prs->prs_gop_hits, prs->prs_gop_joins);
+
   streaming_queue_clear(&prs->prs_rstlog);
+  parser_gop_clear(prs);
 
   TAILQ_FOREACH(es, &prs->prs_components.set_all, es_link) {
     pes = (parser_es_t *)es;
@@ -405,3 +577,160 @@ parser_destroy(streaming_target_t *pad)
   elementary_set_clean(&prs->prs_components, NULL, 0);
   free(prs);
 }
+
+/**
+ * Attach a subscription to the shared parser of the service
+ */
+static streaming_target_t *
+parser_tap_create(streaming_target_t *output, th_subscription_t *ts, int gop)
+{
+  parser_tap_t *pt = calloc(1, sizeof(parser_tap_t));
+  service_t *t = ts->ths_service;
+  parser_t *prs;
+  streaming_start_t *ss;
+
+  pt->pt_output = output;
+  pt->pt_subscription = ts;
+  pt->pt_join_start = getmonoclock();
+  streaming_target_init(&pt->pt_input, &parser_tap_input_ops, pt, 0);
+
+  tvh_mutex_lock(&t->s_stream_mutex);
+  if ((prs = t->s_parser) == NULL) {
+    prs = parser_alloc(NULL, NULL, t);
+    prs->prs_shared = 1;
+    streaming_target_init(&prs->prs_fanout, &parser_fanout_ops, prs, 0);
+    prs->prs_output = &prs->prs_fanout;
+    if (elementary_set_has_streams(&t->s_components, 1)) {
+      ss = service_build_streaming_start(t);
+      parser_input_start(prs, streaming_msg_create_data(SMT_START, ss));
+    }
+    /* the subscriptions are linked later, so they are always served */
+    /* before the parser (START must reach them before the packets) */
+    streaming_target_connect(&t->s_streaming_pad, &prs->prs_input);
+    t->s_parser = prs;
+    tvhdebug(LS_PARSER, "%s: shared parser created", service_nicename(t));
+  }
+  pt->pt_parser = prs;
+  if (gop) {
+    pt->pt_gop = 1;
+    prs->prs_gop_users++;
+  }
+  LIST_INSERT_HEAD(&prs->prs_taps, pt, pt_link);
+  if (++prs->prs_ntaps > prs->prs_ntaps_max)
+    prs->prs_ntaps_max = prs->prs_ntaps;
+  tvh_mutex_unlock(&t->s_stream_mutex);
+  return &pt->pt_input;
+}
+
+/**
+ * Detach a subscription from the shared parser
+ */
+static void
+parser_tap_destroy(parser_tap_t *pt)
+{
+  parser_t *prs = pt->pt_parser;
+  service_t *t = prs->prs_service;
+
+  tvh_mutex_lock(&t->s_stream_mutex);
+  LIST_REMOVE(pt, pt_link);
+  if (pt->pt_gop && --prs->prs_gop_users == 0)
+    parser_gop_reset(prs);
+  if (--prs->prs_ntaps == 0) {
+    streaming_target_disconnect(&t->s_streaming_pad, &prs->prs_input);
+    t->s_parser = NULL;
+  } else {
+    prs = NULL;
+  }
+  tvh_mutex_unlock(&t->s_stream_mutex);
+  if (prs)
+    parser_free(prs);
+  free(pt);
+}
+
+/**
+ * Parser get output target
+ */
+streaming_target_t *
+parser_output(streaming_target_t *pad)
+{
+  if (pad->st_ops.st_cb == parser_tap_input)
+    return ((parser_tap_t *)pad)->pt_output;
+  return ((parser_t *)pad)->prs_output;
+}
+
+/**
+ * Parser create
+ */
+streaming_target_t *
+parser_create(streaming_target_t *output, th_subscription_t *ts)
+{
+  service_t *t = ts->ths_service;
+  int gop = config.parser_gop || (ts->ths_flags & SUBSCRIPTION_HOT) != 0;
+
+  /* join the already running shared parser (hot channels) */
+  if (config.parser_shared || gop || t->s_parser)
+    return parser_tap_create(output, ts, gop);
+  return &parser_alloc(output, ts, t)->prs_input;
+}
+
+/*
+ * Parser destroy
+ */
+void
+parser_destroy(streaming_target_t *pad)
+{
+  if (pad->st_ops.st_cb == parser_tap_input)
+    parser_tap_destroy((parser_tap_t *)pad);
+  else
+    parser_free((parser_t *)pad);
+}
+
+/*
+ * Parser replay the GOP cache to a just started subscription
+ *
+ * The stream mutex must be held, so the cache is consistent with
+ * the next packet delivered by the shared parser.
+ */
+int
+parser_replay(streaming_target_t *pad)
+{
+  parser_tap_t *pt;
+  parser_t *prs;
+  th_pktref_t *pr;
+
+  if (pad->st_ops.st_cb != parser_tap_input)
+    return 0;
+  pt = (parser_tap_t *)pad;
+  prs = pt->pt_parser;
+  if (!pt->pt_started || !prs->prs_gop_users || !prs->prs_parse_bytes)
+    return 0;
+  lock_assert(&prs->prs_service->s_stream_mutex);
+  prs->prs_gop_joins++;
+  if (TAILQ_EMPTY(&prs->prs_gop))
+    return 0;
+  prs->prs_gop_hits++;
+  streaming_batch_begin();
+  TAILQ_FOREACH(pr, &prs->prs_gop, pr_link) {
+    pkt_trace(LS_PARSER, pr->pr_pkt, "deliver from GOP cache");
+    if (pt->pt_join_start)
+      parser_tap_join(pt, pr->pr_pkt);
+    streaming_target_deliver2(pt->pt_output, streaming_msg_create_pkt(pr->pr_pkt));
+  }
+  streaming_batch_end();
+  pt->pt_subscription->ths_gop_replayed = prs->prs_gop_packets;
+  tvhdebug(LS_PARSER, "%s: GOP cache replayed (%d packets, %zu bytes)",
+           service_nicename(prs->prs_service),
+           prs->prs_gop_packets, prs->prs_gop_bytes);
+  return prs->prs_gop_packets;
+}
+
+/*
+ * Percentage of the joins started from the GOP cache, -1 if unknown
+ */
+int
+parser_gop_hit_rate(parser_t *prs)
+{
+  if (prs->prs_gop_joins == 0)
+    return -1;
+  return (prs->prs_gop_hits * 100) / prs->prs_gop_joins;
+}
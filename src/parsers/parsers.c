@@ -27,6 +27,7 @@
 #include "packet.h"
 #include "streaming.h"
 #include "config.h"
+#include "memoryinfo.h"
 
 /* parser states */
 #define PARSER_APPEND 0
@@ -426,15 +427,12 @@ parse_pes(parser_t *t, parser_es_t *st, const uint8_t *data, int len,
 
     /* quick loop to find startcode */
     j = i;
-    do {
-      sc = (sc << 8) | data[i++];
-      if((sc & 0xffffff00) == 0x00000100)
-        goto found;
-    } while (i < len);
-    sbuf_append(&st->es_buf, data + j, len - j);
-    break;
+    i = bs_scan_startcode(data, i, len, &sc);
+    if (i < 0) {
+      sbuf_append(&st->es_buf, data + j, len - j);
+      break;
+    }
 
-found:
     sbuf_append(&st->es_buf, data + j, i - j);
 
     if(sc == 0x100 && (len-i)>2) {
@@ -523,9 +521,79 @@ depacketize(parser_t *t, parser_es_t *st, size_t len,
   st->es_buf_a.sb_err = st->es_buf.sb_err;
 
   sbuf_append(&st->es_buf_a, buf, len);
+  memoryinfo_alloc(&pktbuf_copy_memoryinfo, len);
   return PARSER_APPEND;
 }
 
+/**
+ * Audio frames are delivered in place, the es_buf_a data are handed
+ * over to a packet buffer and the packets reference parts of it
+ */
+static pktbuf_t *
+parser_abuf_slice(parser_es_t *st, const uint8_t *data, int len)
+{
+  sbuf_t *sb = &st->es_buf_a;
+  pktbuf_t *pb;
+
+  if (st->es_buf_a_pb == NULL) {
+    pb = pktbuf_make(sb->sb_data, sb->sb_ptr);
+    if (pb == NULL)
+      return NULL;
+    st->es_buf_a_pb = pb;
+    if (data == sb->sb_data && len == sb->sb_ptr)
+      return pktbuf_ref_inc(pb);
+  }
+  return pktbuf_slice(st->es_buf_a_pb, data, len);
+}
+
+/**
+ * Remove the parsed data from es_buf_a, the rest is moved to a new
+ * buffer when the current one is owned by the delivered packets
+ */
+static void
+parser_abuf_cut(parser_es_t *st, int off)
+{
+  sbuf_t *sb = &st->es_buf_a;
+  pktbuf_t *pb = st->es_buf_a_pb;
+  const uint8_t *data;
+  uint16_t err;
+  int len;
+
+  if (pb == NULL) {
+    sbuf_cut(sb, off);
+    return;
+  }
+  st->es_buf_a_pb = NULL;
+  err = sb->sb_err;
+  data = sb->sb_data + off;
+  len = sb->sb_ptr - off;
+  sbuf_steal_data(sb);
+  if (len > 0) {
+    sbuf_append(sb, data, len);
+    memoryinfo_alloc(&pktbuf_copy_memoryinfo, len);
+  }
+  sb->sb_err = err;
+  pktbuf_ref_dec(pb);
+}
+
+/**
+ * Deliver a part of es_buf as a packet payload without a copy,
+ * es_buf must be reset afterwards
+ */
+static pktbuf_t *
+parser_buf_take(sbuf_t *sb, const uint8_t *data, int len)
+{
+  pktbuf_t *parent, *pb;
+
+  parent = pktbuf_make(sb->sb_data, sb->sb_ptr);
+  if (parent == NULL)
+    return NULL;
+  sbuf_steal_data(sb);
+  pb = pktbuf_slice(parent, data, len);
+  pktbuf_ref_dec(parent);
+  return pb;
+}
+
 /**
  *
  */
@@ -533,8 +601,9 @@ static void
 makeapkt(parser_t *t, parser_es_t *st, const void *buf,
          int len, int64_t dts, int duration, int channels, int sri)
 {
-  th_pkt_t *pkt = pkt_alloc(st->es_type, buf, len, dts, dts, t->prs_current_pcr);
+  th_pkt_t *pkt = pkt_alloc(st->es_type, NULL, 0, dts, dts, t->prs_current_pcr);
 
+  pkt->pkt_payload = parser_abuf_slice(st, buf, len);
   pkt->pkt_commercial = t->prs_tt_commercial_advice;
   pkt->pkt_duration = duration;
   pkt->a.pkt_keyframe = 1;
@@ -586,14 +655,13 @@ mp4a_valid_frame(const uint8_t *buf)
 static void parse_mp4a_data(parser_t *t, parser_es_t *st,
                             int skip_next_check)
 {
-  int i, len;
+  int i, len, off;
   const uint8_t *buf;
 
- again:
   buf = st->es_buf_a.sb_data;
   len = st->es_buf_a.sb_ptr;
 
-  for(i = 0; i < len - 6; i++) {
+  for(i = off = 0; i < len - 6; i++) {
     const uint8_t *p = buf + i;
 
     if(mp4a_valid_frame(p)) {
@@ -616,12 +684,14 @@ static void parse_mp4a_data(parser_t *t, parser_es_t *st,
           int channels = ((p[2] & 0x01) << 2) | ((p[3] & 0xc0) >> 6);
 
           makeapkt(t, st, p, fsize, dts, duration, channels, sri);
-          sbuf_cut(&st->es_buf_a, i + fsize);
-          goto again;
+          i += fsize - 1;
+          off = i + 1;
         }
       }
     }
   }
+  if (off > 0)
+    parser_abuf_cut(st, off);
 }
 
 /**
@@ -718,6 +788,7 @@ parse_aac(parser_t *t, parser_es_t *st, const uint8_t *data,
       latm = 0;
       sbuf_reset(&st->es_buf_a, 4000);
       sbuf_append(&st->es_buf_a, d, muxlen);
+      memoryinfo_alloc(&pktbuf_copy_memoryinfo, muxlen);
       parse_mp4a_data(t, st, 1);
 
       p += muxlen;
@@ -832,7 +903,7 @@ ok:
     }
   }
   assert(i <= st->es_buf_a.sb_ptr);
-  sbuf_cut(&st->es_buf_a, i);
+  parser_abuf_cut(st, i);
 
   return PARSER_RESET;
 }
@@ -1033,7 +1104,7 @@ ok:
       goto again;
     }
   }
-  sbuf_cut(&st->es_buf_a, i);
+  parser_abuf_cut(st, i);
 
   return PARSER_RESET;
 }
@@ -1843,9 +1914,10 @@ parse_subtitles(parser_t *t, parser_es_t *st, const uint8_t *data,
 
     // end_of_PES_data_field_marker
     if(buf[psize - 1] == 0xff) {
-      pkt = pkt_alloc(st->es_type, buf, psize - 1, st->es_curpts, st->es_curdts, t->prs_current_pcr);
+      pkt = pkt_alloc(st->es_type, NULL, 0, st->es_curpts, st->es_curdts, t->prs_current_pcr);
       pkt->pkt_commercial = t->prs_tt_commercial_advice;
       pkt->pkt_err = st->es_buf.sb_err;
+      pkt->pkt_payload = parser_buf_take(&st->es_buf, buf, psize - 1);
       parser_deliver(t, st, pkt);
       sbuf_reset(&st->es_buf, 4000);
     }
@@ -1895,10 +1967,11 @@ parse_teletext(parser_t *t, parser_es_t *st, const uint8_t *data,
   
   if(psize >= 46 && t->prs_current_pcr != PTS_UNSET) {
     teletext_input(t, st, buf, psize);
-    pkt = pkt_alloc(st->es_type, buf, psize,
+    pkt = pkt_alloc(st->es_type, NULL, 0,
                     t->prs_current_pcr, t->prs_current_pcr, t->prs_current_pcr);
     pkt->pkt_commercial = t->prs_tt_commercial_advice;
     pkt->pkt_err = st->es_buf.sb_err;
+    pkt->pkt_payload = parser_buf_take(&st->es_buf, buf, psize);
     parser_deliver(t, st, pkt);
     sbuf_reset(&st->es_buf, 4000);
   }
@@ -27,6 +27,7 @@
 
 typedef struct parser_es parser_es_t;
 typedef struct parser parser_t;
+typedef struct parser_tap parser_tap_t;
 
 struct th_subscription;
 
@@ -52,6 +53,7 @@ struct parser_es {
   int       es_meta_change;
   void     *es_priv;          /* Parser private data */
   sbuf_t    es_buf_a;         /* Audio packet reassembly */
+  struct pktbuf *es_buf_a_pb; /* es_buf_a data referenced by packets */
   uint8_t  *es_global_data;
   int       es_global_data_len;
   struct th_pkt *es_curpkt;
@@ -100,6 +102,38 @@ struct parser {
 
   /* restart_pending log */
   struct streaming_message_queue prs_rstlog;
+
+  /* Shared parser (one per service), see parser_create() */
+  int prs_shared;
+  streaming_target_t prs_fanout;
+  LIST_HEAD(, parser_tap) prs_taps;
+  int prs_ntaps;
+  int prs_ntaps_max;
+
+  /* GOP cache (last video I-frame onward), see parser_replay() */
+  int prs_gop_users;
+  int prs_gop_index;
+  struct th_pktref_queue prs_gop;
+  size_t prs_gop_bytes;
+  int prs_gop_packets;
+  int prs_gop_joins;
+  int prs_gop_hits;
+
+  /* Statistics */
+  int64_t prs_parse_time;
+  int64_t prs_parse_bytes;
+};
+
+/* subscription attachment to the shared parser */
+struct parser_tap {
+  streaming_target_t pt_input;
+  streaming_target_t *pt_output;
+  parser_t *pt_parser;
+  struct th_subscription *pt_subscription;
+  LIST_ENTRY(parser_tap) pt_link;
+  int pt_started;
+  int pt_gop;
+  int64_t pt_join_start;
 };
 
 static inline int64_t
@@ -127,6 +161,10 @@ streaming_target_t * parser_create(streaming_target_t *output, struct th_subscri
 
 void parser_destroy(streaming_target_t *pad);
 
+int parser_replay(streaming_target_t *pad);
+
+int parser_gop_hit_rate(parser_t *prs);
+
 streaming_target_t * parser_output(streaming_target_t *pad);
 
 void parse_mpeg_ts(parser_t *t, parser_es_t *st, const uint8_t *data,
@@ -425,9 +425,17 @@ globalheaders_input_info(void *opaque, htsmsg_t *list)
   return st->st_ops.st_info(st->st_opaque, list);
 }
 
+static int
+globalheaders_input_pressure(void *opaque, streaming_pressure_t *bp)
+{
+  globalheaders_t *gh = opaque;
+  return streaming_target_pressure(gh->gh_output, bp);
+}
+
 static streaming_ops_t globalheaders_input_ops = {
-  .st_cb   = globalheaders_input,
-  .st_info = globalheaders_input_info
+  .st_cb       = globalheaders_input,
+  .st_info     = globalheaders_input_info,
+  .st_pressure = globalheaders_input_pressure
 };
 
 
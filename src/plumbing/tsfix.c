@@ -689,9 +689,17 @@ tsfix_input_info(void *opaque, htsmsg_t *list)
   return st->st_ops.st_info(st->st_opaque, list);
 }
 
+static int
+tsfix_input_pressure(void *opaque, streaming_pressure_t *bp)
+{
+  tsfix_t *tf = opaque;
+  return streaming_target_pressure(tf->tf_output, bp);
+}
+
 static streaming_ops_t tsfix_input_ops = {
-  .st_cb   = tsfix_input,
-  .st_info = tsfix_input_info
+  .st_cb       = tsfix_input,
+  .st_info     = tsfix_input_info,
+  .st_pressure = tsfix_input_pressure
 };
 
 
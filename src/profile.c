@@ -626,12 +626,66 @@ profile_get_htsp_list(htsmsg_t *array, htsmsg_t *filter)
   }
 }
 
+/*
+ * Transcoder ladders put all renditions into one output, each chain
+ * keeps only the components of the rendition it asked for
+ */
+static int
+profile_rendition_skip(profile_chain_t *prch, streaming_start_component_t *ssc)
+{
+  return ssc->ssc_rendition &&
+         ssc->ssc_rendition != MAX(1, prch->prch_rendition);
+}
+
+static streaming_message_t *
+profile_rendition_filter(profile_chain_t *prch, streaming_message_t *sm)
+{
+  profile_sharer_t *prsh = prch->prch_sharer;
+  streaming_start_t *ss;
+  streaming_start_component_t *ssc;
+  th_pkt_t *pkt;
+  int i, j;
+
+  if (!prsh->prsh_renditions)
+    return sm;
+  if (sm->sm_type == SMT_PACKET) {
+    pkt = sm->sm_data;
+    ssc = prsh->prsh_start_msg ?
+            streaming_start_component_find_by_index(prsh->prsh_start_msg,
+                                                    pkt->pkt_componentindex) :
+            NULL;
+    if (ssc && profile_rendition_skip(prch, ssc)) {
+      streaming_msg_free(sm);
+      return NULL;
+    }
+  } else if (sm->sm_type == SMT_START) {
+    ss = streaming_start_copy(sm->sm_data);
+    for (i = j = 0; i < ss->ss_num_components; i++) {
+      ssc = &ss->ss_components[i];
+      if (profile_rendition_skip(prch, ssc)) {
+        if (ssc->ssc_gh)
+          pktbuf_ref_dec(ssc->ssc_gh);
+        continue;
+      }
+      if (i != j)
+        ss->ss_components[j] = *ssc;
+      j++;
+    }
+    ss->ss_num_components = j;
+    streaming_start_unref(sm->sm_data);
+    sm->sm_data = ss;
+  }
+  return sm;
+}
+
 /*
  *
  */
 static void
 profile_deliver(profile_chain_t *prch, streaming_message_t *sm)
 {
+  if (sm && !(sm = profile_rendition_filter(prch, sm)))
+    return;
   if (prch->prch_start_pending) {
     profile_sharer_t *prsh = prch->prch_sharer;
     streaming_message_t *sm2;
@@ -641,6 +695,7 @@ profile_deliver(profile_chain_t *prch, streaming_message_t *sm)
     }
     sm2 = streaming_msg_create_data(SMT_START,
                                    streaming_start_copy(prsh->prsh_start_msg));
+    sm2 = profile_rendition_filter(prch, sm2);
     streaming_target_deliver(prch->prch_post_share, sm2);
     prch->prch_start_pending = 0;
   }
@@ -712,9 +767,17 @@ profile_input_info(void *opaque, htsmsg_t *list)
   return st->st_ops.st_info(st->st_opaque, list);
 }
 
+static int
+profile_input_pressure(void *opaque, streaming_pressure_t *bp)
+{
+  profile_chain_t *prch = opaque;
+  return streaming_target_pressure(prch->prch_post_share, bp);
+}
+
 static streaming_ops_t profile_input_ops = {
-  .st_cb   = profile_input,
-  .st_info = profile_input_info
+  .st_cb       = profile_input,
+  .st_info     = profile_input_info,
+  .st_pressure = profile_input_pressure
 };
 
 /*
@@ -748,8 +811,9 @@ profile_input_queue_info(void *opaque, htsmsg_t *list)
 }
 
 static streaming_ops_t profile_input_queue_ops = {
-  .st_cb   = profile_input_queue,
-  .st_info = profile_input_queue_info
+  .st_cb       = profile_input_queue,
+  .st_info     = profile_input_queue_info,
+  .st_pressure = profile_input_pressure
 };
 
 /*
@@ -794,6 +858,7 @@ profile_sharer_input(void *opaque, streaming_message_t *sm)
 {
   profile_sharer_t *prsh = opaque;
   profile_chain_t *prch, *next, *run = NULL;
+  int i;
 
   if (sm->sm_type == SMT_STOP) {
     if (prsh->prsh_start_msg)
@@ -807,6 +872,10 @@ profile_sharer_input(void *opaque, streaming_message_t *sm)
         if (prsh->prsh_start_msg)
           streaming_start_unref(prsh->prsh_start_msg);
         prsh->prsh_start_msg = streaming_start_copy(sm->sm_data);
+        prsh->prsh_renditions = 0;
+        for (i = 0; i < prsh->prsh_start_msg->ss_num_components; i++)
+          if (prsh->prsh_start_msg->ss_components[i].ssc_rendition)
+            prsh->prsh_renditions = 1;
       }
       if (run)
         profile_sharer_deliver(run, streaming_msg_clone(sm));
@@ -1503,6 +1572,107 @@ profile_mpegts_pass_builder(void)
   return (profile_t *)pro;
 }
 
+/*
+ *  HTTP Live Streaming (segmented MPEG-TS pass-thru)
+ */
+typedef struct profile_hls {
+  profile_mpegts_t;
+  int pro_hls_duration;
+  int pro_hls_segments;
+  int pro_hls_idle;
+} profile_hls_t;
+
+const idclass_t profile_hls_class =
+{
+  .ic_super      = &profile_mpegts_pass_class,
+  .ic_class      = "profile-hls",
+  .ic_caption    = N_("HLS (segmented MPEG-TS)/built-in"),
+  .ic_groups     = (const property_group_t[]) {
+    {
+      .name   = N_("General Settings"),
+      .number = 1,
+    },
+    {
+      .name   = N_("Rewrite MPEG-TS SI Table(s) Settings"),
+      .number = 2,
+    },
+    {
+      .name   = N_("HLS Settings"),
+      .number = 3,
+    },
+    {}
+  },
+  .ic_properties = (const property_t[]){
+    {
+      .type     = PT_INT,
+      .id       = "hls_duration",
+      .name     = N_("Segment duration (sec)"),
+      .desc     = N_("Target duration of one segment. Segments are "
+                     "split on the first video key frame after this "
+                     "duration."),
+      .off      = offsetof(profile_hls_t, pro_hls_duration),
+      .def.i    = 4,
+      .group    = 3
+    },
+    {
+      .type     = PT_INT,
+      .id       = "hls_segments",
+      .name     = N_("Playlist segments"),
+      .desc     = N_("Number of segments announced in the live "
+                     "playlist. Two more segments are kept in memory "
+                     "for slow clients."),
+      .off      = offsetof(profile_hls_t, pro_hls_segments),
+      .def.i    = 6,
+      .group    = 3
+    },
+    {
+      .type     = PT_INT,
+      .id       = "hls_idle",
+      .name     = N_("Idle timeout (sec)"),
+      .desc     = N_("Stop the segmenter (and the subscription) when "
+                     "no client requested a playlist or segment "
+                     "for this time."),
+      .off      = offsetof(profile_hls_t, pro_hls_idle),
+      .opts     = PO_ADVANCED,
+      .def.i    = 30,
+      .group    = 3
+    },
+    { }
+  }
+};
+
+int
+profile_hls_config(profile_t *_pro, int *duration, int *segments, int *idle)
+{
+  profile_hls_t *pro = (profile_hls_t *)_pro;
+
+  if (!idnode_is_instance(&_pro->pro_id, &profile_hls_class))
+    return -1;
+  *duration = MINMAX(pro->pro_hls_duration, 1, 60);
+  *segments = MINMAX(pro->pro_hls_segments, 3, 100);
+  *idle     = MINMAX(pro->pro_hls_idle, 5, 3600);
+  return 0;
+}
+
+static profile_t *
+profile_hls_builder(void)
+{
+  profile_hls_t *pro = calloc(1, sizeof(*pro));
+  pro->pro_sflags = SUBSCRIPTION_MPEGTS;
+  pro->pro_reopen = profile_mpegts_pass_reopen;
+  pro->pro_open   = profile_mpegts_pass_open;
+  pro->pro_rewrite_sid = 1;
+  pro->pro_rewrite_pat = 1;
+  pro->pro_rewrite_pmt = 1;
+  pro->pro_rewrite_sdt = 1;
+  pro->pro_rewrite_nit = 1;
+  pro->pro_rewrite_eit = 1;
+  pro->pro_hls_duration = 4;
+  pro->pro_hls_segments = 6;
+  pro->pro_hls_idle = 30;
+  return (profile_t *)pro;
+}
+
 /*
  *  MPEG-TS spawn muxer
  */
@@ -2246,6 +2416,7 @@ typedef struct profile_transcode {
   profile_t;
   int   pro_mc;
   char *pro_vcodec;
+  int   pro_vrendition;
   char *pro_src_vcodec;
   char *pro_acodec;
   char *pro_src_acodec;
@@ -2484,6 +2655,19 @@ const idclass_t profile_transcode_class =
       .opts     = PO_ADVANCED | PO_DOC_NLIST,
       .group    = 2
     },
+    {
+      .type     = PT_INT,
+      .id       = "pro_vrendition",
+      .name     = N_("Ladder rendition"),
+      .desc     = N_("Rendition to output when the video codec profile "
+                     "is a ladder (1 = first). Streams using the same "
+                     "ladder share one decoder."),
+      .off      = offsetof(profile_transcode_t, pro_vrendition),
+      .intextra = INTEXTRA_RANGE(1, 8, 1),
+      .def.i    = 1,
+      .opts     = PO_ADVANCED,
+      .group    = 2
+    },
     {
       .type     = PT_STR,
       .islist   = 1,
@@ -2556,7 +2740,8 @@ profile_transcode_can_share(profile_chain_t *prch,
     return 0;
   /*
    * Do full params check here, note that profiles might differ
-   * only in the muxer setup.
+   * only in the muxer setup or in the ladder rendition (filtered
+   * per chain in profile_rendition_filter()).
    */
   if (strcmp(pro1->pro_vcodec ?: "", pro2->pro_vcodec ?: ""))
     return 0;
@@ -2588,6 +2773,7 @@ profile_transcode_work(profile_chain_t *prch,
     goto fail;
 
   prch->prch_can_share = profile_transcode_can_share;
+  prch->prch_rendition = pro->pro_vrendition;
 
   profiles[AVMEDIA_TYPE_VIDEO] = pro->pro_vcodec ?: "";
   profiles[AVMEDIA_TYPE_AUDIO] = pro->pro_acodec ?: "";
@@ -2735,6 +2921,7 @@ profile_init(void)
 
   profile_register(&profile_mpegts_pass_class, profile_mpegts_pass_builder);
   profile_register(&profile_mpegts_spawn_class, profile_mpegts_spawn_builder);
+  profile_register(&profile_hls_class, profile_hls_builder);
   profile_register(&profile_matroska_class, profile_matroska_builder);
   profile_register(&profile_htsp_class, profile_htsp_builder);
   profile_register(&profile_audio_class, profile_audio_builder);
@@ -2804,6 +2991,19 @@ transcoder_create:
   }
 #endif
 
+  /* HLS output, the installed data files might predate it */
+  if (profile_find_by_name2("hls", NULL, 1) == NULL) {
+    e = htsmsg_create_map();
+    htsmsg_add_str(e, "class", "profile-hls");
+    htsmsg_add_str(e, "name", "hls");
+    htsmsg_add_str(e, "comment", "HTTP Live Streaming");
+    htsmsg_add_bool(e, "enabled", 1);
+    htsmsg_add_s32(e, "priority", PROFILE_SPRIO_NORMAL);
+    htsmsg_add_bool(e, "shield", 1);
+    (void)profile_create(NULL, e, 1);
+    htsmsg_destroy(e);
+  }
+
   /* Assign the default profile if config files are corrupted */
   if (!profile_default) {
     pro = profile_find_by_name2("pass", NULL, 1);
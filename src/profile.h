@@ -58,6 +58,7 @@ struct streaming_start;
 extern const idclass_t profile_class;
 extern const idclass_t profile_mpegts_pass_class;
 extern const idclass_t profile_matroska_class;
+extern const idclass_t profile_hls_class;
 
 TAILQ_HEAD(profile_entry_queue, profile);
 
@@ -90,6 +91,7 @@ typedef struct profile_chain {
   int                       prch_flags;
   int                       prch_stop;
   int                       prch_start_pending;
+  int                       prch_rendition;
   int                       prch_sq_used;
   struct streaming_queue    prch_sq;
   struct streaming_target  *prch_post_share;
@@ -151,6 +153,7 @@ typedef struct profile_sharer_message {
 typedef struct profile_sharer {
   uint32_t                  prsh_do_queue: 1;
   uint32_t                  prsh_queue_run: 1;
+  uint32_t                  prsh_renditions: 1;
   pthread_t                 prsh_queue_thread;
   tvh_mutex_t               prsh_queue_mutex;
   tvh_cond_t                prsh_queue_cond;
@@ -200,6 +203,7 @@ profile_t *profile_find_by_name(const char *name, const char *alt);
 profile_t *profile_find_by_list(htsmsg_t *uuids, const char *name,
                                 const char *alt, int sflags);
 int profile_verify(profile_t *pro, int sflags);
+int profile_hls_config(profile_t *pro, int *duration, int *segments, int *idle);
 
 htsmsg_t * profile_class_get_list(void *o, const char *lang);
 
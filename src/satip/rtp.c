@@ -378,6 +378,7 @@ satip_rtp_thread(void *aux)
   satip_rtp_session_t *rtp = aux;
   streaming_queue_t *sq = rtp->sq;
   streaming_message_t *sm;
+  struct streaming_message_queue pending;
   th_subscription_t *subs = rtp->subs;
   pktbuf_t *pb;
   char peername[50];
@@ -388,10 +389,10 @@ satip_rtp_thread(void *aux)
   tvhdebug(LS_SATIPS, "RTP streaming to %s:%d open", peername,
            tcp ? ntohs(IP_PORT(rtp->peer)) : rtp->port);
 
+  TAILQ_INIT(&pending);
   tvh_mutex_lock(&sq->sq_mutex);
   while (rtp->sq && !fatal) {
-    sm = TAILQ_FIRST(&sq->sq_queue);
-    if (sm == NULL) {
+    if (TAILQ_EMPTY(&sq->sq_queue)) {
       if (tcp) {
         r = satip_rtp_flush_tcp_data(rtp);
       } else {
@@ -404,53 +405,58 @@ satip_rtp_thread(void *aux)
       tvh_cond_wait(&sq->sq_cond, &sq->sq_mutex);
       continue;
     }
-    streaming_queue_remove(sq, sm);
+    streaming_queue_take(sq, &pending);
     tvh_mutex_unlock(&sq->sq_mutex);
 
-    switch (sm->sm_type) {
-    case SMT_MPEGTS:
-      pb = sm->sm_data;
-      r = pktbuf_len(pb);
-      subscription_add_bytes_out(subs, r);
-      if (r > 0)
-        atomic_set(&rtp->sig_lock, 1);
-      if (atomic_get(&rtp->allow_data)) {
-        tvh_mutex_lock(&rtp->lock);
-        if (tcp)
-          r = satip_rtp_tcp_loop(rtp, pktbuf_ptr(pb), r);
-        else
-          r = satip_rtp_loop(rtp, pktbuf_ptr(pb), r);
-        tvh_mutex_unlock(&rtp->lock);
-        if (r) fatal = 1;
+    while (!fatal && (sm = TAILQ_FIRST(&pending)) != NULL) {
+      TAILQ_REMOVE(&pending, sm, sm_link);
+
+      switch (sm->sm_type) {
+      case SMT_MPEGTS:
+        pb = sm->sm_data;
+        r = pktbuf_len(pb);
+        subscription_add_bytes_out(subs, r);
+        if (r > 0)
+          atomic_set(&rtp->sig_lock, 1);
+        if (atomic_get(&rtp->allow_data)) {
+          tvh_mutex_lock(&rtp->lock);
+          if (tcp)
+            r = satip_rtp_tcp_loop(rtp, pktbuf_ptr(pb), r);
+          else
+            r = satip_rtp_loop(rtp, pktbuf_ptr(pb), r);
+          tvh_mutex_unlock(&rtp->lock);
+          if (r) fatal = 1;
+        }
+        break;
+      case SMT_SIGNAL_STATUS:
+        satip_rtp_signal_status(rtp, sm->sm_data);
+        break;
+      case SMT_NOSTART:
+      case SMT_EXIT:
+        if (rtp->no_data_cb)
+          rtp->no_data_cb(rtp->no_data_opaque);
+        alive = 0;
+        break;
+
+      case SMT_START:
+      case SMT_STOP:
+      case SMT_NOSTART_WARN:
+      case SMT_PACKET:
+      case SMT_GRACE:
+      case SMT_SKIP:
+      case SMT_SPEED:
+      case SMT_SERVICE_STATUS:
+      case SMT_TIMESHIFT_STATUS:
+      case SMT_DESCRAMBLE_INFO:
+        break;
       }
-      break;
-    case SMT_SIGNAL_STATUS:
-      satip_rtp_signal_status(rtp, sm->sm_data);
-      break;
-    case SMT_NOSTART:
-    case SMT_EXIT:
-      if (rtp->no_data_cb)
-        rtp->no_data_cb(rtp->no_data_opaque);
-      alive = 0;
-      break;
 
-    case SMT_START:
-    case SMT_STOP:
-    case SMT_NOSTART_WARN:
-    case SMT_PACKET:
-    case SMT_GRACE:
-    case SMT_SKIP:
-    case SMT_SPEED:
-    case SMT_SERVICE_STATUS:
-    case SMT_TIMESHIFT_STATUS:
-    case SMT_DESCRAMBLE_INFO:
-      break;
+      streaming_msg_free(sm);
     }
-
-    streaming_msg_free(sm);
     tvh_mutex_lock(&sq->sq_mutex);
   }
   tvh_mutex_unlock(&sq->sq_mutex);
+  streaming_queue_clear(&pending);
 
   tvhdebug(LS_SATIPS, "RTP streaming to %s:%d closed (%s request)%s",
            peername,
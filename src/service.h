@@ -378,6 +378,11 @@ typedef struct service {
    */
   streaming_pad_t s_streaming_pad;
 
+  /**
+   * Shared elementary stream parser (protected by s_stream_mutex)
+   */
+  struct parser *s_parser;
+
   tvhlog_limit_t s_tei_log;
 
   /*
@@ -34,9 +34,88 @@
 #include "settings.h"
 #include "tvheadend.h"
 #include "filebundle.h"
+#include "redblack.h"
 
 static char *settingspath = NULL;
 
+/*
+ * Packed store
+ *
+ * All records are appended to one file in the configuration root. Each
+ * record carries the relative path and the binary2 encoded message, or
+ * a removal mark for the path and everything below it. The index keeps
+ * the position of the last record for each path, the obsolete records
+ * are dropped by the compaction thread.
+ */
+
+#define SETTINGS_PACK_FILE      ".settings.pack"
+#define SETTINGS_PACK_MAGIC     "TVHPACK1"
+#define SETTINGS_PACK_HDRSIZE   16
+#define SETTINGS_PACK_SAVE      'S'
+#define SETTINGS_PACK_REMOVE    'R'
+#define SETTINGS_PACK_DEAD_MIN  (1024*1024)
+
+typedef struct settings_pack_entry {
+  RB_ENTRY(settings_pack_entry) spe_link;
+  const char *spe_key;
+  off_t       spe_off;      /* record start */
+  uint32_t    spe_datalen;
+} settings_pack_entry_t;
+
+static int settings_pack_fd = -1;
+static off_t settings_pack_size;
+static off_t settings_pack_dead;
+static RB_HEAD(, settings_pack_entry) settings_pack_index;
+static tvh_mutex_t settings_pack_lock = TVH_THREAD_MUTEX_INITIALIZER;
+static tvh_cond_t settings_pack_cond;
+static pthread_t settings_pack_tid;
+static int settings_pack_running;
+
+/*
+ * Saves and removals done while a save batch (one at a time, the idnode
+ * save thread) is writing its snapshots without the global lock
+ */
+static tvh_mutex_t settings_batch_lock = TVH_THREAD_MUTEX_INITIALIZER;
+static int settings_batch_active;
+static htsmsg_t *settings_batch_ops;
+
+static void hts_settings_save_file(htsmsg_t *record, const char *path);
+static void settings_remove0(const char *path);
+
+/*
+ * Load statistics, updated by the loader threads
+ */
+typedef struct settings_load_stats {
+  int64_t read;                 /* usec */
+  int64_t parse;                /* usec */
+  int64_t bytes;
+  int     files;
+  int     threads;
+} settings_load_stats_t;
+
+/*
+ * Startup statistics for each settings path, the objects are created
+ * from the loaded data until the next load (or the end of the startup)
+ */
+typedef struct settings_boot_stat {
+  TAILQ_ENTRY(settings_boot_stat) link;
+  char    *pathfmt;
+  int      loads;
+  int      threads;
+  settings_load_stats_t total;
+  int64_t  wall;                /* usec */
+  int64_t  create;              /* usec */
+} settings_boot_stat_t;
+
+static TAILQ_HEAD(, settings_boot_stat) settings_boot_stats;
+static int settings_booting;
+static pthread_t settings_boot_thread;
+static settings_boot_stat_t *settings_boot_last;
+static int64_t settings_boot_mark;
+
+#define SETTINGS_LOAD_THREADS   8
+#define SETTINGS_LOAD_PARALLEL  64      /* files */
+
 /**
  *
  */
@@ -54,6 +133,9 @@ hts_settings_init(const char *confpath)
 {
   if (confpath)
     settingspath = realpath(confpath, NULL);
+  TAILQ_INIT(&settings_boot_stats);
+  settings_boot_thread = pthread_self();
+  settings_booting = 1;
 }
 
 /**
@@ -62,6 +144,7 @@ hts_settings_init(const char *confpath)
 void
 hts_settings_done(void)
 {
+  hts_settings_pack_done();
   free(settingspath);
 }
 
@@ -123,28 +206,610 @@ hts_settings_buildpath
   return 0;
 }
 
-/**
- *
+/* **************************************************************************
+ * Packed store
+ * *************************************************************************/
+
+static inline int
+settings_pack_cmp(const settings_pack_entry_t *a, const settings_pack_entry_t *b)
+{
+  return strcmp(a->spe_key, b->spe_key);
+}
+
+static inline uint32_t
+get_le32(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void
+put_le32(uint8_t *p, uint32_t v)
+{
+  p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static inline uint32_t
+settings_pack_recsize(settings_pack_entry_t *spe)
+{
+  return SETTINGS_PACK_HDRSIZE + strlen(spe->spe_key) + spe->spe_datalen;
+}
+
+/*
+ * Relative path for the packed store, NULL for absolute paths
+ */
+static const char *
+settings_pack_key(char *dst, size_t dstsize, const char *fmt, va_list ap)
+{
+  char *s, *d;
+
+  if (settings_pack_fd < 0 || *fmt == '/')
+    return NULL;
+  _hts_settings_buildpath(dst, dstsize, fmt, ap, NULL);
+  for (s = d = dst; *s; s++) {
+    if (*s == '/' && (d == dst || d[-1] == '/'))
+      continue;
+    *d++ = *s;
+  }
+  while (d != dst && d[-1] == '/')
+    d--;
+  *d = '\0';
+  return dst;
+}
+
+static const char *
+settings_pack_keyf(char *dst, size_t dstsize, const char *fmt, ...)
+{
+  const char *r;
+  va_list ap;
+
+  va_start(ap, fmt);
+  r = settings_pack_key(dst, dstsize, fmt, ap);
+  va_end(ap);
+  return r;
+}
+
+static settings_pack_entry_t *
+settings_pack_find(const char *key)
+{
+  settings_pack_entry_t skel;
+
+  skel.spe_key = key;
+  return RB_FIND(&settings_pack_index, &skel, spe_link, settings_pack_cmp);
+}
+
+/*
+ * First entry below the key (key/...)
+ */
+static settings_pack_entry_t *
+settings_pack_first(const char *key, size_t *plen)
+{
+  settings_pack_entry_t skel, *spe;
+  char prefix[PATH_MAX];
+
+  *plen = snprintf(prefix, sizeof(prefix), "%s%s", key, *key ? "/" : "");
+  skel.spe_key = prefix;
+  spe = RB_FIND_GE(&settings_pack_index, &skel, spe_link, settings_pack_cmp);
+  if (spe && strncmp(spe->spe_key, prefix, *plen))
+    spe = NULL;
+  return spe;
+}
+
+static settings_pack_entry_t *
+settings_pack_next(settings_pack_entry_t *spe, size_t plen)
+{
+  settings_pack_entry_t *next = RB_NEXT(spe, spe_link);
+  if (next && strncmp(next->spe_key, spe->spe_key, plen))
+    next = NULL;
+  return next;
+}
+
+static void
+settings_pack_entry_destroy(settings_pack_entry_t *spe)
+{
+  settings_pack_dead += settings_pack_recsize(spe);
+  RB_REMOVE(&settings_pack_index, spe, spe_link);
+  free(spe);
+}
+
+/*
+ * Drop the key and everything below it from the index
+ */
+static int
+settings_pack_index_remove(const char *key)
+{
+  settings_pack_entry_t *spe, *next;
+  size_t plen;
+  int r = 0;
+
+  if ((spe = settings_pack_find(key)) != NULL) {
+    settings_pack_entry_destroy(spe);
+    r++;
+  }
+  for (spe = settings_pack_first(key, &plen); spe; spe = next, r++) {
+    next = settings_pack_next(spe, plen);
+    settings_pack_entry_destroy(spe);
+  }
+  return r;
+}
+
+static void
+settings_pack_index_set(const char *key, off_t off, uint32_t datalen)
+{
+  settings_pack_entry_t *spe;
+  size_t l;
+
+  if ((spe = settings_pack_find(key)) != NULL) {
+    settings_pack_dead += settings_pack_recsize(spe);
+  } else {
+    l = strlen(key) + 1;
+    spe = malloc(sizeof(*spe) + l);
+    spe->spe_key = memcpy(spe + 1, key, l);
+    RB_INSERT_SORTED(&settings_pack_index, spe, spe_link, settings_pack_cmp);
+  }
+  spe->spe_off = off;
+  spe->spe_datalen = datalen;
+}
+
+static void
+settings_pack_wakeup(void)
+{
+  if (settings_pack_dead > SETTINGS_PACK_DEAD_MIN &&
+      settings_pack_dead > settings_pack_size / 2)
+    tvh_cond_signal(&settings_pack_cond, 0);
+}
+
+/*
+ * Record: type, 3 reserved bytes, key length, data length, crc32
+ * (all little endian), then the key and the data
+ */
+static void
+settings_pack_header
+  (uint8_t *hdr, int type, const char *key, uint32_t keylen,
+   const void *data, uint32_t datalen)
+{
+  uint32_t crc;
+
+  crc = tvh_crc32((const uint8_t *)key, keylen, 0xffffffff);
+  crc = tvh_crc32((const uint8_t *)data, datalen, crc);
+  memset(hdr, 0, SETTINGS_PACK_HDRSIZE);
+  hdr[0] = type;
+  put_le32(hdr + 4, keylen);
+  put_le32(hdr + 8, datalen);
+  put_le32(hdr + 12, crc);
+}
+
+static int
+settings_pack_pwrite(int fd, const void *buf, size_t len, off_t off)
+{
+  ssize_t r;
+
+  while (len > 0) {
+    r = pwrite(fd, buf, len, off);
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    buf += r;
+    len -= r;
+    off += r;
+  }
+  return 0;
+}
+
+static int
+settings_pack_append
+  (int type, const char *key, const void *data, uint32_t datalen)
+{
+  uint32_t keylen = strlen(key);
+  size_t size = SETTINGS_PACK_HDRSIZE + keylen + datalen;
+  uint8_t *rec = malloc(size);
+  off_t off = settings_pack_size;
+  int r;
+
+  settings_pack_header(rec, type, key, keylen, data, datalen);
+  memcpy(rec + SETTINGS_PACK_HDRSIZE, key, keylen);
+  if (datalen)
+    memcpy(rec + SETTINGS_PACK_HDRSIZE + keylen, data, datalen);
+  r = settings_pack_pwrite(settings_pack_fd, rec, size, off);
+  free(rec);
+  if (r) {
+    tvhalert(LS_SETTINGS, "Failed to write \"%s\" to the packed store - %s",
+             key, strerror(errno));
+    if (ftruncate(settings_pack_fd, off)) {}
+    return -1;
+  }
+  settings_pack_size += size;
+  if (type == SETTINGS_PACK_REMOVE)
+    settings_pack_dead += size;
+  else
+    settings_pack_index_set(key, off, datalen);
+  return 0;
+}
+
+/*
+ * Store the message, call with settings_pack_lock held
+ */
+static int
+settings_pack_save(const char *key, htsmsg_t *record)
+{
+  void *data = NULL;
+  size_t len, plen;
+  int r = -1;
+
+  if (htsmsg_binary2_serialize0(record, &data, &len, 16*1024*1024)) {
+    tvhalert(LS_SETTINGS, "Unable to pack the configuration data \"%s\"", key);
+    return -1;
+  }
+  /* a file replaces the directory */
+  if (settings_pack_first(key, &plen)) {
+    if (settings_pack_append(SETTINGS_PACK_REMOVE, key, NULL, 0))
+      goto end;
+    settings_pack_index_remove(key);
+  }
+  r = settings_pack_append(SETTINGS_PACK_SAVE, key, data, len);
+end:
+  free(data);
+  return r;
+}
+
+static htsmsg_t *
+settings_pack_decode(settings_pack_entry_t *spe, settings_load_stats_t *stats)
+{
+  htsmsg_t *r, *c;
+  uint8_t *data;
+  ssize_t n;
+  int64_t t0, t1;
+
+  t0 = getmonoclock();
+  data = malloc(spe->spe_datalen ?: 1);
+  n = pread(settings_pack_fd, data, spe->spe_datalen,
+            spe->spe_off + SETTINGS_PACK_HDRSIZE + strlen(spe->spe_key));
+  if (n != spe->spe_datalen) {
+    tvhalert(LS_SETTINGS, "Unable to read \"%s\" from the packed store", spe->spe_key);
+    free(data);
+    return NULL;
+  }
+  t1 = getmonoclock();
+  r = htsmsg_binary2_deserialize0(data, spe->spe_datalen, data);
+  if (r && r->hm_data) {
+    /* binary fields point to the buffer, detach them */
+    c = htsmsg_copy(r);
+    htsmsg_destroy(r);
+    r = c;
+  }
+  if (stats) {
+    stats->read += t1 - t0;
+    stats->parse += getmonoclock() - t1;
+    stats->bytes += n;
+    stats->files++;
+  }
+  return r;
+}
+
+/*
+ * Load the record or the tree below the key, like the directory loader
+ */
+static htsmsg_t *
+settings_pack_load(const char *key, int depth, settings_load_stats_t *stats)
+{
+  settings_pack_entry_t *spe;
+  htsmsg_t *r, *m, *c;
+  const char *rel, *s;
+  char name[PATH_MAX];
+  size_t plen;
+  int slashes;
+
+  if ((spe = settings_pack_find(key)) != NULL)
+    return settings_pack_decode(spe, stats);
+  if ((spe = settings_pack_first(key, &plen)) == NULL)
+    return NULL;
+  r = htsmsg_create_map();
+  for ( ; spe; spe = settings_pack_next(spe, plen)) {
+    rel = spe->spe_key + plen;
+    for (slashes = 0, s = rel; *s; s++)
+      if (*s == '/') slashes++;
+    if (slashes > depth)
+      continue;
+    m = r;
+    while ((s = strchr(rel, '/')) != NULL) {
+      strlcpy(name, rel, MIN(sizeof(name), s - rel + 1));
+      if ((c = htsmsg_get_map(m, name)) == NULL)
+        c = htsmsg_add_msg(m, name, htsmsg_create_map());
+      m = c;
+      rel = s + 1;
+    }
+    if ((c = settings_pack_decode(spe, stats)) != NULL)
+      htsmsg_add_msg(m, rel, c);
+  }
+  return r;
+}
+
+/*
+ * Rebuild the index from the file
+ */
+static int
+settings_pack_replay(void)
+{
+  struct stat st;
+  uint8_t *buf, *p, *end;
+  uint32_t keylen, datalen, crc;
+  char key[PATH_MAX];
+  off_t off;
+  ssize_t n;
+
+  if (fstat(settings_pack_fd, &st))
+    return -1;
+  if (st.st_size == 0) {
+    if (settings_pack_pwrite(settings_pack_fd, SETTINGS_PACK_MAGIC, 8, 0))
+      return -1;
+    settings_pack_size = 8;
+    return 0;
+  }
+  buf = malloc(st.st_size);
+  n = pread(settings_pack_fd, buf, st.st_size, 0);
+  if (n != st.st_size || n < 8 || memcmp(buf, SETTINGS_PACK_MAGIC, 8)) {
+    tvherror(LS_SETTINGS, "invalid packed store %s/%s",
+             settingspath, SETTINGS_PACK_FILE);
+    free(buf);
+    return -1;
+  }
+  p = buf + 8;
+  end = buf + n;
+  settings_pack_size = 8;
+  while (end - p >= SETTINGS_PACK_HDRSIZE) {
+    keylen = get_le32(p + 4);
+    datalen = get_le32(p + 8);
+    if (keylen == 0 || keylen >= sizeof(key) ||
+        (uint64_t)keylen + datalen > (uint64_t)(end - p - SETTINGS_PACK_HDRSIZE))
+      break;
+    crc = tvh_crc32(p + SETTINGS_PACK_HDRSIZE, keylen + datalen, 0xffffffff);
+    if (crc != get_le32(p + 12))
+      break;
+    memcpy(key, p + SETTINGS_PACK_HDRSIZE, keylen);
+    key[keylen] = '\0';
+    off = p - buf;
+    settings_pack_size = off + SETTINGS_PACK_HDRSIZE + keylen + datalen;
+    if (p[0] == SETTINGS_PACK_SAVE) {
+      settings_pack_index_set(key, off, datalen);
+    } else {
+      settings_pack_index_remove(key);
+      settings_pack_dead += SETTINGS_PACK_HDRSIZE + keylen;
+    }
+    p += SETTINGS_PACK_HDRSIZE + keylen + datalen;
+  }
+  off = p - buf;
+  free(buf);
+  if (off != n) {
+    tvhwarn(LS_SETTINGS, "packed store truncated at offset %"PRId64
+                         " (%"PRId64" bytes dropped)",
+            (int64_t)off, (int64_t)(n - off));
+    settings_pack_size = off;
+    if (ftruncate(settings_pack_fd, off))
+      return -1;
+  }
+  return 0;
+}
+
+/*
+ * Rewrite the file with the live records only
+ */
+static void
+settings_pack_compact(void)
+{
+  char path[PATH_MAX], tmppath[PATH_MAX + 4];
+  settings_pack_entry_t *spe;
+  uint8_t *buf;
+  off_t *offs, off, dead = settings_pack_dead;
+  size_t size, used = 0, bufsize = 256*1024;
+  int fd, count = 0, i;
+  int64_t mono = getfastmonoclock();
+
+  snprintf(path, sizeof(path), "%s/%s", settingspath, SETTINGS_PACK_FILE);
+  snprintf(tmppath, sizeof(tmppath), "%s.tmp", path);
+  if ((fd = tvh_open(tmppath, O_CREAT | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR)) < 0) {
+    tvhalert(LS_SETTINGS, "Unable to create \"%s\" - %s", tmppath, strerror(errno));
+    return;
+  }
+  RB_FOREACH(spe, &settings_pack_index, spe_link)
+    count++;
+  offs = malloc(sizeof(*offs) * (count + 1));
+  buf = malloc(bufsize);
+  memcpy(buf, SETTINGS_PACK_MAGIC, 8);
+  used = 8;
+  off = 0;
+  i = 0;
+  RB_FOREACH(spe, &settings_pack_index, spe_link) {
+    size = settings_pack_recsize(spe);
+    if (used + size > bufsize) {
+      if (settings_pack_pwrite(fd, buf, used, off))
+        goto fail;
+      off += used;
+      used = 0;
+      if (size > bufsize) {
+        bufsize = size;
+        buf = realloc(buf, bufsize);
+      }
+    }
+    if (pread(settings_pack_fd, buf + used, size, spe->spe_off) != size)
+      goto fail;
+    offs[i++] = off + used;
+    used += size;
+  }
+  if (settings_pack_pwrite(fd, buf, used, off) || fdatasync(fd))
+    goto fail;
+  off += used;
+  if (rename(tmppath, path))
+    goto fail;
+  close(settings_pack_fd);
+  settings_pack_fd = fd;
+  settings_pack_size = off;
+  settings_pack_dead = 0;
+  i = 0;
+  RB_FOREACH(spe, &settings_pack_index, spe_link)
+    spe->spe_off = offs[i++];
+  free(offs);
+  free(buf);
+  tvhinfo(LS_SETTINGS, "packed store compacted, %d records, %"PRId64" kB dropped (%"PRId64" ms)",
+          count, (int64_t)dead / 1024, (getfastmonoclock() - mono) / 1000);
+  return;
+
+fail:
+  tvhalert(LS_SETTINGS, "Unable to compact the packed store - %s", strerror(errno));
+  close(fd);
+  unlink(tmppath);
+  free(offs);
+  free(buf);
+}
+
+static void *
+settings_pack_thread(void *aux)
+{
+  tvh_mutex_lock(&settings_pack_lock);
+  while (settings_pack_running) {
+    if (settings_pack_dead > SETTINGS_PACK_DEAD_MIN &&
+        settings_pack_dead > settings_pack_size / 2)
+      settings_pack_compact();
+    if (settings_pack_running)
+      tvh_cond_wait(&settings_pack_cond, &settings_pack_lock);
+  }
+  tvh_mutex_unlock(&settings_pack_lock);
+  return NULL;
+}
+
+/*
+ * Move the loaded files from the directory tree to the packed store,
+ * the top directory is kept (an empty directory loads as an empty map)
+ */
+static void
+settings_pack_import(htsmsg_t *files, const char *top)
+{
+  htsmsg_field_t *f;
+  const char *path;
+  char *tmp;
+  size_t len = MAX(strlen(top), strlen(settingspath));
+
+  if (files == NULL || TAILQ_EMPTY(&files->hm_fields))
+    return;
+  if (fdatasync(settings_pack_fd)) {
+    tvhalert(LS_SETTINGS, "Unable to sync the packed store - %s", strerror(errno));
+    return;
+  }
+  HTSMSG_FOREACH(f, files) {
+    if ((path = htsmsg_field_get_str(f)) == NULL)
+      continue;
+    tvhtrace(LS_SETTINGS, "imported %s", path);
+    if (unlink(path) == 0) {
+      tmp = tvh_strdupa(path);
+      while ((tmp = dirname(tmp)) != NULL &&
+             strlen(tmp) > len && rmdir(tmp) == 0);
+    }
+  }
+}
+
+/*
+ * Write all records to the directory tree and stop using the packed store
+ */
+static void
+settings_pack_export(void)
+{
+  settings_pack_entry_t *spe;
+  htsmsg_t *m;
+  char path[PATH_MAX], old[PATH_MAX + 4];
+  int count = 0;
+
+  RB_FOREACH(spe, &settings_pack_index, spe_link) {
+    if ((m = settings_pack_decode(spe, NULL)) == NULL)
+      continue;
+    snprintf(path, sizeof(path), "%s/%s", settingspath, spe->spe_key);
+    hts_settings_save_file(m, path);
+    htsmsg_destroy(m);
+    count++;
+  }
+  snprintf(path, sizeof(path), "%s/%s", settingspath, SETTINGS_PACK_FILE);
+  snprintf(old, sizeof(old), "%s.old", path);
+  if (rename(path, old))
+    tvhalert(LS_SETTINGS, "Unable to rename \"%s\" to \"%s\" - %s",
+             path, old, strerror(errno));
+  tvhinfo(LS_SETTINGS, "exported %d records from the packed store", count);
+}
+
+/*
+ * Open the packed store (after the configuration is locked)
  */
 void
-hts_settings_save(htsmsg_t *record, const char *pathfmt, ...)
+hts_settings_pack_init(int mode)
 {
   char path[PATH_MAX];
+  int flags = O_RDWR;
+
+  if (settingspath == NULL)
+    return;
+  snprintf(path, sizeof(path), "%s/%s", settingspath, SETTINGS_PACK_FILE);
+  if (mode == HTS_SETTINGS_PACK_ENABLE)
+    flags |= O_CREAT;
+  if ((settings_pack_fd = tvh_open(path, flags, S_IRUSR | S_IWUSR)) < 0) {
+    if (errno != ENOENT)
+      tvherror(LS_SETTINGS, "Unable to open \"%s\" - %s", path, strerror(errno));
+    return;
+  }
+  RB_INIT(&settings_pack_index);
+  if (settings_pack_replay()) {
+    tvherror(LS_SETTINGS, "packed store %s is not usable, using the directory tree", path);
+    hts_settings_pack_done();
+    return;
+  }
+  if (mode == HTS_SETTINGS_PACK_EXPORT) {
+    settings_pack_export();
+    hts_settings_pack_done();
+    return;
+  }
+  tvhinfo(LS_SETTINGS, "using packed store %s (%"PRId64" kB, %"PRId64" kB obsolete)",
+          path, (int64_t)settings_pack_size / 1024, (int64_t)settings_pack_dead / 1024);
+  tvh_cond_init(&settings_pack_cond, 1);
+  settings_pack_running = 1;
+  tvh_thread_create(&settings_pack_tid, NULL, settings_pack_thread, NULL, "settings");
+  tvh_mutex_lock(&settings_pack_lock);
+  settings_pack_wakeup();
+  tvh_mutex_unlock(&settings_pack_lock);
+}
+
+void
+hts_settings_pack_done(void)
+{
+  settings_pack_entry_t *spe;
+
+  if (settings_pack_running) {
+    tvh_mutex_lock(&settings_pack_lock);
+    settings_pack_running = 0;
+    tvh_cond_signal(&settings_pack_cond, 0);
+    tvh_mutex_unlock(&settings_pack_lock);
+    pthread_join(settings_pack_tid, NULL);
+    tvh_cond_destroy(&settings_pack_cond);
+  }
+  if (settings_pack_fd >= 0) {
+    close(settings_pack_fd);
+    settings_pack_fd = -1;
+  }
+  while ((spe = RB_FIRST(&settings_pack_index)) != NULL) {
+    RB_REMOVE(&settings_pack_index, spe, spe_link);
+    free(spe);
+  }
+  settings_pack_size = settings_pack_dead = 0;
+}
+
+/**
+ *
+ */
+static void
+hts_settings_save_file(htsmsg_t *record, const char *path)
+{
   char tmppath[PATH_MAX + 4];
   int fd;
-  va_list ap;
   htsbuf_queue_t hq;
   htsbuf_data_t *hd;
   int ok, r, pack;
 
-  if(settingspath == NULL)
-    return;
-
-  /* Clean the path */
-  va_start(ap, pathfmt);
-  _hts_settings_buildpath(path, sizeof(path), pathfmt, ap, settingspath);
-  va_end(ap);
-
   /* Create directories */
   if (hts_settings_makedirs(path)) return;
 
@@ -212,16 +877,354 @@ hts_settings_save(htsmsg_t *record, const char *pathfmt, ...)
     unlink(tmppath);
 }
 
+/*
+ * Keep the saves and removals for the save batch in flight (in order)
+ */
+static void
+settings_batch_record(const char *path, htsmsg_t *record)
+{
+  htsmsg_t *m;
+
+  tvh_mutex_lock(&settings_batch_lock);
+  if (settings_batch_active) {
+    if (settings_batch_ops == NULL)
+      settings_batch_ops = htsmsg_create_list();
+    m = htsmsg_create_map();
+    htsmsg_add_str(m, "path", path);
+    if (record)
+      htsmsg_add_msg(m, "record", htsmsg_copy(record));
+    htsmsg_add_msg(settings_batch_ops, NULL, m);
+  }
+  tvh_mutex_unlock(&settings_batch_lock);
+}
+
+/**
+ *
+ */
+static void
+settings_save0(htsmsg_t *record, const char *path)
+{
+  char buf[PATH_MAX];
+  const char *key;
+
+  /* Packed store */
+  key = *path == '/' ? NULL : settings_pack_keyf(buf, sizeof(buf), "%s", path);
+  if (key) {
+    tvh_mutex_lock(&settings_pack_lock);
+    tvhdebug(LS_SETTINGS, "saving %s to the packed store", key);
+    settings_pack_save(key, record);
+    settings_pack_wakeup();
+    tvh_mutex_unlock(&settings_pack_lock);
+    return;
+  }
+
+  /* Clean the path */
+  hts_settings_buildpath(buf, sizeof(buf), "%s", path);
+  hts_settings_save_file(record, buf);
+}
+
+void
+hts_settings_save(htsmsg_t *record, const char *pathfmt, ...)
+{
+  char path[PATH_MAX];
+  va_list ap;
+
+  if(settingspath == NULL)
+    return;
+
+  va_start(ap, pathfmt);
+  vsnprintf(path, sizeof(path), pathfmt, ap);
+  va_end(ap);
+  settings_batch_record(path, record);
+  settings_save0(record, path);
+}
+
+/*
+ * Batched save, the packed store is synced once for the whole batch,
+ * the large batches of files are written by a few threads (a later
+ * record for the same path wins like for the sequential writes)
+ */
+#define SETTINGS_SAVE_THREADS   4
+#define SETTINGS_SAVE_PARALLEL  64      /* files */
+
+typedef struct settings_saver {
+  htsmsg_t    **records;
+  char        **paths;          /* full path, NULL = skip */
+  int           count;
+  volatile int  next;
+} settings_saver_t;
+
+typedef struct settings_save_dup {
+  const char *path;
+  int         idx;
+} settings_save_dup_t;
+
+static int
+settings_save_dup_cmp(const void *_a, const void *_b)
+{
+  const settings_save_dup_t *a = _a, *b = _b;
+  int r = strcmp(a->path, b->path);
+  return r ? r : a->idx - b->idx;
+}
+
+static void
+settings_save_dedup(settings_saver_t *s)
+{
+  settings_save_dup_t *d = malloc(s->count * sizeof(*d));
+  int i, n = 0;
+
+  for (i = 0; i < s->count; i++)
+    if (s->paths[i]) {
+      d[n].path = s->paths[i];
+      d[n++].idx = i;
+    }
+  qsort(d, n, sizeof(*d), settings_save_dup_cmp);
+  for (i = 0; i + 1 < n; i++)
+    if (strcmp(d[i].path, d[i+1].path) == 0) {
+      free(s->paths[d[i].idx]);
+      s->paths[d[i].idx] = NULL;
+    }
+  free(d);
+}
+
+static void *
+settings_save_thread(void *aux)
+{
+  settings_saver_t *s = aux;
+  int i;
+
+  while ((i = atomic_add(&s->next, 1)) < s->count)
+    if (s->paths[i])
+      hts_settings_save_file(s->records[i], s->paths[i]);
+  return NULL;
+}
+
+/*
+ * Called with the records snapshotted and before the global lock
+ * is released, the removals from now on are tracked for the batch
+ */
+void
+hts_settings_save_begin(void)
+{
+  tvh_mutex_lock(&settings_batch_lock);
+  settings_batch_active = 1;
+  tvh_mutex_unlock(&settings_batch_lock);
+}
+
+/*
+ * The batch records were snapshotted before the writes, apply again
+ * the later saves and removals of the same paths (the last one wins)
+ */
+static void
+settings_batch_replay(htsmsg_t *ops, char **paths, int count)
+{
+  htsmsg_field_t *f;
+  htsmsg_t *m;
+  const char *path;
+  size_t len;
+  int i;
+
+  HTSMSG_FOREACH(f, ops) {
+    if ((m = htsmsg_field_get_map(f)) == NULL ||
+        (path = htsmsg_get_str(m, "path")) == NULL)
+      continue;
+    len = strlen(path);
+    for (i = 0; i < count; i++)
+      if (strncmp(paths[i], path, len) == 0 &&
+          (paths[i][len] == '\0' || paths[i][len] == '/'))
+        break;
+    if (i >= count)
+      continue;
+    if ((m = htsmsg_get_map(m, "record")) != NULL) {
+      tvhdebug(LS_SETTINGS, "saving %s again (saved while saving)", path);
+      settings_save0(m, path);
+    } else {
+      tvhdebug(LS_SETTINGS, "removing %s again (deleted while saving)", path);
+      settings_remove0(path);
+    }
+  }
+}
+
+static void
+settings_batch_done(char **paths, int count)
+{
+  htsmsg_t *ops;
+
+  tvh_mutex_lock(&settings_batch_lock);
+  while ((ops = settings_batch_ops) != NULL) {
+    settings_batch_ops = NULL;
+    tvh_mutex_unlock(&settings_batch_lock);
+    settings_batch_replay(ops, paths, count);
+    htsmsg_destroy(ops);
+    tvh_mutex_lock(&settings_batch_lock);
+  }
+  settings_batch_active = 0;
+  tvh_mutex_unlock(&settings_batch_lock);
+}
+
+void
+hts_settings_save_batch(htsmsg_t **records, char **paths, int count)
+{
+  settings_saver_t s;
+  pthread_t tids[SETTINGS_SAVE_THREADS];
+  char path[PATH_MAX];
+  const char *key;
+  long ncpu;
+  int i, k, nfiles = 0, packed = 0, nthreads = 0;
+
+  if (count <= 0)
+    return;
+  if (settingspath == NULL) {
+    settings_batch_done(paths, 0);
+    return;
+  }
+
+  memset(&s, 0, sizeof(s));
+  s.records = records;
+  s.paths = calloc(count, sizeof(char *));
+
+  /* Packed store */
+  tvh_mutex_lock(&settings_pack_lock);
+  for (i = 0; i < count; i++) {
+    key = settings_pack_keyf(path, sizeof(path), "%s", paths[i]);
+    if (key) {
+      tvhdebug(LS_SETTINGS, "saving %s to the packed store", key);
+      settings_pack_save(key, records[i]);
+      packed++;
+    } else {
+      hts_settings_buildpath(path, sizeof(path), "%s", paths[i]);
+      s.paths[i] = strdup(path);
+      s.count = i + 1;
+      nfiles++;
+    }
+  }
+  if (packed) {
+    if (fdatasync(settings_pack_fd))
+      tvhalert(LS_SETTINGS, "Failed to sync the packed store - %s",
+               strerror(errno));
+    settings_pack_wakeup();
+  }
+  tvh_mutex_unlock(&settings_pack_lock);
+
+  /* Files */
+  if (nfiles >= SETTINGS_SAVE_PARALLEL) {
+    ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    k = MIN(ncpu, SETTINGS_SAVE_THREADS);
+    k = MIN(k, nfiles / (SETTINGS_SAVE_PARALLEL / 2));
+    if (k > 1)
+      settings_save_dedup(&s);
+    for ( ; nthreads < k - 1; nthreads++)
+      if (tvh_thread_create(&tids[nthreads], NULL, settings_save_thread, &s, "settings"))
+        break;
+  }
+  settings_save_thread(&s);
+  for (k = 0; k < nthreads; k++)
+    pthread_join(tids[k], NULL);
+
+  for (i = 0; i < s.count; i++)
+    free(s.paths[i]);
+  free(s.paths);
+
+  settings_batch_done(paths, count);
+}
+
+/*
+ * Startup statistics
+ */
+static int64_t
+settings_boot_begin(void)
+{
+  int64_t now;
+
+  if (!settings_booting || !pthread_equal(pthread_self(), settings_boot_thread))
+    return 0;
+  now = getmonoclock();
+  if (settings_boot_last)
+    settings_boot_last->create += now - settings_boot_mark;
+  settings_boot_last = NULL;
+  return now;
+}
+
+static void
+settings_boot_end(const char *pathfmt, settings_load_stats_t *stats, int64_t t0)
+{
+  settings_boot_stat_t *sbs;
+
+  if (t0 == 0 || !settings_booting)
+    return;
+  TAILQ_FOREACH(sbs, &settings_boot_stats, link)
+    if (strcmp(sbs->pathfmt, pathfmt) == 0)
+      break;
+  if (sbs == NULL) {
+    sbs = calloc(1, sizeof(*sbs));
+    sbs->pathfmt = strdup(pathfmt);
+    TAILQ_INSERT_TAIL(&settings_boot_stats, sbs, link);
+  }
+  sbs->loads++;
+  sbs->threads = MAX(sbs->threads, stats->threads);
+  sbs->total.read += stats->read;
+  sbs->total.parse += stats->parse;
+  sbs->total.bytes += stats->bytes;
+  sbs->total.files += stats->files;
+  settings_boot_mark = getmonoclock();
+  sbs->wall += settings_boot_mark - t0;
+  settings_boot_last = sbs;
+}
+
+/*
+ * Log the startup statistics (read, parse and object creation time)
+ */
+void
+hts_settings_boot_done(void)
+{
+  settings_boot_stat_t *sbs;
+  settings_load_stats_t total;
+  int64_t wall = 0, create = 0;
+
+  if (!settings_booting)
+    return;
+  settings_boot_begin();
+  settings_booting = 0;
+  memset(&total, 0, sizeof(total));
+  TAILQ_FOREACH(sbs, &settings_boot_stats, link) {
+    total.read += sbs->total.read;
+    total.parse += sbs->total.parse;
+    total.bytes += sbs->total.bytes;
+    total.files += sbs->total.files;
+    wall += sbs->wall;
+    create += sbs->create;
+  }
+  tvhinfo(LS_SETTINGS, "startup: loaded %d files (%"PRId64" kB) in %"PRId64" ms,"
+                       " read %"PRId64" ms, parse %"PRId64" ms, create %"PRId64" ms",
+          total.files, total.bytes / 1024, wall / 1000,
+          total.read / 1000, total.parse / 1000, create / 1000);
+  while ((sbs = TAILQ_FIRST(&settings_boot_stats)) != NULL) {
+    if (sbs->wall + sbs->create >= 10000)
+      tvhinfo(LS_SETTINGS, "startup:   %s: %d loads, %d files, %"PRId64" ms"
+                           " (read %"PRId64" ms, parse %"PRId64" ms, %d threads),"
+                           " create %"PRId64" ms",
+              sbs->pathfmt, sbs->loads, sbs->total.files, sbs->wall / 1000,
+              sbs->total.read / 1000, sbs->total.parse / 1000, sbs->threads,
+              sbs->create / 1000);
+    TAILQ_REMOVE(&settings_boot_stats, sbs, link);
+    free(sbs->pathfmt);
+    free(sbs);
+  }
+}
+
 /**
  *
  */
 static htsmsg_t *
-hts_settings_load_one(const char *filename)
+hts_settings_load_one(const char *filename, settings_load_stats_t *stats)
 {
   ssize_t n, size;
   char *mem;
   fb_file *fp;
   htsmsg_t *r = NULL;
+  int64_t t0, t1;
+
+  t0 = getmonoclock();
 
   /* Open */
   if (!(fp = fb_open(filename, 1, 0))) return NULL;
@@ -231,6 +1234,7 @@ hts_settings_load_one(const char *filename)
   mem    = malloc(size+1);
   n      = fb_read(fp, mem, size);
   if (n >= 0) mem[n] = 0;
+  t1 = getmonoclock();
 
   /* Decode */
   if(n == size) {
@@ -262,58 +1266,211 @@ hts_settings_load_one(const char *filename)
   fb_close(fp);
   free(mem);
 
+  if (stats) {
+    atomic_add_s64(&stats->read, t1 - t0);
+    atomic_add_s64(&stats->parse, getmonoclock() - t1);
+    atomic_add_s64(&stats->bytes, MAX(n, 0));
+    atomic_add(&stats->files, 1);
+  }
+
   return r;
 }
 
 /**
+ * Move the loaded file to the packed store
+ */
+static void
+hts_settings_load_import(const char *fullpath, htsmsg_t *r, htsmsg_t *import)
+{
+  const char *key;
+
+  if (r && import) {
+    key = fullpath + strlen(settingspath) + 1;
+    if (settings_pack_find(key) || settings_pack_save(key, r) == 0)
+      htsmsg_add_str(import, NULL, fullpath);
+  }
+}
+
+/*
+ * Directory loader
  *
+ * The tree is scanned first, then the files are read and parsed by
+ * a small pool of threads. The maps are built by the calling thread
+ * in the directory order, like the sequential loader did.
  */
-static htsmsg_t *
-hts_settings_load_path(const char *fullpath, int depth)
+typedef struct settings_load_job {
+  char       *path;
+  const char *name;
+  int         parent;           /* directory job, -1 = top */
+  int         dir;              /* 1 = directory, -1 = unreadable directory */
+  htsmsg_t   *msg;
+} settings_load_job_t;
+
+typedef struct settings_loader {
+  settings_load_job_t   *jobs;
+  int                    njobs;
+  int                    alloc;
+  int                    nfiles;
+  volatile int           next;
+  settings_load_stats_t *stats;
+} settings_loader_t;
+
+static int
+settings_load_walk
+  (settings_loader_t *l, const char *path, int depth, int parent)
 {
-  char child[PATH_MAX];
+  fb_dirent **namelist, *d;
+  settings_load_job_t *j;
   const char *name;
+  size_t plen = strlen(path);
+  int n, i, idx;
+
+  if ((n = fb_scandir(path, &namelist)) < 0)
+    return -1;
+  for (i = 0; i < n; i++) {
+    d = namelist[i];
+    name = d->name;
+    if (name[0] != '.' && name[0] && name[strlen(name)-1] != '~') {
+      if (l->njobs == l->alloc) {
+        l->alloc = MAX(64, l->alloc * 2);
+        l->jobs = realloc(l->jobs, l->alloc * sizeof(*l->jobs));
+      }
+      idx = l->njobs++;
+      j = &l->jobs[idx];
+      j->path = malloc(plen + strlen(name) + 2);
+      sprintf(j->path, "%s/%s", path, name);
+      j->name = j->path + plen + 1;
+      j->parent = parent;
+      j->dir = d->type == FB_DIR && depth > 0;
+      j->msg = NULL;
+      if (j->dir) {
+        if (settings_load_walk(l, l->jobs[idx].path, depth - 1, idx))
+          l->jobs[idx].dir = -1;
+      } else {
+        l->nfiles++;
+      }
+    }
+    free(d);
+  }
+  free(namelist);
+  return 0;
+}
+
+static void *
+settings_load_thread(void *aux)
+{
+  settings_loader_t *l = aux;
+  settings_load_job_t *j;
+  int i;
+
+  while ((i = atomic_add(&l->next, 1)) < l->njobs) {
+    j = &l->jobs[i];
+    if (j->dir == 0)
+      j->msg = hts_settings_load_one(j->path, l->stats);
+  }
+  return NULL;
+}
+
+static htsmsg_t *
+hts_settings_load_dir
+  (const char *fullpath, int depth, htsmsg_t *import, settings_load_stats_t *stats)
+{
+  settings_loader_t l;
+  settings_load_job_t *j;
+  pthread_t tids[SETTINGS_LOAD_THREADS];
+  htsmsg_t *r, *m;
+  long ncpu;
+  int i, k, nthreads = 0;
+
+  memset(&l, 0, sizeof(l));
+  l.stats = stats;
+  if (settings_load_walk(&l, fullpath, depth, -1))
+    return NULL;
+
+  /* Read and parse */
+  if (l.nfiles >= SETTINGS_LOAD_PARALLEL) {
+    /* more threads than CPUs keep the disk busy on a cold cache */
+    ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    k = MIN(MAX(2 * ncpu, 4), SETTINGS_LOAD_THREADS);
+    k = MIN(k, l.nfiles / (SETTINGS_LOAD_PARALLEL / 2));
+    for ( ; nthreads < k - 1; nthreads++)
+      if (tvh_thread_create(&tids[nthreads], NULL, settings_load_thread, &l, "settings"))
+        break;
+  }
+  settings_load_thread(&l);
+  for (k = 0; k < nthreads; k++)
+    pthread_join(tids[k], NULL);
+  stats->threads = MAX(stats->threads, nthreads + 1);
+
+  /* Build the maps */
+  r = htsmsg_create_map();
+  for (i = 0; i < l.njobs; i++) {
+    j = &l.jobs[i];
+    m = j->parent < 0 ? r : l.jobs[j->parent].msg;
+    if (m && j->dir > 0) {
+      j->msg = htsmsg_add_msg(m, j->name, htsmsg_create_map());
+    } else if (j->dir == 0 && j->msg) {
+      hts_settings_load_import(j->path, j->msg, import);
+      htsmsg_add_msg(m, j->name, j->msg);
+      j->msg = NULL;
+    }
+    free(j->path);
+  }
+  free(l.jobs);
+  return r;
+}
+
+/**
+ *
+ */
+static htsmsg_t *
+hts_settings_load_path(const char *fullpath, int depth, htsmsg_t *import,
+                       settings_load_stats_t *stats)
+{
   struct filebundle_stat st;
-  fb_dirent **namelist, *d;
-  htsmsg_t *r, *c;
-  int n, i;
+  htsmsg_t *r;
 
   /* Invalid */
   if (fb_stat(fullpath, &st)) return NULL;
 
   /* Directory */
-  if (st.is_dir) {
-
-    /* Get file list */
-    if((n = fb_scandir(fullpath, &namelist)) < 0)
-      return NULL;
+  if (st.is_dir)
+    return hts_settings_load_dir(fullpath, depth, import, stats);
 
-    /* Read files */
-    r = htsmsg_create_map();
-    for(i = 0; i < n; i++) {
-      d = namelist[i];
-      name = d->name;
-      if(name[0] != '.' && name[0] && name[strlen(name)-1] != '~') {
-
-        snprintf(child, sizeof(child), "%s/%s", fullpath, d->name);
-        if(d->type == FB_DIR && depth > 0) {
-          c = hts_settings_load_path(child, depth - 1);
-        } else {
-          c = hts_settings_load_one(child);
-        }
-        if(c != NULL)
-          htsmsg_add_msg(r, d->name, c);
+  /* File */
+  r = hts_settings_load_one(fullpath, stats);
+  stats->threads = MAX(stats->threads, 1);
+  hts_settings_load_import(fullpath, r, import);
+  return r;
+}
 
-      }
-      free(d);
-    }
-    free(namelist);
+/**
+ *
+ */
+static htsmsg_t *
+settings_pack_vload(const char *key, int depth, settings_load_stats_t *stats)
+{
+  char fullpath[PATH_MAX];
+  struct stat st;
+  htsmsg_t *r, *files;
+  int dir = 0;
 
-  /* File */
-  } else {
-    r = hts_settings_load_one(fullpath);
+  tvh_mutex_lock(&settings_pack_lock);
+  /* Import the remains of the directory tree first */
+  snprintf(fullpath, sizeof(fullpath), "%s/%s", settingspath, key);
+  if (stat(fullpath, &st) == 0) {
+    dir = S_ISDIR(st.st_mode);
+    files = htsmsg_create_list();
+    htsmsg_destroy(hts_settings_load_path(fullpath, depth, files, stats));
+    settings_pack_import(files, fullpath);
+    htsmsg_destroy(files);
   }
-
+  r = settings_pack_load(key, depth, stats);
+  /* configured, but everything was removed (no defaults from the bundle) */
+  if (r == NULL && dir)
+    r = htsmsg_create_map();
+  stats->threads = MAX(stats->threads, 1);
+  tvh_mutex_unlock(&settings_pack_lock);
   return r;
 }
 
@@ -325,23 +1482,38 @@ hts_settings_vload(const char *pathfmt, va_list ap, int depth)
 {
   htsmsg_t *ret = NULL;
   char fullpath[PATH_MAX];
-  va_list ap2;
+  const char *key;
+  settings_load_stats_t stats;
+  int64_t t0;
+  va_list ap2, ap3;
   va_copy(ap2, ap);
+  va_copy(ap3, ap);
 
-  /* Try normal path */
-  _hts_settings_buildpath(fullpath, sizeof(fullpath), 
-                          pathfmt, ap, settingspath);
-  ret = hts_settings_load_path(fullpath, depth);
+  memset(&stats, 0, sizeof(stats));
+  t0 = settings_boot_begin();
+
+  /* Try packed store, then normal path */
+  key = settings_pack_key(fullpath, sizeof(fullpath), pathfmt, ap3);
+  va_end(ap3);
+  if (key) {
+    ret = settings_pack_vload(key, depth, &stats);
+  } else {
+    _hts_settings_buildpath(fullpath, sizeof(fullpath),
+                            pathfmt, ap, settingspath);
+    ret = hts_settings_load_path(fullpath, depth, NULL, &stats);
+  }
 
   /* Try bundle path */
   if (!ret && *pathfmt != '/') {
     _hts_settings_buildpath(fullpath, sizeof(fullpath),
                             pathfmt, ap2, "data/conf");
-    ret = hts_settings_load_path(fullpath, depth);
+    ret = hts_settings_load_path(fullpath, depth, NULL, &stats);
   }
 
   va_end(ap2);
 
+  settings_boot_end(pathfmt, &stats, t0);
+
   return ret;
 }
 
@@ -376,17 +1548,28 @@ hts_settings_load_r(int depth, const char *pathfmt, ...)
 /**
  *
  */
-void
-hts_settings_remove(const char *pathfmt, ...)
+static void
+settings_remove0(const char *path)
 {
   char fullpath[PATH_MAX];
-  va_list ap;
+  const char *key;
   struct stat st;
+  size_t plen;
 
-  va_start(ap, pathfmt);
-  _hts_settings_buildpath(fullpath, sizeof(fullpath),
-                          pathfmt, ap, settingspath);
-  va_end(ap);
+  key = *path == '/' ? NULL :
+          settings_pack_keyf(fullpath, sizeof(fullpath), "%s", path);
+  if (key) {
+    tvh_mutex_lock(&settings_pack_lock);
+    if ((settings_pack_find(key) || settings_pack_first(key, &plen)) &&
+        settings_pack_append(SETTINGS_PACK_REMOVE, key, NULL, 0) == 0) {
+      settings_pack_index_remove(key);
+      settings_pack_wakeup();
+    }
+    tvh_mutex_unlock(&settings_pack_lock);
+  }
+
+  if (hts_settings_buildpath(fullpath, sizeof(fullpath), "%s", path))
+    return;
   if (stat(fullpath, &st) == 0) {
     if (S_ISDIR(st.st_mode))
       rmtree(fullpath);
@@ -397,6 +1580,19 @@ hts_settings_remove(const char *pathfmt, ...)
   }
 }
 
+void
+hts_settings_remove(const char *pathfmt, ...)
+{
+  char path[PATH_MAX];
+  va_list ap;
+
+  va_start(ap, pathfmt);
+  vsnprintf(path, sizeof(path), pathfmt, ap);
+  va_end(ap);
+  settings_batch_record(path, NULL);
+  settings_remove0(path);
+}
+
 /**
  *
  */
@@ -433,7 +1629,22 @@ hts_settings_exists ( const char *pathfmt, ... )
 {
   va_list ap;
   char path[PATH_MAX];
+  const char *key;
   struct stat st;
+  size_t plen;
+  int r = 0;
+
+  /* Packed store */
+  va_start(ap, pathfmt);
+  key = settings_pack_key(path, sizeof(path), pathfmt, ap);
+  va_end(ap);
+  if (key) {
+    tvh_mutex_lock(&settings_pack_lock);
+    r = settings_pack_find(key) || settings_pack_first(key, &plen);
+    tvh_mutex_unlock(&settings_pack_lock);
+    if (r)
+      return 1;
+  }
 
   /* Build path */
   va_start(ap, pathfmt);
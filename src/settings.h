@@ -26,12 +26,26 @@
 #define HTS_SETTINGS_OPEN_WRITE		(1<<0)
 #define HTS_SETTINGS_OPEN_DIRECT	(1<<1)
 
+#define HTS_SETTINGS_PACK_AUTO		0
+#define HTS_SETTINGS_PACK_ENABLE	1
+#define HTS_SETTINGS_PACK_EXPORT	2
+
 void hts_settings_init(const char *confpath);
 
 void hts_settings_done(void);
 
+void hts_settings_pack_init(int mode);
+
+void hts_settings_pack_done(void);
+
+void hts_settings_boot_done(void);
+
 void hts_settings_save(htsmsg_t *record, const char *pathfmt, ...);
 
+void hts_settings_save_begin(void);
+
+void hts_settings_save_batch(htsmsg_t **records, char **paths, int count);
+
 htsmsg_t *hts_settings_load(const char *pathfmt, ...);
 
 htsmsg_t *hts_settings_load_r(int depth, const char *pathfmt, ...);
@@ -66,6 +66,211 @@ streaming_message_data_size(streaming_message_t *sm)
   return 0;
 }
 
+/**
+ * Producer batches
+ */
+#define STREAMING_BATCH_MAX 32
+#define STREAMING_GOP_TIMEOUT sec2mono(5)
+
+static __thread struct {
+  int depth;
+  int count;
+  streaming_queue_t *queues[STREAMING_BATCH_MAX];
+} streaming_batch;
+
+void
+streaming_batch_begin(void)
+{
+  streaming_batch.depth++;
+}
+
+void
+streaming_batch_end(void)
+{
+  streaming_queue_t *sq;
+  int i;
+
+  if (--streaming_batch.depth > 0)
+    return;
+  for (i = 0; i < streaming_batch.count; i++) {
+    sq = streaming_batch.queues[i];
+    tvh_mutex_lock(&sq->sq_mutex);
+    sq->sq_batch = 0;
+    sq->sq_wake_mono = 0;
+    sq->sq_signals++;
+    tvh_cond_signal(&sq->sq_cond, 0);
+    tvh_mutex_unlock(&sq->sq_mutex);
+  }
+  streaming_batch.count = 0;
+}
+
+/**
+ *
+ */
+static void
+streaming_queue_signal(streaming_queue_t *sq)
+{
+  if (sq->sq_batch)
+    return;
+  if (streaming_batch.depth > 0 &&
+      streaming_batch.count < STREAMING_BATCH_MAX) {
+    streaming_batch.queues[streaming_batch.count++] = sq;
+    sq->sq_batch = 1;
+    return;
+  }
+  sq->sq_wake_mono = 0;
+  sq->sq_signals++;
+  tvh_cond_signal(&sq->sq_cond, 0);
+}
+
+/**
+ * Backpressure
+ */
+int
+streaming_target_pressure(streaming_target_t *st, streaming_pressure_t *bp)
+{
+  memset(bp, 0, sizeof(*bp));
+  if (st == NULL || st->st_ops.st_pressure == NULL)
+    return -1;
+  return st->st_ops.st_pressure(st->st_opaque, bp);
+}
+
+/**
+ * Returns 0 when the target is within the limits, 1..3 when it is
+ * over the limit (two and three times), 4 when the data must be dropped
+ */
+int
+streaming_pressure_level(const streaming_pressure_t *bp)
+{
+  int level = 0, l;
+
+  if (bp->bp_max_bytes && bp->bp_bytes > bp->bp_max_bytes)
+    level = (bp->bp_bytes - 1) / bp->bp_max_bytes;
+  if (bp->bp_max_delay > 0 && bp->bp_delay > bp->bp_max_delay) {
+    l = (bp->bp_delay - 1) / bp->bp_max_delay;
+    level = MAX(level, l);
+  }
+  return MIN(level, 4);
+}
+
+/**
+ * Returns 1 when the packet should be dropped, the packet is NULL
+ * for the data without the frame information (MPEG-TS). The GOP skip
+ * holds the last time over the limit, it also ends without an I frame
+ * after STREAMING_GOP_TIMEOUT (not all parsers mark the frame types).
+ */
+int
+streaming_pressure_drop
+  (streaming_policy_t policy, int level, th_pkt_t *pkt, int64_t *gop_skip)
+{
+  int video;
+
+  if (pkt == NULL)
+    return policy == SQ_POLICY_PAUSE ? level >= 4 : level > 0;
+  video = SCT_ISVIDEO(pkt->pkt_type);
+  switch (policy) {
+  case SQ_POLICY_FRAME:
+    if (video) {
+      if (pkt->v.pkt_frametype == PKT_B_FRAME)
+        return level >= 1;
+      if (pkt->v.pkt_frametype == PKT_P_FRAME)
+        return level >= 2;
+      return level >= 3;
+    }
+    return level >= 4;
+  case SQ_POLICY_GOP:
+    if (video) {
+      if (level > 0) {
+        *gop_skip = mclk();
+        return 1;
+      }
+      if (*gop_skip) {
+        if (pkt->v.pkt_frametype != PKT_I_FRAME &&
+            mclk() - *gop_skip < STREAMING_GOP_TIMEOUT)
+          return 1;
+        *gop_skip = 0;
+      }
+      return 0;
+    }
+    return level >= 4;
+  case SQ_POLICY_PAUSE:
+    return level >= 4;
+  default:
+    return level > 0;
+  }
+}
+
+const char *
+streaming_policy2txt(streaming_policy_t policy)
+{
+  switch (policy) {
+  case SQ_POLICY_DROP:  return "drop";
+  case SQ_POLICY_FRAME: return "frame";
+  case SQ_POLICY_GOP:   return "gop";
+  case SQ_POLICY_PAUSE: return "pause";
+  }
+  return "unknown";
+}
+
+/**
+ *
+ */
+static void
+streaming_queue_pressure0(streaming_queue_t *sq, streaming_pressure_t *bp)
+{
+  streaming_message_t *sm = TAILQ_FIRST(&sq->sq_queue);
+
+  bp->bp_bytes = sq->sq_size;
+  bp->bp_delay = sm ? mclk() - sm->sm_queued : 0;
+  bp->bp_max_bytes = sq->sq_maxsize;
+  bp->bp_max_delay = sq->sq_maxdelay;
+  bp->bp_peak_delay = MAX(sq->sq_peak_delay, bp->bp_delay);
+  bp->bp_drops = sq->sq_drops;
+  bp->bp_drop_bytes = sq->sq_drop_bytes;
+}
+
+static int
+streaming_queue_pressure(void *opaque, streaming_pressure_t *bp)
+{
+  streaming_queue_t *sq = opaque;
+
+  tvh_mutex_lock(&sq->sq_mutex);
+  streaming_queue_pressure0(sq, bp);
+  tvh_mutex_unlock(&sq->sq_mutex);
+  return 0;
+}
+
+/**
+ *
+ */
+static inline void
+streaming_queue_peak(streaming_queue_t *sq, streaming_message_t *sm)
+{
+  int64_t delay = mclk() - sm->sm_queued;
+  if (delay > sq->sq_peak_delay)
+    sq->sq_peak_delay = delay;
+}
+
+/**
+ * Queue protection - apply the backpressure policy
+ */
+static int
+streaming_queue_drop(streaming_queue_t *sq, streaming_message_t *sm)
+{
+  streaming_pressure_t bp;
+  th_pkt_t *pkt = sm->sm_type == SMT_PACKET ? sm->sm_data : NULL;
+
+  if (sq->sq_maxsize == 0 && sq->sq_maxdelay == 0)
+    return 0;
+  streaming_queue_pressure0(sq, &bp);
+  if (!streaming_pressure_drop(sq->sq_policy, streaming_pressure_level(&bp),
+                               pkt, &sq->sq_gop_skip))
+    return 0;
+  sq->sq_drops++;
+  sq->sq_drop_bytes += streaming_message_data_size(sm);
+  return 1;
+}
+
 /**
  *
  */
@@ -73,18 +278,31 @@ static void
 streaming_queue_deliver(void *opauqe, streaming_message_t *sm)
 {
   streaming_queue_t *sq = opauqe;
+  int data = sm->sm_type == SMT_PACKET || sm->sm_type == SMT_MPEGTS;
 
   tvh_mutex_lock(&sq->sq_mutex);
 
-  /* queue size protection */
-  if (sq->sq_maxsize && sq->sq_maxsize < sq->sq_size) {
+  /* queue size protection, the control messages are always passed */
+  if (data && streaming_queue_drop(sq, sm)) {
     streaming_msg_free(sm);
   } else {
+    sm->sm_queued = mclk();
     TAILQ_INSERT_TAIL(&sq->sq_queue, sm, sm_link);
     sq->sq_size += streaming_message_data_size(sm);
+    sq->sq_msgs++;
   }
 
-  tvh_cond_signal(&sq->sq_cond, 0);
+  /* adaptive wakeup, the control messages are passed immediately */
+  if (data && sq->sq_wake_bytes) {
+    if (sq->sq_wake_mono == 0)
+      sq->sq_wake_mono = mclk();
+    if (sq->sq_size < sq->sq_wake_bytes &&
+        mclk() - sq->sq_wake_mono < sq->sq_wake_delay)
+      goto end;
+  }
+
+  streaming_queue_signal(sq);
+end:
   tvh_mutex_unlock(&sq->sq_mutex);
 }
 
@@ -95,12 +313,20 @@ static htsmsg_t *
 streaming_queue_info(void *opaque, htsmsg_t *list)
 {
   streaming_queue_t *sq = opaque;
-  size_t size;
+  streaming_pressure_t bp;
+  uint64_t msgs, signals;
   char buf[256];
   tvh_mutex_lock(&sq->sq_mutex);
-  size = sq->sq_size;
+  streaming_queue_pressure0(sq, &bp);
+  msgs = sq->sq_msgs;
+  signals = sq->sq_signals;
   tvh_mutex_unlock(&sq->sq_mutex);
-  snprintf(buf, sizeof(buf), "streaming queue %p size %zd", sq, size);
+  snprintf(buf, sizeof(buf), "streaming queue %p size %zd msgs %"PRIu64
+                             " wakeups %"PRIu64" delay %"PRId64"ms"
+                             " drops %"PRIu64" policy %s",
+                             sq, bp.bp_bytes, msgs, signals,
+                             mono2ms(bp.bp_delay), bp.bp_drops,
+                             streaming_policy2txt(sq->sq_policy));
   htsmsg_add_str(list, NULL, buf);
   return list;
 }
@@ -113,6 +339,46 @@ streaming_queue_remove(streaming_queue_t *sq, streaming_message_t *sm)
 {
   sq->sq_size -= streaming_message_data_size(sm);
   TAILQ_REMOVE(&sq->sq_queue, sm, sm_link);
+  streaming_queue_peak(sq, sm);
+}
+
+/**
+ * Move all queued messages to the consumer queue (sq_mutex is held)
+ */
+void
+streaming_queue_take(streaming_queue_t *sq, struct streaming_message_queue *q)
+{
+  streaming_message_t *sm = TAILQ_FIRST(&sq->sq_queue);
+
+  if (sm)
+    streaming_queue_peak(sq, sm);
+  TAILQ_CONCAT(q, &sq->sq_queue, sm_link);
+  sq->sq_size = 0;
+  sq->sq_wake_mono = 0;
+}
+
+/**
+ * Wakeup the consumer when the queue holds the given bytes or when
+ * the data waits for the given time, 0 bytes = for each message
+ */
+void
+streaming_queue_wakeup(streaming_queue_t *sq, size_t bytes, int64_t delay)
+{
+  sq->sq_wake_bytes = bytes;
+  sq->sq_wake_delay = delay;
+  sq->sq_wake_mono = 0;
+}
+
+/**
+ * Set the backpressure policy and the queue delay limit (sq_mutex is held)
+ */
+void
+streaming_queue_policy
+  (streaming_queue_t *sq, streaming_policy_t policy, int64_t maxdelay)
+{
+  sq->sq_policy = policy;
+  sq->sq_maxdelay = maxdelay;
+  sq->sq_gop_skip = 0;
 }
 
 /**
@@ -122,8 +388,9 @@ void
 streaming_queue_init(streaming_queue_t *sq, int reject_filter, size_t maxsize)
 {
   static streaming_ops_t ops = {
-    .st_cb   = streaming_queue_deliver,
-    .st_info = streaming_queue_info
+    .st_cb       = streaming_queue_deliver,
+    .st_info     = streaming_queue_info,
+    .st_pressure = streaming_queue_pressure
   };
 
   streaming_target_init(&sq->sq_st, &ops, sq, reject_filter);
@@ -134,6 +401,18 @@ streaming_queue_init(streaming_queue_t *sq, int reject_filter, size_t maxsize)
 
   sq->sq_maxsize = maxsize;
   sq->sq_size = 0;
+  sq->sq_wake_bytes = 0;
+  sq->sq_wake_delay = 0;
+  sq->sq_wake_mono = 0;
+  sq->sq_batch = 0;
+  sq->sq_msgs = 0;
+  sq->sq_signals = 0;
+  sq->sq_policy = SQ_POLICY_DROP;
+  sq->sq_maxdelay = 0;
+  sq->sq_gop_skip = 0;
+  sq->sq_peak_delay = 0;
+  sq->sq_drops = 0;
+  sq->sq_drop_bytes = 0;
 }
 
 /**
@@ -208,6 +487,7 @@ streaming_msg_create(streaming_message_type_t type)
   sm->sm_time = 0;
   sm->sm_s = NULL;
 #endif
+  sm->sm_queued = 0;
   return sm;
 }
 
@@ -266,6 +546,7 @@ streaming_msg_clone(streaming_message_t *src)
   dst->sm_time      = src->sm_time;
   dst->sm_s         = src->sm_s;
 #endif
+  dst->sm_queued    = 0;
 
   switch(src->sm_type) {
 
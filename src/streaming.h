@@ -43,6 +43,7 @@ typedef struct streaming_message streaming_message_t;
 typedef struct streaming_ops streaming_ops_t;
 typedef struct streaming_queue streaming_queue_t;
 typedef struct source_info source_info_t;
+typedef struct streaming_pressure streaming_pressure_t;
 typedef struct streaming_start_component streaming_start_component_t;
 typedef struct streaming_start streaming_start_t;
 
@@ -324,12 +325,37 @@ struct streaming_message {
 #if ENABLE_TIMESHIFT
   int64_t sm_time;
 #endif
+  int64_t sm_queued;  /* Time when the message was queued (mono) */
   union {
     void *sm_data;
     int sm_code;
   };
 };
 
+/**
+ * Backpressure - the target state as seen by the producer
+ */
+struct streaming_pressure {
+  size_t   bp_bytes;       /* Queued data (bytes) */
+  int64_t  bp_delay;       /* The oldest queued data waits (mono) */
+  size_t   bp_max_bytes;   /* Limit (bytes), 0 = unlimited */
+  int64_t  bp_max_delay;   /* Limit (mono), 0 = unlimited */
+  int64_t  bp_peak_delay;  /* Statistics - the longest wait (mono) */
+  uint64_t bp_drops;       /* Statistics - dropped data messages */
+  uint64_t bp_drop_bytes;  /* Statistics - dropped data (bytes) */
+};
+
+/**
+ * Backpressure policy - what to do with the data over the limits
+ */
+typedef enum {
+  SQ_POLICY_DROP = 0,  /* drop the new data */
+  SQ_POLICY_FRAME,     /* drop B frames, then P frames, then everything */
+  SQ_POLICY_GOP,       /* drop the video up to the next I frame, the
+                          raw MPEG-TS (pass-through) is dropped as DROP */
+  SQ_POLICY_PAUSE,     /* the producer pauses (file-backed sources) */
+} streaming_policy_t;
+
 /**
  * A streaming target receives data.
  */
@@ -338,6 +364,7 @@ typedef void (st_callback_t)(void *opaque, streaming_message_t *sm);
 struct streaming_ops {
   st_callback_t *st_cb;
   htsmsg_t *(*st_info)(void *opaque, htsmsg_t *list);
+  int (*st_pressure)(void *opaque, streaming_pressure_t *bp);
 };
 
 typedef struct streaming_target {
@@ -363,6 +390,21 @@ struct streaming_queue {
 
   struct streaming_message_queue sq_queue;
 
+  size_t      sq_wake_bytes; /* Wakeup the consumer at this size, 0 = always */
+  int64_t     sq_wake_delay; /* ... or when the data waits this long (mono) */
+  int64_t     sq_wake_mono;  /* First data message not signalled yet */
+  int         sq_batch;      /* Signal postponed to the end of the batch */
+
+  uint64_t    sq_msgs;       /* Statistics - queued messages */
+  uint64_t    sq_signals;    /* Statistics - consumer wakeups */
+
+  streaming_policy_t sq_policy; /* Backpressure policy */
+  int64_t     sq_maxdelay;   /* Max queue delay (mono), 0 = unlimited */
+  int64_t     sq_gop_skip;   /* Video dropped since (mono) up to the next I frame */
+  int64_t     sq_peak_delay; /* Statistics - the longest wait */
+  uint64_t    sq_drops;      /* Statistics - dropped data messages */
+  uint64_t    sq_drop_bytes; /* Statistics - dropped data (bytes) */
+
 };
 
 streaming_component_type_t streaming_component_txt2type(const char *str);
@@ -397,6 +439,7 @@ struct streaming_start_component {
 
   uint8_t ssc_disabled;
   uint8_t ssc_muxer_disabled;
+  uint8_t ssc_rendition;     /* transcoder ladder rendition (1..), 0 = none */
   
   pktbuf_t *ssc_gh;
 };
@@ -435,6 +478,35 @@ void streaming_queue_deinit(streaming_queue_t *sq);
 
 void streaming_queue_remove(streaming_queue_t *sq, streaming_message_t *sm);
 
+void streaming_queue_take(streaming_queue_t *sq, struct streaming_message_queue *q);
+
+void streaming_queue_wakeup(streaming_queue_t *sq, size_t bytes, int64_t delay);
+
+void streaming_queue_policy
+  (streaming_queue_t *sq, streaming_policy_t policy, int64_t maxdelay);
+
+/*
+ * Backpressure - the producers query the target state and apply
+ * the drop policy, the file-backed producers may pause instead.
+ */
+int streaming_target_pressure(streaming_target_t *st, streaming_pressure_t *bp);
+
+int streaming_pressure_level(const streaming_pressure_t *bp);
+
+int streaming_pressure_drop
+  (streaming_policy_t policy, int level, th_pkt_t *pkt, int64_t *gop_skip);
+
+const char *streaming_policy2txt(streaming_policy_t policy);
+
+/*
+ * Producer batch - the streaming queues are signalled only once at
+ * the end of the batch. The batch must not outlive the lock which
+ * protects the delivery path (usually the service stream mutex).
+ */
+void streaming_batch_begin(void);
+
+void streaming_batch_end(void);
+
 void streaming_target_connect(streaming_pad_t *sp, streaming_target_t *st);
 
 void streaming_target_disconnect(streaming_pad_t *sp, streaming_target_t *st);
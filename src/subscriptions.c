@@ -115,6 +115,10 @@ subscription_link_service(th_subscription_t *s, service_t *t)
     sm = streaming_msg_create_code(SMT_SERVICE_STATUS, 
 				   t->s_streaming_status);
     streaming_target_deliver(s->ths_output, sm);
+
+    // Start from the cached keyframe when the service is kept hot
+    if (s->ths_parser && parser_replay(s->ths_parser) > 0)
+      tvhdebug(LS_SUBSCRIPTION, "%04X: started from the GOP cache", shortid(s));
   }
 
   tvh_mutex_unlock(&t->s_stream_mutex);
@@ -1007,6 +1011,8 @@ subscription_create_msg(th_subscription_t *s, const char *lang)
   const char *state;
   htsmsg_t *l;
   mpegts_apids_t *pids = NULL;
+  streaming_pressure_t bp;
+  int rate;
 
   htsmsg_add_u32(m, "id", s->ths_id);
   htsmsg_add_u32(m, "start", s->ths_start);
@@ -1061,6 +1067,12 @@ subscription_create_msg(th_subscription_t *s, const char *lang)
       }
       htsmsg_add_str(m, "descramble", buf);
     }
+    if (t->s_parser && (rate = parser_gop_hit_rate(t->s_parser)) >= 0)
+      htsmsg_add_u32(m, "gop_hit_rate", rate);
+    if (s->ths_join_latency)
+      htsmsg_add_s64(m, "join_latency", mono2ms(s->ths_join_latency));
+    if (s->ths_gop_replayed)
+      htsmsg_add_u32(m, "gop_replayed", s->ths_gop_replayed);
     tvh_mutex_unlock(&t->s_stream_mutex);
 
     if (t->s_pid_list) {
@@ -1096,6 +1108,14 @@ subscription_create_msg(th_subscription_t *s, const char *lang)
   htsmsg_add_s64(m, "total_in", atomic_get_u64(&s->ths_total_bytes_in));
   htsmsg_add_s64(m, "total_out", atomic_get_u64(&s->ths_total_bytes_out));
 
+  if (!streaming_target_pressure(s->ths_output, &bp)) {
+    htsmsg_add_s64(m, "queue", bp.bp_bytes);
+    htsmsg_add_s64(m, "queue_delay", mono2ms(bp.bp_delay));
+    htsmsg_add_s64(m, "queue_peak", mono2ms(bp.bp_peak_delay));
+    htsmsg_add_s64(m, "drops", bp.bp_drops);
+    htsmsg_add_s64(m, "drop_bytes", bp.bp_drop_bytes);
+  }
+
   return m;
 }
 
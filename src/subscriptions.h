@@ -43,6 +43,7 @@ extern struct th_subscription_list subscriptions;
 #define SUBSCRIPTION_EPG        0x8000 ///< for mux subscriptions
 #define SUBSCRIPTION_HTSP      0x10000
 #define SUBSCRIPTION_SWSERVICE 0x20000
+#define SUBSCRIPTION_HOT       0x40000 ///< hot channel, keeps the GOP cache
 
 /* Some internal priorities */
 #define SUBSCRIPTION_PRIO_KEEP        1 ///< Keep input rolling
@@ -105,6 +106,8 @@ typedef struct th_subscription {
   uint64_t ths_total_bytes_out_prev; /* total bytes since the subscription started, minus 1 second */
   int ths_bytes_in_avg; /* Average bytes in per second */
   int ths_bytes_out_avg; /* Average bytes out per second */
+  int64_t ths_join_latency; /* link to the first keyframe (us), 0 = none yet */
+  int ths_gop_replayed; /* packets replayed from the keyframe cache */
 
   streaming_target_t ths_input;
 
@@ -396,9 +396,17 @@ timeshift_input_info(void *opaque, htsmsg_t *list)
   return list;
 }
 
+static int
+timeshift_input_pressure(void *opaque, streaming_pressure_t *bp)
+{
+  timeshift_t *ts = opaque;
+  return streaming_target_pressure(ts->output, bp);
+}
+
 static streaming_ops_t timeshift_input_ops = {
-  .st_cb   = timeshift_input,
-  .st_info = timeshift_input_info
+  .st_cb       = timeshift_input,
+  .st_info     = timeshift_input_info,
+  .st_pressure = timeshift_input_pressure
 };
 
 
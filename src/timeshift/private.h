@@ -22,6 +22,7 @@
 #define TIMESHIFT_PLAY_BUF         1000000 //< us to buffer in TX
 #define TIMESHIFT_FILE_PERIOD      60      //< number of secs in each buffer file
 #define TIMESHIFT_BACKLOG_MAX      16      //< maximum elementary streams
+#define TIMESHIFT_READAHEAD        (4*1024*1024) //< bytes to prefetch on file open
 
 /**
  * Indexes of import data in the stream
@@ -22,6 +22,7 @@
 #include "timeshift/private.h"
 #include "atomic.h"
 #include "tvhpoll.h"
+#include "tvhio.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -256,6 +257,15 @@ static ssize_t _read_msg ( timeshift_file_t *tsf, int fd, streaming_message_t **
  * Utilities
  * *************************************************************************/
 
+static int _timeshift_output_full ( timeshift_t *ts )
+{
+  streaming_pressure_t bp;
+
+  if (streaming_target_pressure(ts->output, &bp))
+    return 0;
+  return streaming_pressure_level(&bp) > 0;
+}
+
 static int64_t _timeshift_first_time
   ( timeshift_t *ts, int *active )
 { 
@@ -423,6 +433,9 @@ static int _timeshift_read
       tvhtrace(LS_TIMESHIFT, "ts %d open file %s (fd %i)", ts->id, tsf->path, tsf->rfd);
       if (tsf->rfd < 0)
         return -1;
+      if (tsf->woff > tsf->roff)
+        tvhio_readahead(tsf->rfd, tsf->roff,
+                        MIN(tsf->woff - tsf->roff, TIMESHIFT_READAHEAD));
     }
     if (tsf->rfd >= 0)
       if ((off = lseek(tsf->rfd, tsf->roff, SEEK_SET)) != tsf->roff)
@@ -834,8 +847,12 @@ void *timeshift_reader ( void *p )
     }
     ctrl = NULL;
 
-    /* Deliver */
-    if (sm && (skip ||
+    /* Deliver, the output backpressure pauses the playback */
+    if (sm && !skip && _timeshift_output_full(ts)) {
+
+      wait = 10;
+
+    } else if (sm && (skip ||
                (((cur_speed < 0) && (sm->sm_time >= deliver)) ||
                 ((cur_speed > 0) && (sm->sm_time <= deliver))))) {
 
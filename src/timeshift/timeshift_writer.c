@@ -401,25 +401,33 @@ void *timeshift_writer ( void *aux )
   timeshift_t *ts = aux;
   streaming_queue_t *sq = &ts->wr_queue;
   streaming_message_t *sm;
+  struct streaming_message_queue pending;
 
+  TAILQ_INIT(&pending);
   tvh_mutex_lock(&sq->sq_mutex);
+  streaming_queue_wakeup(sq, 64*1024, ms2mono(50));
 
   while (run) {
 
-    /* Get message */
-    sm = TAILQ_FIRST(&sq->sq_queue);
-    if (sm == NULL) {
-      tvh_cond_wait(&sq->sq_cond, &sq->sq_mutex);
+    /* Get messages */
+    if (TAILQ_EMPTY(&sq->sq_queue)) {
+      /* poll, the data below the wakeup size is not signalled on a stall */
+      tvh_cond_timedwait(&sq->sq_cond, &sq->sq_mutex,
+                         mclk() + sq->sq_wake_delay);
       continue;
     }
-    streaming_queue_remove(sq, sm);
+    streaming_queue_take(sq, &pending);
     tvh_mutex_unlock(&sq->sq_mutex);
 
-    _process_msg(ts, sm, &run);
+    while (run && (sm = TAILQ_FIRST(&pending)) != NULL) {
+      TAILQ_REMOVE(&pending, sm, sm_link);
+      _process_msg(ts, sm, &run);
+    }
 
     tvh_mutex_lock(&sq->sq_mutex);
   }
 
   tvh_mutex_unlock(&sq->sq_mutex);
+  streaming_queue_clear(&pending);
   return NULL;
 }
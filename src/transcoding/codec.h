@@ -61,6 +61,7 @@ struct tvh_codec {
     const codec_profile_class_t *idclass;
     AVCodec *codec;
     const AVProfile *profiles;
+    int pseudo; // no libav encoder, video only (ladder)
     int (*profile_init)(TVHCodecProfile *, htsmsg_t *conf);
     void (*profile_destroy)(TVHCodecProfile *);
     SLIST_ENTRY(tvh_codec) link;
@@ -92,6 +93,8 @@ struct tvh_codec_profile {
     double bit_rate;
     double qscale;
     int profile;
+    int threads;
+    int thread_type;
     char *device; // for hardware acceleration
     LIST_ENTRY(tvh_codec_profile) link;
 };
@@ -122,6 +125,21 @@ tvh_codec_profile_is_copy(TVHCodecProfile *self, tvh_ssc_t *ssc); // XXX: not to
 int
 tvh_codec_profile_open(TVHCodecProfile *self, AVDictionary **opts);
 
+int
+tvh_codec_profile_open_threads(TVHCodecProfile *self, AVDictionary **opts);
+
+
+/* ladder */
+#define TVH_LADDER_MAX 8
+
+int
+tvh_codec_profile_is_ladder(TVHCodecProfile *self);
+
+int
+tvh_codec_profile_ladder_get_renditions(TVHCodecProfile *self,
+                                        TVHCodecProfile **renditions,
+                                        int max);
+
 
 /* video */
 int
@@ -31,6 +31,7 @@ extern TVHCodec tvh_codec_mp2;
 extern TVHCodec tvh_codec_aac;
 extern TVHCodec tvh_codec_vorbis;
 extern TVHCodec tvh_codec_flac;
+extern TVHCodec tvh_codec_ladder;
 
 #if ENABLE_LIBX264
 extern TVHCodec tvh_codec_libx264;
@@ -173,7 +174,8 @@ tvh_codec_register(TVHCodec *self)
         return;
     }
 
-    if ((codec = avcodec_find_encoder_by_name(self->name)) &&
+    if (!self->pseudo &&
+        (codec = avcodec_find_encoder_by_name(self->name)) &&
         !(codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE)) {
         tvh_codec_init(self, codec);
         self->codec = codec; // enabled
@@ -210,6 +212,9 @@ tvh_codec_get_title(TVHCodec *self)
 enum AVMediaType
 tvh_codec_get_type(TVHCodec *self)
 {
+    if (self->pseudo) {
+        return AVMEDIA_TYPE_VIDEO;
+    }
     return self->codec ? codec_get_type(self->codec) : AVMEDIA_TYPE_UNKNOWN;
 }
 
@@ -217,6 +222,9 @@ tvh_codec_get_type(TVHCodec *self)
 const char *
 tvh_codec_get_type_string(TVHCodec *self)
 {
+    if (self->pseudo) {
+        return av_get_media_type_string(AVMEDIA_TYPE_VIDEO);
+    }
     return self->codec ? codec_get_type_string(self->codec) : "<unknown>";
 }
 
@@ -231,7 +239,7 @@ tvh_codec_get_codec(TVHCodec *self)
 int
 tvh_codec_is_enabled(TVHCodec *self)
 {
-    return self->codec ? 1 : 0;
+    return (self->codec || self->pseudo) ? 1 : 0;
 }
 
 
@@ -258,6 +266,7 @@ tvh_codecs_register()
     tvh_codec_register(&tvh_codec_aac);
     tvh_codec_register(&tvh_codec_vorbis);
     tvh_codec_register(&tvh_codec_flac);
+    tvh_codec_register(&tvh_codec_ladder);
 
 #if ENABLE_LIBX264
     tvh_codec_register(&tvh_codec_libx264);
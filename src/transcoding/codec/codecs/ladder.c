@@ -0,0 +1,159 @@
+/*
+ *  tvheadend - Codec Profiles
+ *
+ *  Copyright (C) 2016 Tvheadend
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "transcoding/codec/internals.h"
+
+
+/* ladder =================================================================== */
+
+static int
+tvh_codec_profile_ladder_is_copy(TVHCodecProfile *self, tvh_ssc_t *ssc)
+{
+    return 0;
+}
+
+
+static void
+tvh_codec_profile_ladder_destroy(TVHCodecProfile *_self)
+{
+    TVHLadderCodecProfile *self = (TVHLadderCodecProfile *)_self;
+    free(self->renditions);
+}
+
+
+/* codec_profile_ladder_class.renditions */
+
+static int
+codec_profile_ladder_class_renditions_set(void *obj, const void *val)
+{
+    TVHLadderCodecProfile *self = (TVHLadderCodecProfile *)obj;
+    char *s = htsmsg_list_2_csv((htsmsg_t *)val, ',', 0);
+    int change = 0;
+
+    if (s) {
+        change = strcmp(self->renditions ?: "", s) != 0;
+        free(self->renditions);
+        self->renditions = s;
+    }
+    return change;
+}
+
+
+static const void *
+codec_profile_ladder_class_renditions_get(void *obj)
+{
+    TVHLadderCodecProfile *self = (TVHLadderCodecProfile *)obj;
+    return htsmsg_csv_2_list(self->renditions, ',');
+}
+
+
+static htsmsg_t *
+codec_profile_ladder_class_renditions_list(void *obj, const char *lang)
+{
+    return codec_get_profiles_list(AVMEDIA_TYPE_VIDEO);
+}
+
+
+static const codec_profile_class_t codec_profile_ladder_class = {
+    {
+        .ic_super      = (idclass_t *)&codec_profile_class,
+        .ic_class      = "codec_profile_ladder",
+        .ic_caption    = N_("ladder"),
+        .ic_properties = (const property_t[]){
+            {
+                .type     = PT_STR,
+                .islist   = 1,
+                .id       = "renditions",
+                .name     = N_("Renditions"),
+                .desc     = N_("Video codec profiles encoded from a single "
+                               "decode of the source, in the listed order. "
+                               "The first one is the default rendition."),
+                .group    = 3,
+                .get      = codec_profile_ladder_class_renditions_get,
+                .set      = codec_profile_ladder_class_renditions_set,
+                .list     = codec_profile_ladder_class_renditions_list,
+                .opts     = PO_DOC_NLIST,
+            },
+            {}
+        }
+    },
+    .is_copy = tvh_codec_profile_ladder_is_copy,
+};
+
+
+TVHCodec tvh_codec_ladder = {
+    .name    = "ladder",
+    .size    = sizeof(TVHLadderCodecProfile),
+    .idclass = &codec_profile_ladder_class,
+    .pseudo  = 1,
+    .profile_destroy = tvh_codec_profile_ladder_destroy,
+};
+
+
+/* exposed */
+
+int
+tvh_codec_profile_is_ladder(TVHCodecProfile *self)
+{
+    TVHCodec *codec = tvh_codec_profile_get_codec(self);
+    return (codec == &tvh_codec_ladder);
+}
+
+
+int
+tvh_codec_profile_ladder_get_renditions(TVHCodecProfile *_self,
+                                        TVHCodecProfile **renditions,
+                                        int max)
+{
+    TVHLadderCodecProfile *self = (TVHLadderCodecProfile *)_self;
+    TVHCodecProfile *profile = NULL;
+    TVHCodec *codec = NULL;
+    htsmsg_t *list = NULL;
+    htsmsg_field_t *field = NULL;
+    const char *name = NULL;
+    int count = 0;
+
+    if (!tvh_codec_profile_is_ladder(_self) ||
+        !(list = htsmsg_csv_2_list(self->renditions, ','))) {
+        return 0;
+    }
+    HTSMSG_FOREACH(field, list) {
+        if (count >= max) {
+            break;
+        }
+        if (!(name = htsmsg_field_get_str(field)) ||
+            !(profile = tvh_codec_profile_find(name))) {
+            tvherror(LS_CODEC, "ladder '%s': rendition '%s' not found",
+                     self->name, name ?: "<unknown>");
+            continue;
+        }
+        codec = tvh_codec_profile_get_codec(profile);
+        if (codec == NULL || codec->pseudo ||
+            tvh_codec_get_type(codec) != AVMEDIA_TYPE_VIDEO ||
+            !tvh_codec_is_enabled(codec)) {
+            tvherror(LS_CODEC, "ladder '%s': rendition '%s' is not usable",
+                     self->name, name);
+            continue;
+        }
+        renditions[count++] = profile;
+    }
+    htsmsg_destroy(list);
+    return count;
+}
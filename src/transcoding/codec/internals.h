@@ -234,4 +234,12 @@ typedef struct tvh_codec_profile_audio {
 } TVHAudioCodecProfile;
 
 
+/* ladder */
+
+typedef struct tvh_codec_profile_ladder {
+    TVHCodecProfile;
+    char *renditions;
+} TVHLadderCodecProfile;
+
+
 #endif // TVH_TRANSCODING_CODEC_INTERNALS_H__
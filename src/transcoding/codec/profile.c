@@ -213,8 +213,23 @@ tvh_codec_profile_is_copy(TVHCodecProfile *self, tvh_ssc_t *ssc)
     const codec_profile_class_t *codec_profile_class = NULL;
     AVCodec *avcodec = NULL;
     tvh_sct_t out_type = SCT_UNKNOWN;
-
-
+    TVHCodecProfile *renditions[TVH_LADDER_MAX];
+    int i, count;
+
+    if (tvh_codec_profile_is_ladder(self)) {
+        count = tvh_codec_profile_ladder_get_renditions(self, renditions,
+                                                        TVH_LADDER_MAX);
+        if (!count) {
+            tvherror(LS_CODEC, "ladder '%s' has no renditions", self->name);
+            return -1;
+        }
+        for (i = 0; i < count; i++) {
+            if (tvh_codec_profile_setup(renditions[i], ssc)) {
+                return -1;
+            }
+        }
+        return 0;
+    }
     if (tvh_codec_profile_setup(self, ssc)) {
         return -1;
     }
@@ -261,6 +276,24 @@ tvh_codec_profile_open(TVHCodecProfile *self, AVDictionary **opts)
 }
 
 
+int
+tvh_codec_profile_open_threads(TVHCodecProfile *self, AVDictionary **opts)
+{
+    AV_DICT_SET_INT(opts, "threads", self->threads, AV_DICT_DONT_OVERWRITE);
+    switch (self->thread_type) {
+        case 1:
+            AV_DICT_SET(opts, "thread_type", "frame", AV_DICT_DONT_OVERWRITE);
+            break;
+        case 2:
+            AV_DICT_SET(opts, "thread_type", "slice", AV_DICT_DONT_OVERWRITE);
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+
 /* video */
 int
 tvh_codec_profile_video_init(TVHCodecProfile *_self, htsmsg_t *conf)
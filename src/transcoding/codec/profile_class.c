@@ -83,7 +83,7 @@ tvh_codec_profile_base_open(TVHCodecProfile *self, AVDictionary **opts)
     if (self->profile != FF_PROFILE_UNKNOWN) {
         AV_DICT_SET_INT(opts, "profile", self->profile, 0);
     }
-    return 0;
+    return tvh_codec_profile_open_threads(self, opts);
 }
 
 
@@ -183,6 +183,20 @@ codec_profile_class_profile_list(void *obj, const char *lang)
 }
 
 
+/* codec_profile_class.thread_type */
+
+static htsmsg_t *
+codec_profile_class_thread_type_list(void *obj, const char *lang)
+{
+    static const struct strtab tab[] = {
+        { N_("Auto"),  0 },
+        { N_("Frame"), 1 },
+        { N_("Slice"), 2 },
+    };
+    return strtab2htsmsg(tab, 1, lang);
+}
+
+
 /* codec_profile_class */
 CLASS_DOC(codec_profile)
 const codec_profile_class_t codec_profile_class = {
@@ -283,6 +297,32 @@ const codec_profile_class_t codec_profile_class = {
                 .list     = codec_profile_class_profile_list,
                 .def.i    = FF_PROFILE_UNKNOWN,
             },
+            {
+                .type     = PT_INT,
+                .id       = "threads",
+                .name     = N_("Threads"),
+                .desc     = N_("Number of codec threads (0 = auto). "
+                               "The decoder and the encoder use this "
+                               "value each."),
+                .group    = 4,
+                .opts     = PO_ADVANCED,
+                .off      = offsetof(TVHCodecProfile, threads),
+                .intextra = INTEXTRA_RANGE(0, 64, 1),
+                .def.i    = 0,
+            },
+            {
+                .type     = PT_INT,
+                .id       = "thread_type",
+                .name     = N_("Threading"),
+                .desc     = N_("Codec threading method. Frame threading "
+                               "scales better but adds one frame of delay "
+                               "per thread."),
+                .group    = 4,
+                .opts     = PO_ADVANCED,
+                .off      = offsetof(TVHCodecProfile, thread_type),
+                .list     = codec_profile_class_thread_type_list,
+                .def.i    = 0,
+            },
             {}
         }
     },
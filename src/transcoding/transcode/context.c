@@ -208,7 +208,14 @@ tvh_context_setup(TVHContext *self, AVCodec *iavcodec, AVCodec *oavcodec)
                        media_type_name ? media_type_name : "<unknown>");
         return -1;
     }
-    if (!(self->iavctx = tvh_context_alloc_avctx(self, iavcodec)) ||
+    if (self->parent) {
+        self->iavctx = self->parent->iavctx;
+    }
+    else {
+        self->iavctx = tvh_context_alloc_avctx(self, iavcodec);
+    }
+    self->output_type = codec_id2streaming_component_type(oavcodec->id);
+    if (!self->iavctx ||
         !(self->oavctx = tvh_context_alloc_avctx(self, oavcodec)) ||
         !(self->iavframe = av_frame_alloc()) ||
         !(self->oavframe = av_frame_alloc())) {
@@ -234,6 +241,7 @@ tvh_context_open(TVHContext *self, TVHOpenPhase phase)
         case OPEN_DECODER:
             avctx = self->iavctx;
             helper = tvh_decoder_helper_find(avctx->codec);
+            ret = tvh_codec_profile_open_threads(self->profile, &opts);
             break;
         case OPEN_ENCODER:
             avctx = self->oavctx;
@@ -273,7 +281,7 @@ tvh_context_pack(TVHContext *self, AVPacket *avpkt)
     if (self->helper && self->helper->pack) {
         pkt = self->helper->pack(self, avpkt);
     } else {
-        pkt = pkt_alloc(self->stream->type, avpkt->data, avpkt->size, avpkt->pts, avpkt->dts, 0);
+        pkt = pkt_alloc(self->output_type, avpkt->data, avpkt->size, avpkt->pts, avpkt->dts, 0);
     }
     if (!pkt) {
         tvh_context_log(self, LOG_ERR, "failed to create packet");
@@ -390,13 +398,30 @@ tvh_context_encode(TVHContext *self, AVFrame *avframe)
 
 // decoding
 
+static int
+tvh_context_encode_branches(TVHContext *self, AVFrame *avframe)
+{
+    TVHContext *branch = NULL;
+    int ret = 0;
+
+    // the filter source keeps its own reference, the frame stays valid
+    SLIST_FOREACH(branch, &self->branches, branch_link) {
+        if ((ret = tvh_context_encode(branch, avframe))) {
+            break;
+        }
+    }
+    return ret;
+}
+
+
 static int
 tvh_context_receive_frame(TVHContext *self, AVFrame *avframe)
 {
     int ret = -1;
 
     while ((ret = avcodec_receive_frame(self->iavctx, avframe)) != AVERROR(EAGAIN)) {
-        if (ret || (ret = tvh_context_encode(self, avframe))) {
+        if (ret || (ret = tvh_context_encode_branches(self, avframe)) ||
+            (ret = tvh_context_encode(self, avframe))) {
             break;
         }
     }
@@ -439,7 +464,14 @@ tvh_context_decode(TVHContext *self, AVPacket *avpkt)
 static void
 tvh_context_flush(TVHContext *self)
 {
+    TVHContext *branch = NULL;
+
     tvh_context_decode_packet(self, NULL);
+    SLIST_FOREACH(branch, &self->branches, branch_link) {
+        if (avcodec_is_open(branch->oavctx)) {
+            tvh_context_encode_frame(branch, NULL);
+        }
+    }
     tvh_context_encode_frame(self, NULL);
 }
 
@@ -477,9 +509,14 @@ tvh_context_get_str_opt(AVDictionary **opts, const char *key, char **value)
 void
 tvh_context_close(TVHContext *self, int flush)
 {
+    TVHContext *branch = NULL;
+
     if (flush) {
         tvh_context_flush(self);
     }
+    SLIST_FOREACH(branch, &self->branches, branch_link) {
+        tvh_context_close(branch, 0);
+    }
     if (self->type->close) {
         self->type->close(self);
     }
@@ -636,6 +673,10 @@ finish:
 int
 tvh_context_deliver(TVHContext *self, th_pkt_t *pkt)
 {
+    if (self->parent) {
+        pkt->pkt_componentindex = self->index;
+        return tvh_transcoder_deliver(self->stream->transcoder, pkt);
+    }
     return tvh_stream_deliver(self->stream, pkt);
 }
 
@@ -647,6 +688,7 @@ tvh_context_handle(TVHContext *self, th_pkt_t *pkt)
     uint8_t *data = NULL;
     size_t size = 0;
     AVPacket avpkt;
+    TVHContext *branch = NULL;
 
     if ((size = pktbuf_len(pkt->pkt_payload)) && pktbuf_ptr(pkt->pkt_payload)) {
         if (size >= TVH_INPUT_BUFFER_MAX_SIZE) {
@@ -673,6 +715,9 @@ tvh_context_handle(TVHContext *self, th_pkt_t *pkt)
                 avpkt.dts = pkt->pkt_dts;
                 avpkt.duration = pkt->pkt_duration;
                 TVHPKT_SET(self->src_pkt, pkt);
+                SLIST_FOREACH(branch, &self->branches, branch_link) {
+                    TVHPKT_SET(branch->src_pkt, pkt);
+                }
                 ret = tvh_context_decode(self, &avpkt);
                 av_packet_unref(&avpkt); // will free data
             }
@@ -694,6 +739,7 @@ tvh_context_create(TVHStream *stream, TVHCodecProfile *profile,
     }
     self->stream = stream;
     self->profile = profile;
+    SLIST_INIT(&self->branches);
     if (tvh_context_setup(self, iavcodec, oavcodec)) {
         tvh_context_destroy(self);
         return NULL;
@@ -706,11 +752,41 @@ tvh_context_create(TVHStream *stream, TVHCodecProfile *profile,
 }
 
 
+TVHContext *
+tvh_context_create_branch(TVHContext *parent, TVHCodecProfile *profile,
+                          AVCodec *oavcodec, int index)
+{
+    TVHContext *self = NULL;
+
+    if (!(self = calloc(1, sizeof(TVHContext)))) {
+        tvh_context_log(parent, LOG_ERR, "failed to allocate branch context");
+        return NULL;
+    }
+    self->stream = parent->stream;
+    self->profile = profile;
+    self->parent = parent;
+    self->index = index;
+    SLIST_INIT(&self->branches);
+    if (tvh_context_setup(self, (AVCodec *)parent->iavctx->codec, oavcodec)) {
+        tvh_context_destroy(self);
+        return NULL;
+    }
+    SLIST_INSERT_HEAD(&parent->branches, self, branch_link);
+    return self;
+}
+
+
 void
 tvh_context_destroy(TVHContext *self)
 {
+    TVHContext *branch = NULL;
+
     if (self) {
         tvh_context_close(self, 0);
+        while ((branch = SLIST_FIRST(&self->branches))) {
+            SLIST_REMOVE_HEAD(&self->branches, branch_link);
+            tvh_context_destroy(branch);
+        }
         TVHPKT_CLEAR(self->src_pkt);
         if (self->avfltgraph) {
             avfilter_graph_free(&self->avfltgraph); // frees filter contexts
@@ -737,10 +813,11 @@ tvh_context_destroy(TVHContext *self)
             avcodec_free_context(&self->oavctx); // frees extradata
             self->oavctx = NULL;
         }
-        if (self->iavctx) {
+        if (self->iavctx && !self->parent) {
             avcodec_free_context(&self->iavctx);
-            self->iavctx = NULL;
         }
+        self->iavctx = NULL;
+        self->parent = NULL;
         self->type = NULL;
         self->profile = NULL;
         self->stream = NULL;
@@ -381,14 +381,14 @@ tvh_aac_pack(TVHContext *self, AVPacket *avpkt)
         tvh_context_log(self, LOG_ERR, "aac frame data too big");
     }
     else if (avpkt->data[0] != 0xff || (avpkt->data[1] & 0xf0) != 0xf0) {
-        if ((pkt = pkt_alloc(self->stream->type, NULL, pkt_size, avpkt->pts, avpkt->dts, 0))) {
+        if ((pkt = pkt_alloc(self->output_type, NULL, pkt_size, avpkt->pts, avpkt->dts, 0))) {
             tvh_aac_pack_adts_header(self, pkt->pkt_payload);
             memcpy(pktbuf_ptr(pkt->pkt_payload) + header_size,
                    avpkt->data, avpkt->size);
         }
     }
     else {
-        pkt = pkt_alloc(self->stream->type, avpkt->data, avpkt->size, avpkt->pts, avpkt->dts, 0);
+        pkt = pkt_alloc(self->output_type, avpkt->data, avpkt->size, avpkt->pts, avpkt->dts, 0);
     }
     return pkt;
 }
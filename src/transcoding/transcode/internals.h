@@ -38,6 +38,8 @@
 #define tvh_ss_t streaming_start_t
 #define tvh_sm_t streaming_message_t
 
+#define TVH_STREAM_QUEUE_MAX 128
+
 
 extern TVHCodecProfile *tvh_codec_profile_copy;
 
@@ -66,6 +68,7 @@ struct tvh_transcoder {
     struct TVHStreams streams;
     uint32_t id;
     tvh_st_t *output;
+    tvh_mutex_t output_mutex; // serializes the stream workers
     TVHCodecProfile *profiles[AVMEDIA_TYPE_NB];
     char *src_codecs[AVMEDIA_TYPE_NB];
 };
@@ -84,6 +87,14 @@ tvh_transcoder_destroy(TVHTranscoder *self);
 
 /* TVHStream ================================================================ */
 
+typedef struct tvh_stream_pkt {
+    th_pkt_t *pkt;
+    int64_t queued;
+    TAILQ_ENTRY(tvh_stream_pkt) link;
+} TVHStreamPkt;
+
+TAILQ_HEAD(TVHStreamPkts, tvh_stream_pkt);
+
 struct tvh_stream {
     TVHTranscoder *transcoder;
     int id;
@@ -92,6 +103,19 @@ struct tvh_stream {
     TVHContext *context;
     int is_copy;
     SLIST_ENTRY(tvh_stream) link;
+    // worker
+    pthread_t thread;
+    int running;
+    int stopping;
+    int failed;
+    tvh_mutex_t queue_mutex;
+    tvh_cond_t queue_cond;
+    struct TVHStreamPkts queue;
+    int queue_len;
+    int queue_max;
+    uint64_t handled;
+    int64_t latency_sum;
+    int64_t latency_max;
 };
 
 void
@@ -103,10 +127,17 @@ tvh_stream_handle(TVHStream *self, th_pkt_t *pkt);
 int
 tvh_stream_deliver(TVHStream *self, th_pkt_t *pkt);
 
+void
+tvh_stream_info(TVHStream *self, htsmsg_t *list);
+
 TVHStream *
 tvh_stream_create(TVHTranscoder *transcoder, TVHCodecProfile *profile,
                   tvh_ssc_t *ssc, const char *src_codecs);
 
+int
+tvh_stream_add_renditions(TVHStream *self, TVHCodecProfile *ladder,
+                          tvh_ssc_t *ssc, int index);
+
 void
 tvh_stream_destroy(TVHStream *self);
 
@@ -140,10 +171,18 @@ tvh_context_types_forget(void);
 
 /* TVHContext =============================================================== */
 
+SLIST_HEAD(TVHContexts, tvh_context);
+
 struct tvh_context {
     TVHStream *stream;
     TVHCodecProfile *profile;
     TVHContextType *type;
+    tvh_sct_t output_type;
+    // ladder: branches encode the frames decoded by the parent
+    TVHContext *parent;
+    int index;
+    struct TVHContexts branches;
+    SLIST_ENTRY(tvh_context) branch_link;
     AVCodecContext *iavctx;
     AVCodecContext *oavctx;
     AVFrame *iavframe;
@@ -193,6 +232,10 @@ TVHContext *
 tvh_context_create(TVHStream *stream, TVHCodecProfile *profile,
                    AVCodec *iavcodec, AVCodec *oavcodec, pktbuf_t *input_gh);
 
+TVHContext *
+tvh_context_create_branch(TVHContext *parent, TVHCodecProfile *profile,
+                          AVCodec *oavcodec, int index);
+
 void
 tvh_context_destroy(TVHContext *self);
 
@@ -63,6 +63,13 @@ tvh_stream_setup(TVHStream *self, TVHCodecProfile *profile, tvh_ssc_t *ssc)
                        streaming_component_type2txt(ssc->es_type));
         return -1;
     }
+    // a ladder decodes for its first rendition, the others are branches
+    if (tvh_codec_profile_is_ladder(profile) &&
+        !tvh_codec_profile_ladder_get_renditions(profile, &profile, 1)) {
+        tvh_stream_log(self, LOG_ERR, "ladder '%s' has no usable rendition",
+                       tvh_codec_profile_get_name(profile));
+        return -1;
+    }
 #if ENABLE_MMAL
     if (idnode_is_instance(&profile->idnode,
                            (idclass_t *)&codec_profile_video_class)) {
@@ -116,12 +123,143 @@ tvh_stream_setup(TVHStream *self, TVHCodecProfile *profile, tvh_ssc_t *ssc)
 }
 
 
+/* worker */
+
+static void
+tvh_stream_queue_flush(TVHStream *self)
+{
+    TVHStreamPkt *qp;
+
+    while ((qp = TAILQ_FIRST(&self->queue))) {
+        TAILQ_REMOVE(&self->queue, qp, link);
+        pkt_ref_dec(qp->pkt);
+        free(qp);
+    }
+    self->queue_len = 0;
+}
+
+
+static void *
+tvh_stream_thread(void *aux)
+{
+    TVHStream *self = aux;
+    TVHStreamPkt *qp;
+    int64_t latency;
+    int ret;
+
+    tvh_mutex_lock(&self->queue_mutex);
+    while (1) {
+        if (!(qp = TAILQ_FIRST(&self->queue))) {
+            if (self->stopping) {
+                break;
+            }
+            tvh_cond_wait(&self->queue_cond, &self->queue_mutex);
+            continue;
+        }
+        TAILQ_REMOVE(&self->queue, qp, link);
+        self->queue_len--;
+        tvh_cond_signal(&self->queue_cond, 1);
+        tvh_mutex_unlock(&self->queue_mutex);
+
+        ret = tvh_context_handle(self->context, qp->pkt);
+        latency = getmonoclock() - qp->queued;
+        pkt_ref_dec(qp->pkt);
+        free(qp);
+
+        tvh_mutex_lock(&self->queue_mutex);
+        self->handled++;
+        self->latency_sum += latency;
+        if (latency > self->latency_max) {
+            self->latency_max = latency;
+        }
+        if (ret < 0) {
+            self->failed = 1;
+            tvh_stream_queue_flush(self);
+            tvh_cond_signal(&self->queue_cond, 1);
+            break;
+        }
+    }
+    tvh_mutex_unlock(&self->queue_mutex);
+    return NULL;
+}
+
+
+static int
+tvh_stream_start(TVHStream *self)
+{
+    self->running = 1;
+    if (tvh_thread_create(&self->thread, NULL, tvh_stream_thread, self,
+                          "transcode")) {
+        tvh_stream_log(self, LOG_ERR, "failed to create worker thread");
+        self->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+
+static void
+tvh_stream_join(TVHStream *self, int flush)
+{
+    if (self->running) {
+        tvh_mutex_lock(&self->queue_mutex);
+        if (!flush) {
+            tvh_stream_queue_flush(self);
+        }
+        self->stopping = 1;
+        tvh_cond_signal(&self->queue_cond, 1);
+        tvh_mutex_unlock(&self->queue_mutex);
+        pthread_join(self->thread, NULL);
+        self->running = 0;
+        if (self->handled) {
+            tvh_stream_log(self, LOG_DEBUG,
+                           "worker: %"PRIu64" packets, queue max %d, "
+                           "latency avg %"PRId64" max %"PRId64" us",
+                           self->handled, self->queue_max,
+                           self->latency_sum / (int64_t)self->handled,
+                           self->latency_max);
+        }
+    }
+}
+
+
+static int
+tvh_stream_enqueue(TVHStream *self, th_pkt_t *pkt)
+{
+    TVHStreamPkt *qp;
+
+    if (!(qp = malloc(sizeof(*qp)))) {
+        return -1;
+    }
+    tvh_mutex_lock(&self->queue_mutex);
+    while (self->queue_len >= TVH_STREAM_QUEUE_MAX && !self->failed) {
+        tvh_cond_wait(&self->queue_cond, &self->queue_mutex);
+    }
+    if (self->failed) {
+        tvh_mutex_unlock(&self->queue_mutex);
+        free(qp);
+        return -1;
+    }
+    pkt_ref_inc(pkt);
+    qp->pkt = pkt;
+    qp->queued = getmonoclock();
+    TAILQ_INSERT_TAIL(&self->queue, qp, link);
+    if (++self->queue_len > self->queue_max) {
+        self->queue_max = self->queue_len;
+    }
+    tvh_cond_signal(&self->queue_cond, 1);
+    tvh_mutex_unlock(&self->queue_mutex);
+    return 0;
+}
+
+
 /* exposed */
 
 void
 tvh_stream_stop(TVHStream *self, int flush)
 {
     if (self->index >= 0) {
+        tvh_stream_join(self, flush);
         if (self->context) {
             tvh_context_close(self->context, flush);
         }
@@ -134,6 +272,9 @@ int
 tvh_stream_handle(TVHStream *self, th_pkt_t *pkt)
 {
     if (pkt->pkt_payload && self->context) {
+        if (self->running) {
+            return tvh_stream_enqueue(self, pkt);
+        }
         return (tvh_context_handle(self->context, pkt) < 0) ? -1 : 0;
     }
     pkt_ref_inc(pkt);
@@ -149,6 +290,27 @@ tvh_stream_deliver(TVHStream *self, th_pkt_t *pkt)
 }
 
 
+void
+tvh_stream_info(TVHStream *self, htsmsg_t *list)
+{
+    char buf[128];
+    int64_t avg;
+
+    if (!self->running) {
+        return;
+    }
+    tvh_mutex_lock(&self->queue_mutex);
+    avg = self->handled ? self->latency_sum / (int64_t)self->handled : 0;
+    snprintf(buf, sizeof(buf),
+             "transcoder stream %02d:%s queue %d/%d (max %d) latency avg %"PRId64" max %"PRId64" us",
+             self->id, streaming_component_type2txt(self->type),
+             self->queue_len, TVH_STREAM_QUEUE_MAX, self->queue_max,
+             avg, self->latency_max);
+    tvh_mutex_unlock(&self->queue_mutex);
+    htsmsg_add_str(list, NULL, buf);
+}
+
+
 TVHStream *
 tvh_stream_create(TVHTranscoder *transcoder, TVHCodecProfile *profile,
                   tvh_ssc_t *ssc, const char *src_codecs)
@@ -163,13 +325,17 @@ tvh_stream_create(TVHTranscoder *transcoder, TVHCodecProfile *profile,
     self->transcoder = transcoder;
     self->id = self->index = ssc->es_index;
     self->type = ssc->es_type;
+    tvh_mutex_init(&self->queue_mutex, NULL);
+    tvh_cond_init(&self->queue_cond, 1);
+    TAILQ_INIT(&self->queue);
     if ((is_copy = tvh_stream_is_copy(profile, ssc, src_codecs)) > 0) {
         self->is_copy = 1;
         if (ssc->ssc_gh) {
             pktbuf_ref_inc(ssc->ssc_gh);
         }
     }
-    else if (is_copy < 0 || tvh_stream_setup(self, profile, ssc)) {
+    else if (is_copy < 0 || tvh_stream_setup(self, profile, ssc) ||
+             tvh_stream_start(self)) {
         tvh_stream_destroy(self);
         return NULL;
     }
@@ -177,6 +343,45 @@ tvh_stream_create(TVHTranscoder *transcoder, TVHCodecProfile *profile,
 }
 
 
+int
+tvh_stream_add_renditions(TVHStream *self, TVHCodecProfile *ladder,
+                          tvh_ssc_t *ssc, int index)
+{
+    TVHCodecProfile *renditions[TVH_LADDER_MAX];
+    TVHContext *branch = NULL;
+    AVCodec *ocodec = NULL;
+    tvh_ssc_t *rssc = NULL;
+    int i, count, added = 0;
+
+    if (!self->context || !tvh_codec_profile_is_ladder(ladder)) {
+        return 0;
+    }
+    count = tvh_codec_profile_ladder_get_renditions(ladder, renditions,
+                                                    TVH_LADDER_MAX);
+    ssc->ssc_rendition = 1;
+    for (i = 1; i < count; i++) {
+        if (!(ocodec = tvh_codec_profile_get_avcodec(renditions[i])) ||
+            !(branch = tvh_context_create_branch(self->context, renditions[i],
+                                                 ocodec, index + added))) {
+            tvh_stream_log(self, LOG_ERR, "rendition %d: profile '%s' skipped",
+                           i + 1, tvh_codec_profile_get_name(renditions[i]));
+            continue;
+        }
+        rssc = &ssc[1 + added];
+        *rssc = *ssc;
+        rssc->es_index = index + added;
+        rssc->es_type = branch->output_type;
+        rssc->ssc_rendition = i + 1;
+        rssc->ssc_gh = NULL;
+        tvh_stream_log(self, LOG_INFO, "==> Rendition %d (%02d) using profile %s",
+                       i + 1, rssc->es_index,
+                       tvh_codec_profile_get_name(renditions[i]));
+        added++;
+    }
+    return added;
+}
+
+
 void
 tvh_stream_destroy(TVHStream *self)
 {
@@ -186,6 +391,9 @@ tvh_stream_destroy(TVHStream *self)
             tvh_context_destroy(self->context);
             self->context = NULL;
         }
+        tvh_stream_queue_flush(self);
+        tvh_cond_destroy(&self->queue_cond);
+        tvh_mutex_destroy(&self->queue_mutex);
         self->transcoder = NULL;
         free(self);
         self = NULL;
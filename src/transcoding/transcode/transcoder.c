@@ -115,6 +115,8 @@ tvh_transcoder_start(TVHTranscoder *self, tvh_ss_t *ss_src)
     int audio_index = -1;
     int audio_pindex[3] = { -1, -1, -1 };
     int subtitle_index = -1;
+    int next_index = 0;
+    int renditions = 0, added;
     enum AVMediaType media_type;
 
     aprofile = _audio_profile(self->profiles[AVMEDIA_TYPE_AUDIO]);
@@ -190,7 +192,16 @@ tvh_transcoder_start(TVHTranscoder *self, tvh_ss_t *ss_src)
         indexes[count++] = subtitle_index;
     }
 
-    ss = calloc(1, (sizeof(tvh_ss_t) + (sizeof(tvh_ssc_t) * count)));
+    /* ladder renditions get new component indexes after the source ones */
+    for (i = 0; i < ss_src->ss_num_components; i++) {
+        if (ss_src->ss_components[i].es_index >= next_index)
+            next_index = ss_src->ss_components[i].es_index + 1;
+    }
+    profile = self->profiles[AVMEDIA_TYPE_VIDEO];
+    if (video_index >= 0 && profile && tvh_codec_profile_is_ladder(profile))
+        renditions = TVH_LADDER_MAX - 1;
+
+    ss = calloc(1, (sizeof(tvh_ss_t) + (sizeof(tvh_ssc_t) * (count + renditions))));
     if (ss) {
         ss->ss_refcount = 1;
         ss->ss_pcr_pid = ss_src->ss_pcr_pid;
@@ -217,7 +228,10 @@ tvh_transcoder_start(TVHTranscoder *self, tvh_ss_t *ss_src)
                   tvh_ssc_log(ssc_src, LOG_INFO, "==> Using profile %s", self,
                               tvh_codec_profile_get_name(profile));
                 SLIST_INSERT_HEAD(&self->streams, stream, link);
-                k++;
+                added = tvh_stream_add_renditions(stream, profile, ssc,
+                                                  next_index);
+                next_index += added;
+                k += 1 + added;
             } else {
                 indexes[j] = -1;
                 continue;
@@ -258,6 +272,15 @@ tvh_transcoder_stop(TVHTranscoder *self, int flush)
 }
 
 
+static void
+tvh_transcoder_output(TVHTranscoder *self, tvh_sm_t *msg)
+{
+    tvh_mutex_lock(&self->output_mutex);
+    streaming_target_deliver2(self->output, msg);
+    tvh_mutex_unlock(&self->output_mutex);
+}
+
+
 static void
 tvh_transcoder_stream(void *opaque, tvh_sm_t *msg)
 {
@@ -278,13 +301,13 @@ tvh_transcoder_stream(void *opaque, tvh_sm_t *msg)
                 streaming_start_unref(msg->sm_data);
                 msg->sm_data = ss;
             }
-            streaming_target_deliver2(self->output, msg);
+            tvh_transcoder_output(self, msg);
             break;
         case SMT_STOP:
             tvh_transcoder_stop(self, 1);
             /* !!! FALLTHROUGH !!! */
         default:
-            streaming_target_deliver2(self->output, msg);
+            tvh_transcoder_output(self, msg);
             break;
     }
 }
@@ -318,7 +341,10 @@ tvh_transcoder_info(void *opaque, htsmsg_t *list)
 {
   TVHTranscoder *self = opaque;
   streaming_target_t *st = self->output;
+  TVHStream *stream;
   htsmsg_add_str(list, NULL, "transcoder input");
+  SLIST_FOREACH(stream, &self->streams, link)
+    tvh_stream_info(stream, list);
   return st->st_ops.st_info(st->st_opaque, list);
 }
 
@@ -335,7 +361,7 @@ tvh_transcoder_deliver(TVHTranscoder *self, th_pkt_t *pkt)
         return -1;
     }
     pkt_ref_dec(pkt);
-    streaming_target_deliver2(self->output, msg);
+    tvh_transcoder_output(self, msg);
     return 0;
 }
 
@@ -359,6 +385,7 @@ tvh_transcoder_create(tvh_st_t *output,
         return NULL;
     }
     SLIST_INIT(&self->streams);
+    tvh_mutex_init(&self->output_mutex, NULL);
     self->id = ++id;
     if (!self->id) {
         self->id = ++id;
@@ -389,6 +416,7 @@ tvh_transcoder_destroy(TVHTranscoder *self)
         }
         for (i = 0; i < AVMEDIA_TYPE_NB; i++)
           free(self->src_codecs[i]);
+        tvh_mutex_destroy(&self->output_mutex);
         free(self);
         self = NULL;
     }
@@ -122,6 +122,10 @@ tvh_video_context_open_decoder(TVHContext *self, AVDictionary **opts)
     }
     if (hwaccel) {
         self->iavctx->get_format = hwaccels_decode_get_format;
+        // hardware decoders are not frame threaded
+        if (av_dict_set(opts, "threads", "1", 0) < 0) {
+            return -1;
+        }
     }
     mystrset(&self->hw_accel_device, self->profile->device);
 #endif
@@ -136,15 +140,21 @@ tvh_video_context_notify_gh(TVHContext *self)
     /* notify global headers that we're live */
     /* the video packets might be delayed */
     th_pkt_t *pkt = NULL;
+    TVHContext *branch = NULL;
 
-    pkt = pkt_alloc(self->stream->type, NULL, 0,
+    pkt = pkt_alloc(self->output_type, NULL, 0,
                     self->src_pkt->pkt_pts,
                     self->src_pkt->pkt_dts,
                     self->src_pkt->pkt_pcr);
-    if (pkt) {
-        return tvh_context_deliver(self, pkt);
+    if (!pkt || tvh_context_deliver(self, pkt)) {
+        return -1;
+    }
+    SLIST_FOREACH(branch, &self->branches, branch_link) {
+        if (tvh_video_context_notify_gh(branch)) {
+            return -1;
+        }
     }
-    return -1;
+    return 0;
 }
 
 
@@ -335,7 +345,9 @@ tvh_video_context_close(TVHContext *self)
 {
 #if ENABLE_HWACCELS
     hwaccels_encode_close_context(self->oavctx);
-    hwaccels_decode_close_context(self->iavctx);
+    if (!self->parent) {
+        hwaccels_decode_close_context(self->iavctx);
+    }
 #endif
 }
 
@@ -287,6 +287,11 @@ uint8_t *tvh_gzip_inflate ( const uint8_t *data, size_t size, size_t orig );
 uint8_t *tvh_gzip_deflate ( const uint8_t *data, size_t orig, size_t *size );
 int      tvh_gzip_deflate_fd ( int fd, const uint8_t *data, size_t orig, size_t *size, int speed );
 int      tvh_gzip_deflate_fd_header ( int fd, const uint8_t *data, size_t orig, size_t *size, int speed , const char *signature);
+struct htsbuf_queue;
+typedef struct tvh_gzip_stream tvh_gzip_stream_t;
+tvh_gzip_stream_t *tvh_gzip_stream_create ( int speed );
+int      tvh_gzip_stream_write ( tvh_gzip_stream_t *gz, const uint8_t *data, size_t len, int flush, struct htsbuf_queue *out );
+void     tvh_gzip_stream_destroy ( tvh_gzip_stream_t *gz );
 #endif
 
 /* URL decoding */
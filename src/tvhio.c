@@ -0,0 +1,409 @@
+/*
+ *  TVheadend - file I/O wrapper
+ *
+ *  Copyright (C) 2026 Tvheadend Foundation CIC
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tvheadend.h"
+#include "tvhio.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#if ENABLE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+/*
+ * The requests passed to one tvhio_submit() call are executed in order,
+ * a failed request cancels the rest of the batch. The io_uring backend
+ * links the requests and queues the whole batch with one system call,
+ * the blocking backend executes them one by one.
+ */
+
+struct tvhio
+{
+  uint32_t depth;
+#if ENABLE_IO_URING
+  int fd;
+  uint8_t *sq_ptr;
+  uint8_t *cq_ptr;
+  size_t sq_size;
+  size_t cq_size;
+  struct io_uring_sqe *sqes;
+  size_t sqes_size;
+  uint32_t *sq_tail;
+  uint32_t *sq_mask;
+  uint32_t *sq_array;
+  uint32_t *cq_head;
+  uint32_t *cq_tail;
+  uint32_t *cq_mask;
+  struct io_uring_cqe *cqes;
+#endif
+};
+
+/*
+ * Blocking backend
+ */
+
+static ssize_t
+tvhio_blocking ( tvhio_req_t *r )
+{
+  uint8_t *p = r->buf;
+  size_t len = r->len;
+  off_t off = r->off;
+  ssize_t c;
+
+  switch (r->op) {
+  case TVHIO_WRITE:
+    while (len > 0) {
+      c = pwrite(r->fd, p, len, off);
+      if (c < 0) {
+        if (errno == EINTR)
+          continue;
+        return -errno;
+      }
+      if (c == 0)
+        return -EIO;
+      p += c;
+      off += c;
+      len -= c;
+    }
+    return r->len;
+  case TVHIO_READ:
+    do {
+      c = pread(r->fd, p, len, off);
+    } while (c < 0 && errno == EINTR);
+    return c < 0 ? -errno : c;
+  case TVHIO_FDATASYNC:
+    return fdatasync(r->fd) ? -errno : 0;
+  case TVHIO_DONTNEED:
+#if defined(PLATFORM_DARWIN)
+    fcntl(r->fd, F_NOCACHE, 1);
+#elif !ENABLE_ANDROID
+    posix_fadvise(r->fd, r->off, r->len, POSIX_FADV_DONTNEED);
+#endif
+    return 0;
+  case TVHIO_WILLNEED:
+#if !defined(PLATFORM_DARWIN) && !ENABLE_ANDROID
+    posix_fadvise(r->fd, r->off, r->len, POSIX_FADV_WILLNEED);
+#endif
+    return 0;
+  }
+  return -EINVAL;
+}
+
+/*
+ * io_uring backend
+ */
+
+#if ENABLE_IO_URING
+
+static void
+tvhio_uring_close ( tvhio_t *io )
+{
+  if (io->sqes)
+    munmap(io->sqes, io->sqes_size);
+  if (io->cq_ptr && io->cq_ptr != io->sq_ptr)
+    munmap(io->cq_ptr, io->cq_size);
+  if (io->sq_ptr)
+    munmap(io->sq_ptr, io->sq_size);
+  io->sqes = NULL;
+  io->cq_ptr = io->sq_ptr = NULL;
+  if (io->fd >= 0)
+    close(io->fd);
+  io->fd = -1;
+}
+
+/*
+ * The write/read/fadvise opcodes came with kernel 5.6, older rings
+ * fail them with -EINVAL (and they do not know the probe either)
+ */
+static int
+tvhio_uring_probe ( tvhio_t *io )
+{
+  static const uint8_t ops[] = {
+    IORING_OP_WRITE, IORING_OP_READ, IORING_OP_FSYNC, IORING_OP_FADVISE
+  };
+  struct io_uring_probe *p;
+  size_t i, nops = 256;
+  int r = 0;
+
+  p = calloc(1, sizeof(*p) + nops * sizeof(struct io_uring_probe_op));
+  if (syscall(__NR_io_uring_register, io->fd, IORING_REGISTER_PROBE,
+              p, nops) < 0) {
+    r = -errno;
+  } else {
+    for (i = 0; i < ARRAY_SIZE(ops); i++)
+      if (ops[i] >= p->ops_len ||
+          (p->ops[ops[i]].flags & IO_URING_OP_SUPPORTED) == 0) {
+        r = -EOPNOTSUPP;
+        break;
+      }
+  }
+  free(p);
+  return r;
+}
+
+static int
+tvhio_uring_open ( tvhio_t *io )
+{
+  struct io_uring_params p;
+  int r;
+
+  memset(&p, 0, sizeof(p));
+  io->fd = syscall(__NR_io_uring_setup, io->depth, &p);
+  if (io->fd < 0)
+    return -errno;
+  io->depth = MIN(p.sq_entries, p.cq_entries);
+  io->sq_size = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+  io->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+    io->sq_size = io->cq_size = MAX(io->sq_size, io->cq_size);
+  io->sq_ptr = mmap(NULL, io->sq_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, io->fd, IORING_OFF_SQ_RING);
+  if (io->sq_ptr == MAP_FAILED)
+    goto fail;
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    io->cq_ptr = io->sq_ptr;
+  } else {
+    io->cq_ptr = mmap(NULL, io->cq_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, io->fd, IORING_OFF_CQ_RING);
+    if (io->cq_ptr == MAP_FAILED)
+      goto fail;
+  }
+  io->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  io->sqes = mmap(NULL, io->sqes_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, io->fd, IORING_OFF_SQES);
+  if (io->sqes == MAP_FAILED)
+    goto fail;
+  io->sq_tail  = (uint32_t *)(io->sq_ptr + p.sq_off.tail);
+  io->sq_mask  = (uint32_t *)(io->sq_ptr + p.sq_off.ring_mask);
+  io->sq_array = (uint32_t *)(io->sq_ptr + p.sq_off.array);
+  io->cq_head  = (uint32_t *)(io->cq_ptr + p.cq_off.head);
+  io->cq_tail  = (uint32_t *)(io->cq_ptr + p.cq_off.tail);
+  io->cq_mask  = (uint32_t *)(io->cq_ptr + p.cq_off.ring_mask);
+  io->cqes     = (struct io_uring_cqe *)(io->cq_ptr + p.cq_off.cqes);
+  if ((r = tvhio_uring_probe(io)) < 0) {
+    tvhio_uring_close(io);
+    return r;
+  }
+  return 0;
+
+fail:
+  if (io->sq_ptr == MAP_FAILED) io->sq_ptr = NULL;
+  if (io->cq_ptr == MAP_FAILED) io->cq_ptr = NULL;
+  if (io->sqes == MAP_FAILED) io->sqes = NULL;
+  tvhio_uring_close(io);
+  return -ENOMEM;
+}
+
+static void
+tvhio_uring_prep ( tvhio_t *io, tvhio_req_t *r, uint64_t id, int link )
+{
+  uint32_t tail = *io->sq_tail, idx = tail & *io->sq_mask;
+  struct io_uring_sqe *sqe = &io->sqes[idx];
+
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->fd = r->fd;
+  sqe->off = r->off;
+  sqe->user_data = id;
+  switch (r->op) {
+  case TVHIO_WRITE:
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->addr = (uintptr_t)r->buf;
+    sqe->len = r->len;
+    break;
+  case TVHIO_READ:
+    sqe->opcode = IORING_OP_READ;
+    sqe->addr = (uintptr_t)r->buf;
+    sqe->len = r->len;
+    break;
+  case TVHIO_FDATASYNC:
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->off = 0;
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    break;
+  case TVHIO_DONTNEED:
+  case TVHIO_WILLNEED:
+    sqe->opcode = IORING_OP_FADVISE;
+    sqe->len = MIN(r->len, UINT32_MAX);
+    sqe->fadvise_advice = r->op == TVHIO_DONTNEED ?
+                            POSIX_FADV_DONTNEED : POSIX_FADV_WILLNEED;
+    break;
+  }
+  if (link)
+    sqe->flags |= IOSQE_IO_LINK;
+  io->sq_array[idx] = idx;
+  __atomic_store_n(io->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static size_t
+tvhio_uring_reap ( tvhio_t *io, tvhio_req_t *reqs, size_t num )
+{
+  struct io_uring_cqe *cqe;
+  uint32_t head, tail;
+  size_t completed = 0;
+
+  head = *io->cq_head;
+  tail = __atomic_load_n(io->cq_tail, __ATOMIC_ACQUIRE);
+  for ( ; head != tail; head++, completed++) {
+    cqe = &io->cqes[head & *io->cq_mask];
+    if (cqe->user_data < num)
+      reqs[cqe->user_data].res = cqe->res;
+  }
+  __atomic_store_n(io->cq_head, head, __ATOMIC_RELEASE);
+  return completed;
+}
+
+static int
+tvhio_uring_submit ( tvhio_t *io, tvhio_req_t *reqs, size_t num )
+{
+  size_t i, submitted = 0, completed = 0;
+  int r, err;
+
+  for (i = 0; i < num; i++) {
+    reqs[i].res = -ECANCELED;
+    tvhio_uring_prep(io, &reqs[i], i, i + 1 < num);
+  }
+  while (completed < num) {
+    r = syscall(__NR_io_uring_enter, io->fd, num - submitted, 1,
+                IORING_ENTER_GETEVENTS, NULL, 0);
+    if (r < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+        continue;
+      goto fail;
+    }
+    submitted += r;
+    completed += tvhio_uring_reap(io, reqs, num);
+  }
+  return 0;
+
+fail:
+  /* the kernel still owns the buffers of the queued requests */
+  err = -errno;
+  while (completed < submitted) {
+    r = syscall(__NR_io_uring_enter, io->fd, 0, 1,
+                IORING_ENTER_GETEVENTS, NULL, 0);
+    if (r < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+      break;
+    completed += tvhio_uring_reap(io, reqs, num);
+  }
+  return err;
+}
+
+#endif
+
+/*
+ * Public API
+ */
+
+tvhio_t *
+tvhio_create ( uint32_t depth )
+{
+  tvhio_t *io = calloc(1, sizeof(*io));
+  io->depth = MAX(depth, 1);
+#if ENABLE_IO_URING
+  int r = tvhio_uring_open(io);
+  if (r < 0)
+    tvhdebug(LS_MAIN, "io_uring not available (%s), using blocking file I/O",
+             strerror(-r));
+#endif
+  return io;
+}
+
+void
+tvhio_destroy ( tvhio_t *io )
+{
+  if (io == NULL)
+    return;
+#if ENABLE_IO_URING
+  tvhio_uring_close(io);
+#endif
+  free(io);
+}
+
+const char *
+tvhio_backend ( tvhio_t *io )
+{
+#if ENABLE_IO_URING
+  if (io->fd >= 0)
+    return "io_uring";
+#endif
+  return "blocking";
+}
+
+/*
+ * Execute the requests in order, returns the first error (-errno),
+ * io might be NULL for the blocking calls
+ */
+int
+tvhio_submit ( tvhio_t *io, tvhio_req_t *reqs, size_t num )
+{
+  tvhio_req_t *r;
+  size_t i, n;
+  ssize_t res;
+#if ENABLE_IO_URING
+  int err;
+#endif
+
+  while (num > 0) {
+    n = io ? MIN(num, io->depth) : num;
+#if ENABLE_IO_URING
+    if (io && io->fd >= 0 && (err = tvhio_uring_submit(io, reqs, n)) < 0) {
+      tvherror(LS_MAIN, "io_uring submit failed (%s), using blocking file I/O",
+               strerror(-err));
+      tvhio_uring_close(io);
+    }
+#endif
+    for (i = 0, r = reqs; i < n; i++, r++) {
+#if ENABLE_IO_URING
+      if (io && io->fd >= 0) {
+        res = r->res;
+        /* short write (breaks the link), or an opcode the ring refused */
+        if ((r->op == TVHIO_WRITE && res >= 0 && (size_t)res < r->len) ||
+            res == -ECANCELED || res == -EINVAL)
+          res = r->res = tvhio_blocking(r);
+      } else
+#endif
+      res = r->res = tvhio_blocking(r);
+      if (res < 0) {
+        for (i++, r++; i < num; i++, r++)
+          r->res = -ECANCELED;
+        return res;
+      }
+    }
+    reqs += n;
+    num -= n;
+  }
+  return 0;
+}
+
+/*
+ * Hint the kernel to read the file range in the background
+ */
+void
+tvhio_readahead ( int fd, off_t off, size_t len )
+{
+  tvhio_req_t r;
+
+  tvhio_blocking(tvhio_req(&r, TVHIO_WILLNEED, fd, NULL, len, off));
+}
@@ -0,0 +1,59 @@
+/*
+ *  TVheadend - file I/O wrapper
+ *
+ *  Copyright (C) 2026 Tvheadend Foundation CIC
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TVHIO_H__
+#define __TVHIO_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef struct tvhio tvhio_t;
+
+typedef enum {
+  TVHIO_WRITE,
+  TVHIO_READ,
+  TVHIO_FDATASYNC,
+  TVHIO_DONTNEED,
+  TVHIO_WILLNEED,
+} tvhio_op_t;
+
+typedef struct tvhio_req {
+  tvhio_op_t  op;
+  int         fd;
+  void       *buf;
+  size_t      len;
+  off_t       off;
+  ssize_t     res;      /* output: bytes transferred or -errno */
+} tvhio_req_t;
+
+static inline
+tvhio_req_t *tvhio_req
+  (tvhio_req_t *r, tvhio_op_t op, int fd, void *buf, size_t len, off_t off)
+{
+  r->op = op; r->fd = fd; r->buf = buf; r->len = len; r->off = off; r->res = 0;
+  return r;
+}
+
+tvhio_t *tvhio_create(uint32_t depth);
+void tvhio_destroy(tvhio_t *io);
+const char *tvhio_backend(tvhio_t *io);
+int tvhio_submit(tvhio_t *io, tvhio_req_t *reqs, size_t num);
+void tvhio_readahead(int fd, off_t off, size_t len);
+
+#endif /* __TVHIO_H__ */
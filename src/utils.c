@@ -658,7 +658,9 @@ makedirs ( int subsys, const char *inpath, int mode,
       path[x] = 0;
       if (stat(path, &st)) {
         err = mkdir(path, mode);
-        if (!err && gid != -1 && uid != -1)
+        if (err && errno == EEXIST && !stat(path, &st) && S_ISDIR(st.st_mode))
+          err = 0; /* created by another thread */
+        else if (!err && gid != -1 && uid != -1)
           err = chown(path, uid, gid);
         if (!err && !stat(path, &st) &&
             FILE_MODE_BITS(mode) != FILE_MODE_BITS(st.st_mode)) {
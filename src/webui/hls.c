@@ -0,0 +1,868 @@
+/*
+ *  tvheadend, HTTP Live Streaming output
+ *  Copyright (C) 2026 Tvheadend Foundation CIC
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "tvheadend.h"
+#include "config.h"
+#include "http.h"
+#include "webui.h"
+#include "channels.h"
+#include "profile.h"
+#include "streaming.h"
+#include "subscriptions.h"
+#include "access.h"
+#include "memoryinfo.h"
+#include "uuid.h"
+
+#if defined(PLATFORM_LINUX)
+#include <sys/sendfile.h>
+#elif defined(PLATFORM_FREEBSD)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+/*
+ * One segmenter (subscription + pass-thru muxer) per channel and
+ * profile. The muxer writes into an in-memory file, which is swapped
+ * under the muxer at every segment boundary. Completed segments are
+ * immutable and sent to any number of clients using sendfile().
+ */
+
+#define HLS_PTS_MASK 0x1ffffffffLL
+
+typedef struct hls_segment {
+  TAILQ_ENTRY(hls_segment) hs_link;
+  int64_t hs_seq;
+  int64_t hs_duration;          /* 90kHz */
+  int64_t hs_size;
+  int     hs_fd;
+} hls_segment_t;
+
+typedef struct hls_session {
+  LIST_ENTRY(hls_session) hss_link;
+  int                hss_refcount;
+  int                hss_done;
+  int                hss_run;
+  char               hss_key[33];
+  char              *hss_channel;
+  profile_chain_t    hss_prch;
+  th_subscription_t *hss_sub;
+  pthread_t          hss_tid;
+  int64_t            hss_access;
+  int                hss_duration;
+  int                hss_segments;
+  int                hss_idle;
+  int                hss_target;
+  TAILQ_HEAD(, hls_segment) hss_queue;
+  int                hss_count;
+  int64_t            hss_seq;
+
+  /* segmenter thread only */
+  int                hss_fd;
+  int                hss_open;
+  uint16_t           hss_pmt_pid;
+  uint16_t           hss_vpid;
+  uint16_t           hss_apid;
+  int                hss_vtype;
+  int64_t            hss_pts_start;
+  int64_t            hss_pts_first;
+  int64_t            hss_seg_duration;
+} hls_session_t;
+
+static LIST_HEAD(, hls_session) hls_sessions;
+static tvh_mutex_t hls_lock;
+static tvh_cond_t hls_cond;
+static mtimer_t hls_timer;
+
+static memoryinfo_t hls_memoryinfo = {
+  .my_name = "HLS segments",
+};
+
+/*
+ *
+ */
+static int
+hls_memfd(void)
+{
+#if ENABLE_MEMFD_CREATE
+  return memfd_create("tvh-hls", MFD_CLOEXEC);
+#else
+  char path[] = "/tmp/tvh-hls-XXXXXX";
+  int fd = mkstemp(path);
+  if (fd >= 0)
+    unlink(path);
+  return fd;
+#endif
+}
+
+static void
+hls_segment_free(hls_segment_t *hs)
+{
+  memoryinfo_free(&hls_memoryinfo, sizeof(*hs) + hs->hs_size);
+  close(hs->hs_fd);
+  free(hs);
+}
+
+/*
+ * Called with hls_lock held
+ */
+static void
+hls_session_release(hls_session_t *hss)
+{
+  hls_segment_t *hs;
+
+  if (--hss->hss_refcount > 0)
+    return;
+  while ((hs = TAILQ_FIRST(&hss->hss_queue)) != NULL) {
+    TAILQ_REMOVE(&hss->hss_queue, hs, hs_link);
+    hls_segment_free(hs);
+  }
+  free(hss->hss_channel);
+  free(hss);
+}
+
+/*
+ * Copy the last PAT and PMT packets of the finished segment to the
+ * head of the new one, so each segment can be decoded on its own.
+ */
+static void
+hls_psi(hls_session_t *hss, int fd, off_t size)
+{
+  uint8_t buf[188 * 64], pat[188], pmt[188], *tsb;
+  int have_pat = 0, have_pmt = 0, pid;
+  off_t off, limit = MAX(0, size - 2 * 1024 * 1024);
+  ssize_t r;
+
+  size -= size % 188;
+  for (off = size; off > limit && !(have_pat && have_pmt); ) {
+    r = MIN(off - limit, sizeof(buf));
+    off -= r;
+    if (pread(fd, buf, r, off) != r)
+      break;
+    for (tsb = buf + r - 188; tsb >= buf; tsb -= 188) {
+      if (tsb[0] != 0x47 || (tsb[1] & 0x40) == 0)
+        continue;
+      pid = (tsb[1] & 0x1f) << 8 | tsb[2];
+      if (pid == 0 && !have_pat) {
+        memcpy(pat, tsb, 188);
+        have_pat = 1;
+      } else if (pid == hss->hss_pmt_pid && !have_pmt) {
+        memcpy(pmt, tsb, 188);
+        have_pmt = 1;
+      }
+      if (have_pat && have_pmt)
+        break;
+    }
+  }
+  if (have_pat && have_pmt) {
+    tvh_write(hss->hss_fd, pat, 188);
+    tvh_write(hss->hss_fd, pmt, 188);
+  }
+}
+
+/*
+ * Close the current segment and continue with a fresh file
+ */
+static int
+hls_rotate(hls_session_t *hss)
+{
+  hls_segment_t *hs;
+  off_t size;
+  int fd, nfd;
+
+  size = lseek(hss->hss_fd, 0, SEEK_CUR);
+  fd = dup(hss->hss_fd);
+  nfd = hls_memfd();
+  if (fd < 0 || nfd < 0 || dup2(nfd, hss->hss_fd) < 0) {
+    tvherror(LS_WEBUI, "HLS: unable to create segment: %s", strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    if (nfd >= 0)
+      close(nfd);
+    return -1;
+  }
+  close(nfd);
+  hls_psi(hss, fd, size);
+
+  /* data before the first key frame are dropped */
+  if (!hss->hss_open) {
+    hss->hss_open = 1;
+    close(fd);
+    return 0;
+  }
+
+  hs = calloc(1, sizeof(*hs));
+  hs->hs_fd = fd;
+  hs->hs_size = size;
+  hs->hs_duration = hss->hss_seg_duration;
+  memoryinfo_alloc(&hls_memoryinfo, sizeof(*hs) + size);
+
+  tvh_mutex_lock(&hls_lock);
+  hs->hs_seq = hss->hss_seq++;
+  TAILQ_INSERT_TAIL(&hss->hss_queue, hs, hs_link);
+  hss->hss_target = MAX(hss->hss_target, (hs->hs_duration + 89999) / 90000);
+  /* keep two extra segments for clients which are behind */
+  if (++hss->hss_count > hss->hss_segments + 2) {
+    hs = TAILQ_FIRST(&hss->hss_queue);
+    TAILQ_REMOVE(&hss->hss_queue, hs, hs_link);
+    hss->hss_count--;
+    hls_segment_free(hs);
+  }
+  tvh_cond_signal(&hls_cond, 1);
+  tvh_mutex_unlock(&hls_lock);
+  return 0;
+}
+
+/*
+ * Check for a random access point (sequence header or IDR) in the
+ * first TS packet of a video PES
+ */
+static int
+hls_keyframe(hls_session_t *hss, const uint8_t *tsb, const uint8_t *p)
+{
+  const uint8_t *end = tsb + 188;
+  int t;
+
+  if ((tsb[3] & 0x20) && tsb[4] > 0 && (tsb[5] & 0x40))
+    return 1;
+  for (; p + 4 < end; p++) {
+    if (p[0] || p[1] || p[2] != 1)
+      continue;
+    p += 3;
+    switch (hss->hss_vtype) {
+    case SCT_H264:
+      t = p[0] & 0x1f;
+      if (t == 5 || t == 7)
+        return 1;
+      if (t == 1)
+        return 0;
+      break;
+    case SCT_HEVC:
+      t = (p[0] >> 1) & 0x3f;
+      if ((t >= 16 && t <= 21) || t == 32 || t == 33)
+        return 1;
+      if (t <= 9)
+        return 0;
+      break;
+    case SCT_MPEG2VIDEO:
+      if (p[0] == 0xb3)
+        return 1;
+      if (p[0] == 0x00 && p + 2 < end)
+        return ((p[2] >> 3) & 7) == 1;
+      break;
+    default:
+      return 0;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Returns 1 if a new segment should start with this TS packet
+ */
+static int
+hls_split(hls_session_t *hss, const uint8_t *tsb)
+{
+  const uint8_t *p;
+  int pid, key;
+  int64_t pts, d, target;
+
+  if (tsb[0] != 0x47 || (tsb[1] & 0x40) == 0 || (tsb[3] & 0x10) == 0)
+    return 0;
+  pid = (tsb[1] & 0x1f) << 8 | tsb[2];
+  if (pid != (hss->hss_vpid ?: hss->hss_apid) || pid == 0)
+    return 0;
+  p = tsb + 4;
+  if (tsb[3] & 0x20)
+    p += 1 + tsb[4];
+  if (p + 14 > tsb + 188 || p[0] || p[1] || p[2] != 1 || (p[7] & 0x80) == 0)
+    return 0;
+  pts = ((int64_t)(p[9] & 0x0e) << 29) | (p[10] << 22) |
+        ((p[11] & 0xfe) << 14) | (p[12] << 7) | (p[13] >> 1);
+  key = hss->hss_vpid ? hls_keyframe(hss, tsb, p + 9 + p[8]) : 1;
+  target = (int64_t)hss->hss_duration * 90000;
+
+  if (!hss->hss_open) {
+    if (hss->hss_pts_first < 0)
+      hss->hss_pts_first = pts;
+    /* do not wait forever for a key frame we cannot detect */
+    if (!key && ((pts - hss->hss_pts_first) & HLS_PTS_MASK) < 3 * target)
+      return 0;
+    hss->hss_pts_start = pts;
+    return 1;
+  }
+  d = (pts - hss->hss_pts_start) & HLS_PTS_MASK;
+  if (d < target || (!key && d < 3 * target))
+    return 0;
+  hss->hss_seg_duration = d;
+  hss->hss_pts_start = pts;
+  return 1;
+}
+
+/*
+ * Pass TS packets to the muxer, split on segment boundaries
+ */
+static void
+hls_write(hls_session_t *hss, pktbuf_t *pb)
+{
+  muxer_t *mux = hss->hss_prch.prch_muxer;
+  uint8_t *tsb = pktbuf_ptr(pb), *end = tsb + pktbuf_len(pb), *p;
+
+  for (p = tsb; p + 188 <= end; p += 188) {
+    if (!hls_split(hss, p))
+      continue;
+    if (p > tsb)
+      muxer_write_pkt(mux, SMT_MPEGTS, pktbuf_alloc(tsb, p - tsb));
+    if (hls_rotate(hss))
+      mux->m_errors++;
+    tsb = p;
+  }
+  if (tsb == pktbuf_ptr(pb)) {
+    muxer_write_pkt(mux, SMT_MPEGTS, pb);
+  } else {
+    if (end > tsb)
+      muxer_write_pkt(mux, SMT_MPEGTS, pktbuf_alloc(tsb, end - tsb));
+    pktbuf_ref_dec(pb);
+  }
+}
+
+static void
+hls_start(hls_session_t *hss, const streaming_start_t *ss)
+{
+  const streaming_start_component_t *ssc;
+  int i;
+
+  hss->hss_pmt_pid = ss->ss_pmt_pid;
+  hss->hss_vpid = hss->hss_apid = 0;
+  for (i = 0; i < ss->ss_num_components; i++) {
+    ssc = &ss->ss_components[i];
+    if (ssc->es_pid <= 0 || ssc->es_pid >= 0x1fff)
+      continue;
+    if (SCT_ISVIDEO(ssc->es_type) && !hss->hss_vpid) {
+      hss->hss_vpid = ssc->es_pid;
+      hss->hss_vtype = ssc->es_type;
+    } else if (SCT_ISAUDIO(ssc->es_type) && !hss->hss_apid) {
+      hss->hss_apid = ssc->es_pid;
+    }
+  }
+}
+
+/*
+ * Segmenter thread
+ */
+static void *
+hls_thread(void *aux)
+{
+  hls_session_t *hss = aux;
+  profile_chain_t *prch = &hss->hss_prch;
+  streaming_queue_t *sq = &prch->prch_sq;
+  muxer_t *mux = prch->prch_muxer;
+  streaming_message_t *sm;
+  struct streaming_message_queue backlog;
+  streaming_start_t *ss_copy;
+  int run = 1, started = 0, grace = 20, ptimeout;
+  int64_t lastpkt;
+
+  lastpkt = mclk();
+  ptimeout = prch->prch_pro ? prch->prch_pro->pro_timeout : 5;
+  TAILQ_INIT(&backlog);
+
+  tvh_mutex_lock(&sq->sq_mutex);
+  streaming_queue_wakeup(sq, 64*1024, ms2mono(100));
+  streaming_queue_policy(sq, SQ_POLICY_GOP, sec2mono(10));
+  tvh_mutex_unlock(&sq->sq_mutex);
+
+  while (run && atomic_get(&hss->hss_run) && tvheadend_is_running()) {
+    sm = TAILQ_FIRST(&backlog);
+    if (sm == NULL) {
+      tvh_mutex_lock(&sq->sq_mutex);
+      if (!TAILQ_EMPTY(&sq->sq_queue)) {
+        streaming_queue_take(sq, &backlog);
+        tvh_mutex_unlock(&sq->sq_mutex);
+        continue;
+      }
+      tvh_cond_timedwait(&sq->sq_cond, &sq->sq_mutex, mclk() + sec2mono(1));
+      tvh_mutex_unlock(&sq->sq_mutex);
+      if ((!started && mclk() - lastpkt > sec2mono(grace)) ||
+          (started && ptimeout > 0 && mclk() - lastpkt > sec2mono(ptimeout))) {
+        tvhwarn(LS_WEBUI, "HLS: stop segmenter %s, timeout waiting for packets",
+                hss->hss_key);
+        run = 0;
+      }
+      continue;
+    }
+    TAILQ_REMOVE(&backlog, sm, sm_link);
+
+    switch (sm->sm_type) {
+    case SMT_MPEGTS:
+      if (started) {
+        subscription_add_bytes_out(hss->hss_sub, pktbuf_len(sm->sm_data));
+        lastpkt = mclk();
+        hls_write(hss, sm->sm_data);
+        sm->sm_data = NULL;
+      }
+      break;
+
+    case SMT_GRACE:
+      grace = sm->sm_code < 5 ? 5 : grace;
+      break;
+
+    case SMT_START:
+      grace = 10;
+      hls_start(hss, sm->sm_data);
+      if (!started) {
+        tvhdebug(LS_WEBUI, "HLS: start segmenter %s", hss->hss_key);
+        ss_copy = streaming_start_copy((streaming_start_t *)sm->sm_data);
+        if (muxer_init(mux, ss_copy, hss->hss_key) < 0)
+          run = 0;
+        streaming_start_unref(ss_copy);
+        started = 1;
+      } else if (muxer_reconfigure(mux, sm->sm_data) < 0) {
+        tvhwarn(LS_WEBUI, "HLS: unable to reconfigure segmenter %s", hss->hss_key);
+      }
+      break;
+
+    case SMT_STOP:
+      if ((mux->m_caps & MC_CAP_ANOTHER_SERVICE) != 0)
+        break;
+      if (sm->sm_code != SM_CODE_SOURCE_RECONFIGURED) {
+        tvhwarn(LS_WEBUI, "HLS: stop segmenter %s, %s", hss->hss_key,
+                streaming_code2txt(sm->sm_code));
+        run = 0;
+      }
+      break;
+
+    case SMT_NOSTART:
+    case SMT_EXIT:
+      tvhwarn(LS_WEBUI, "HLS: stop segmenter %s, %s", hss->hss_key,
+              streaming_code2txt(sm->sm_code));
+      run = 0;
+      break;
+
+    default:
+      break;
+    }
+
+    streaming_msg_free(sm);
+
+    if (mux->m_errors) {
+      tvhwarn(LS_WEBUI, "HLS: stop segmenter %s, muxer reported errors",
+              hss->hss_key);
+      run = 0;
+    }
+  }
+
+  streaming_queue_clear(&backlog);
+
+  if (started)
+    muxer_close(mux);
+
+  tvh_mutex_lock(&hls_lock);
+  hss->hss_done = 1;
+  tvh_cond_signal(&hls_cond, 1);
+  tvh_mutex_unlock(&hls_lock);
+  return NULL;
+}
+
+/*
+ * Stop the segmenter, called with global_lock held
+ */
+static void
+hls_session_stop(hls_session_t *hss)
+{
+  streaming_queue_t *sq = &hss->hss_prch.prch_sq;
+
+  atomic_set(&hss->hss_run, 0);
+  tvh_mutex_lock(&sq->sq_mutex);
+  tvh_cond_signal(&sq->sq_cond, 0);
+  tvh_mutex_unlock(&sq->sq_mutex);
+  pthread_join(hss->hss_tid, NULL);
+
+  tvhdebug(LS_WEBUI, "HLS: segmenter %s stopped", hss->hss_key);
+  subscription_unsubscribe(hss->hss_sub, UNSUBSCRIBE_FINAL);
+  profile_chain_close(&hss->hss_prch);
+  close(hss->hss_fd);
+
+  tvh_mutex_lock(&hls_lock);
+  hss->hss_done = 1;
+  tvh_cond_signal(&hls_cond, 1);
+  hls_session_release(hss);
+  tvh_mutex_unlock(&hls_lock);
+}
+
+static void
+hls_timer_cb(void *aux)
+{
+  hls_session_t *hss;
+
+  tvh_mutex_lock(&hls_lock);
+  while (1) {
+    LIST_FOREACH(hss, &hls_sessions, hss_link)
+      if (hss->hss_done ||
+          mclk() - hss->hss_access > sec2mono(hss->hss_idle))
+        break;
+    if (hss == NULL)
+      break;
+    LIST_REMOVE(hss, hss_link);
+    tvh_mutex_unlock(&hls_lock);
+    hls_session_stop(hss);
+    tvh_mutex_lock(&hls_lock);
+  }
+  if (!LIST_EMPTY(&hls_sessions))
+    mtimer_arm_rel(&hls_timer, hls_timer_cb, NULL, sec2mono(1));
+  tvh_mutex_unlock(&hls_lock);
+}
+
+/*
+ * Start a new segmenter, called with global_lock held
+ */
+static hls_session_t *
+hls_session_create(http_connection_t *hc, channel_t *ch, profile_t *pro)
+{
+  hls_session_t *hss;
+  muxer_hints_t *hints;
+  uint8_t bin[16];
+  char ubuf[UUID_HEX_SIZE];
+  const char *str;
+  size_t qsize;
+  int weight;
+
+  hss = calloc(1, sizeof(*hss));
+  hss->hss_fd = -1;
+  hss->hss_pts_first = -1;
+  TAILQ_INIT(&hss->hss_queue);
+  profile_hls_config(pro, &hss->hss_duration, &hss->hss_segments, &hss->hss_idle);
+  hss->hss_target = hss->hss_duration;
+  uuid_random(bin, sizeof(bin));
+  bin2hex(hss->hss_key, sizeof(hss->hss_key), bin, sizeof(bin));
+  hss->hss_channel = strdup(idnode_uuid_as_str(&ch->ch_id, ubuf));
+
+  weight = (str = http_arg_get(&hc->hc_req_args, "weight")) ? atoi(str) : 0;
+  qsize = (str = http_arg_get(&hc->hc_req_args, "qsize")) ? atoll(str) : 1500000;
+  hints = muxer_hints_create(http_arg_get(&hc->hc_args, "User-Agent"));
+
+  profile_chain_init(&hss->hss_prch, pro, ch, 1);
+  if (profile_chain_open(&hss->hss_prch, NULL, hints, 0, qsize))
+    goto fail;
+  if ((hss->hss_fd = hls_memfd()) < 0 ||
+      muxer_open_stream(hss->hss_prch.prch_muxer, hss->hss_fd))
+    goto fail;
+  hss->hss_sub = subscription_create_from_channel(&hss->hss_prch,
+                   NULL, weight, "HLS",
+                   hss->hss_prch.prch_flags | SUBSCRIPTION_STREAMING,
+                   hc->hc_peer_ipstr, http_username(hc),
+                   http_arg_get(&hc->hc_args, "User-Agent"),
+                   NULL);
+  if (hss->hss_sub == NULL)
+    goto fail;
+
+  tvhdebug(LS_WEBUI, "HLS: segmenter %s for channel %s profile %s",
+           hss->hss_key, channel_get_name(ch, channel_blank_name),
+           profile_get_name(pro));
+
+  hss->hss_refcount = 1;
+  hss->hss_run = 1;
+  hss->hss_access = mclk();
+  tvh_thread_create(&hss->hss_tid, NULL, hls_thread, hss, "hls");
+
+  tvh_mutex_lock(&hls_lock);
+  LIST_INSERT_HEAD(&hls_sessions, hss, hss_link);
+  mtimer_arm_rel(&hls_timer, hls_timer_cb, NULL, sec2mono(1));
+  tvh_mutex_unlock(&hls_lock);
+  return hss;
+
+fail:
+  profile_chain_close(&hss->hss_prch);
+  if (hss->hss_fd >= 0)
+    close(hss->hss_fd);
+  free(hss->hss_channel);
+  free(hss);
+  return NULL;
+}
+
+/*
+ * The requested profile, or the first allowed HLS profile
+ */
+static profile_t *
+hls_profile(http_connection_t *hc)
+{
+  profile_t *pro;
+
+  pro = profile_find_by_list(hc->hc_access->aa_profiles,
+                             http_arg_get(&hc->hc_req_args, "profile"),
+                             "hls", SUBSCRIPTION_MPEGTS);
+  if (pro && idnode_is_instance(&pro->pro_id, &profile_hls_class))
+    return pro;
+  pro = profile_find_by_list(hc->hc_access->aa_profiles, "hls", NULL,
+                             SUBSCRIPTION_MPEGTS);
+  if (pro && idnode_is_instance(&pro->pro_id, &profile_hls_class))
+    return pro;
+  return NULL;
+}
+
+/*
+ * Live playlist, called with global_lock held
+ */
+static int
+hls_playlist(http_connection_t *hc, channel_t *ch)
+{
+  htsbuf_queue_t *hq = &hc->hc_reply;
+  hls_session_t *hss;
+  hls_segment_t *hs;
+  profile_t *pro;
+  char ubuf[UUID_HEX_SIZE];
+  const char *str;
+  int64_t msn = -1, mono;
+  int i, r = 0;
+
+  if (http_access_verify_channel(hc, ACCESS_STREAMING, ch))
+    return http_noaccess_code(hc);
+  if ((pro = hls_profile(hc)) == NULL)
+    return HTTP_STATUS_NOT_ALLOWED;
+  /* blocking playlist reload (LL-HLS delivery directive) */
+  if ((str = http_arg_get(&hc->hc_req_args, "_HLS_msn")) != NULL)
+    msn = strtoll(str, NULL, 10);
+
+  idnode_uuid_as_str(&ch->ch_id, ubuf);
+  tvh_mutex_lock(&hls_lock);
+  LIST_FOREACH(hss, &hls_sessions, hss_link)
+    if (!hss->hss_done && hss->hss_prch.prch_pro == pro &&
+        !strcmp(hss->hss_channel, ubuf))
+      break;
+  if (hss == NULL) {
+    tvh_mutex_unlock(&hls_lock);
+    if ((hss = hls_session_create(hc, ch, pro)) == NULL)
+      return HTTP_STATUS_SERVICE;
+    tvh_mutex_lock(&hls_lock);
+  }
+  hss->hss_refcount++;
+  hss->hss_access = mclk();
+  tvh_mutex_unlock(&global_lock);
+
+  /* more than two segments ahead of the last one, do not block */
+  if (msn > hss->hss_seq + 1)
+    r = HTTP_STATUS_BAD_REQUEST;
+
+  mono = mclk() + sec2mono(MAX(20, 3 * hss->hss_duration));
+  while (!r && !hss->hss_done &&
+         (TAILQ_EMPTY(&hss->hss_queue) || (msn >= 0 && hss->hss_seq <= msn)))
+    if (tvh_cond_timedwait(&hls_cond, &hls_lock, mono) == ETIMEDOUT)
+      break;
+
+  if (r) {
+    /* error already set */
+  } else if ((hs = TAILQ_FIRST(&hss->hss_queue)) == NULL) {
+    r = HTTP_STATUS_SERVICE;
+  } else {
+    for (i = hss->hss_count; i > hss->hss_segments; i--)
+      hs = TAILQ_NEXT(hs, hs_link);
+    htsbuf_qprintf(hq, "#EXTM3U\n"
+                       "#EXT-X-VERSION:3\n"
+                       "#EXT-X-TARGETDURATION:%d\n"
+                       "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES\n"
+                       "#EXT-X-MEDIA-SEQUENCE:%"PRId64"\n",
+                   hss->hss_target, hs->hs_seq);
+    for (; hs; hs = TAILQ_NEXT(hs, hs_link))
+      htsbuf_qprintf(hq, "#EXTINF:%.3f,\n%s/hls/segment/%s/%"PRId64".ts\n",
+                     hs->hs_duration / 90000.0, tvheadend_webroot ?: "",
+                     hss->hss_key, hs->hs_seq);
+  }
+  hss->hss_access = mclk();
+  hls_session_release(hss);
+  tvh_mutex_unlock(&hls_lock);
+
+  if (r == 0)
+    http_output_content(hc, "application/vnd.apple.mpegurl");
+  tvh_mutex_lock(&global_lock);
+  return r;
+}
+
+/*
+ * Send one cached segment
+ */
+static int
+hls_segment(http_connection_t *hc, const char *key, int64_t seq)
+{
+  hls_session_t *hss;
+  hls_segment_t *hs = NULL;
+  int64_t mono;
+  off_t size = 0, chunk;
+  int fd = -1, ret = 0;
+#if defined(PLATFORM_LINUX)
+  off_t off = 0;
+  ssize_t r;
+#elif defined(PLATFORM_FREEBSD) || defined(PLATFORM_DARWIN)
+  off_t off = 0, r;
+#endif
+
+  tvh_mutex_lock(&hls_lock);
+  LIST_FOREACH(hss, &hls_sessions, hss_link)
+    if (!strcmp(hss->hss_key, key))
+      break;
+  if (hss) {
+    hss->hss_refcount++;
+    hss->hss_access = mclk();
+    /* wait for the segment in progress */
+    mono = mclk() + sec2mono(3 * hss->hss_duration);
+    while (!hss->hss_done && seq >= hss->hss_seq && seq <= hss->hss_seq + 1)
+      if (tvh_cond_timedwait(&hls_cond, &hls_lock, mono) == ETIMEDOUT)
+        break;
+    TAILQ_FOREACH(hs, &hss->hss_queue, hs_link)
+      if (hs->hs_seq == seq)
+        break;
+    if (hs) {
+      fd = dup(hs->hs_fd);
+      size = hs->hs_size;
+    }
+    hls_session_release(hss);
+  }
+  tvh_mutex_unlock(&hls_lock);
+
+  if (fd < 0)
+    return HTTP_STATUS_NOT_FOUND;
+
+  http_send_begin(hc);
+  http_send_header(hc, HTTP_STATUS_OK, "video/mp2t", size,
+                   NULL, NULL, 60, NULL, NULL, NULL);
+  if (!hc->hc_no_output) {
+    while (size > 0) {
+      chunk = MIN(1024 * 1024, size);
+#if defined(PLATFORM_LINUX)
+      r = sendfile(hc->hc_fd, fd, &off, chunk);
+      if (r <= 0) {
+        ret = -1;
+        break;
+      }
+#elif defined(PLATFORM_FREEBSD)
+      ret = sendfile(fd, hc->hc_fd, off, chunk, NULL, &r, 0);
+      if (ret < 0)
+        break;
+      off += r;
+#elif defined(PLATFORM_DARWIN)
+      r = chunk;
+      ret = sendfile(fd, hc->hc_fd, off, &r, NULL, 0);
+      if (ret < 0)
+        break;
+      off += r;
+#endif
+      size -= r;
+    }
+  }
+  http_send_end(hc);
+  close(fd);
+  return ret;
+}
+
+/**
+ * Handle the http request. http://tvheadend/hls/channel/<uuid>/index.m3u8
+ *                          http://tvheadend/hls/channelid/<chid>/index.m3u8
+ *                          http://tvheadend/hls/channelnumber/<channelnumber>/index.m3u8
+ *                          http://tvheadend/hls/channelname/<channelname>/index.m3u8
+ *                          http://tvheadend/hls/segment/<key>/<seq>.ts
+ */
+static int
+page_hls(http_connection_t *hc, const char *remain, void *opaque)
+{
+  char *components[3];
+  channel_t *ch = NULL;
+  int r;
+
+  if (remain == NULL)
+    return HTTP_STATUS_BAD_REQUEST;
+  if (http_tokenize((char *)remain, components, 3, '/') < 2)
+    return HTTP_STATUS_BAD_REQUEST;
+  http_deescape(components[1]);
+
+  if (!strcmp(components[0], "segment"))
+    return hls_segment(hc, components[1], strtoll(components[2] ?: "", NULL, 10));
+
+  tvh_mutex_lock(&global_lock);
+  if (!strcmp(components[0], "channelid")) {
+    ch = channel_find_by_id(atoi(components[1]));
+  } else if (!strcmp(components[0], "channelnumber")) {
+    ch = channel_find_by_number(components[1]);
+  } else if (!strcmp(components[0], "channelname")) {
+    ch = channel_find_by_name(components[1]);
+  } else if (!strcmp(components[0], "channel")) {
+    ch = channel_find(components[1]);
+  }
+  r = ch ? hls_playlist(hc, ch) : HTTP_STATUS_BAD_REQUEST;
+  tvh_mutex_unlock(&global_lock);
+  return r;
+}
+
+/*
+ * Redirect /stream requests with a HLS profile to the playlist
+ */
+int
+hls_redirect(http_connection_t *hc, channel_t *ch)
+{
+  http_arg_list_t args;
+  http_arg_t *ra;
+  char path[128], ubuf[UUID_HEX_SIZE];
+
+  snprintf(path, sizeof(path), "/hls/channel/%s/index.m3u8",
+           idnode_uuid_as_str(&ch->ch_id, ubuf));
+  http_arg_init(&args);
+  TAILQ_FOREACH(ra, &hc->hc_req_args, link)
+    if (strcmp(ra->key, "ticket"))
+      http_arg_set(&args, ra->key, ra->val);
+  /* tickets are bound to the resource path */
+  if (http_arg_get(&hc->hc_req_args, "ticket"))
+    http_arg_set(&args, "ticket", access_ticket_create(path, hc->hc_access));
+  http_redirect(hc, path, &args, 0);
+  http_arg_flush(&args);
+  return 0;
+}
+
+/*
+ *
+ */
+void
+hls_init(void)
+{
+  LIST_INIT(&hls_sessions);
+  tvh_mutex_init(&hls_lock, NULL);
+  tvh_cond_init(&hls_cond, 1);
+  memoryinfo_register(&hls_memoryinfo);
+  http_path_add("/hls", NULL, page_hls, ACCESS_ANONYMOUS);
+}
+
+void
+hls_done(void)
+{
+  hls_session_t *hss;
+
+  tvh_mutex_lock(&global_lock);
+  mtimer_disarm(&hls_timer);
+  tvh_mutex_lock(&hls_lock);
+  while ((hss = LIST_FIRST(&hls_sessions)) != NULL) {
+    LIST_REMOVE(hss, hss_link);
+    tvh_mutex_unlock(&hls_lock);
+    hls_session_stop(hss);
+    tvh_mutex_lock(&hls_lock);
+  }
+  tvh_mutex_unlock(&hls_lock);
+  memoryinfo_unregister(&hls_memoryinfo);
+  tvh_mutex_unlock(&global_lock);
+}
@@ -24,6 +24,11 @@ tvheadend.status_subs = function(panel, index)
             if (m.descramble) r.data.descramble = m.descramble;
             if (m.profile) r.data.profile = m.profile;
             r.data.errors = m.errors;
+            if (m.join_latency != null) r.data.join_latency = m.join_latency;
+            if (m.gop_hit_rate != null) r.data.gop_hit_rate = m.gop_hit_rate;
+            if (m.queue_delay != null) r.data.queue_delay = m.queue_delay;
+            if (m.queue_peak != null) r.data.queue_peak = m.queue_peak;
+            if (m.drops != null) r.data.drops = m.drops;
             r.data['in'] = m['in'];
             r.data.out = m.out;
 
@@ -54,6 +59,11 @@ tvheadend.status_subs = function(panel, index)
                 { name: 'pids' },
                 { name: 'descramble', sortType: stype },
                 { name: 'errors', sortType: stypei },
+                { name: 'join_latency', sortType: stypei },
+                { name: 'gop_hit_rate', sortType: stypei },
+                { name: 'queue_delay', sortType: stypei },
+                { name: 'queue_peak', sortType: stypei },
+                { name: 'drops', sortType: stypei },
                 { name: 'in', sortType: stypei },
                 { name: 'out', sortType: stypei },
                 {
@@ -187,6 +197,46 @@ tvheadend.status_subs = function(panel, index)
                 dataIndex: 'errors',
                 sortable: true
             },
+            {
+                width: 50,
+                id: 'join_latency',
+                header: _("Join (ms)"),
+                dataIndex: 'join_latency',
+                sortable: true,
+                hidden: true
+            },
+            {
+                width: 50,
+                id: 'gop_hit_rate',
+                header: _("Keyframe cache hits (%)"),
+                dataIndex: 'gop_hit_rate',
+                sortable: true,
+                hidden: true
+            },
+            {
+                width: 50,
+                id: 'queue_delay',
+                header: _("Queue delay (ms)"),
+                dataIndex: 'queue_delay',
+                sortable: true,
+                hidden: true
+            },
+            {
+                width: 50,
+                id: 'queue_peak',
+                header: _("Peak queue delay (ms)"),
+                dataIndex: 'queue_peak',
+                sortable: true,
+                hidden: true
+            },
+            {
+                width: 50,
+                id: 'drops',
+                header: _("Drops"),
+                dataIndex: 'drops',
+                sortable: true,
+                hidden: true
+            },
             {
                 width: 50,
                 id: 'in',
@@ -300,6 +350,8 @@ tvheadend.status_streams = function(panel, index)
         r.data.tc_bit = m.tc_bit;
         r.data.ec_block = m.ec_block;
         r.data.tc_block = m.tc_block;
+        r.data.seg_latency = m.seg_latency;
+        r.data.seg_depth = m.seg_depth;
 
         store.afterEdit(r);
         store.fireEvent('updated', store, Ext.data.Record.COMMIT);
@@ -361,7 +413,9 @@ tvheadend.status_streams = function(panel, index)
                 { name: 'ec_bit', sortType: stypei },
                 { name: 'tc_bit', sorttype: stypei },
                 { name: 'ec_block', sortType: stypei },
-                { name: 'tc_block', sortType: stypei }
+                { name: 'tc_block', sortType: stypei },
+                { name: 'seg_latency', sortType: stypei },
+                { name: 'seg_depth', sortType: stypei }
             ],
             url: 'api/status/inputs',
             autoLoad: true,
@@ -477,6 +531,20 @@ tvheadend.status_streams = function(panel, index)
                 header: _("Continuity Errors"),
                 dataIndex: 'cc',
                 sortable: true
+            },
+            {
+                width: 50,
+                header: _("Segment Latency (ms)"),
+                dataIndex: 'seg_latency',
+                sortable: true,
+                hidden: true
+            },
+            {
+                width: 50,
+                header: _("Segments Buffered"),
+                dataIndex: 'seg_depth',
+                sortable: true,
+                hidden: true
             }
         ]);
 
@@ -31,6 +31,7 @@
 #include "imagecache.h"
 #include "lang_codes.h"
 #include "intlconv.h"
+#include "tvhio.h"
 #if ENABLE_MPEGTS
 #include "input.h"
 #endif
@@ -333,6 +334,7 @@ http_stream_run(http_connection_t *hc, profile_chain_t *prch,
 		const char *name, th_subscription_t *s)
 {
   streaming_message_t *sm;
+  struct streaming_message_queue backlog;
   int run = 1, started = 0;
   streaming_queue_t *sq = &prch->prch_sq;
   muxer_t *mux = prch->prch_muxer;
@@ -353,17 +355,27 @@ http_stream_run(http_connection_t *hc, profile_chain_t *prch,
 
   lastpkt = mclk();
   ptimeout = prch->prch_pro ? prch->prch_pro->pro_timeout : 5;
+  TAILQ_INIT(&backlog);
 
-  if (hc->hc_no_output) {
-    tvh_mutex_lock(&sq->sq_mutex);
+  tvh_mutex_lock(&sq->sq_mutex);
+  if (hc->hc_no_output)
     sq->sq_maxsize = 100000;
-    tvh_mutex_unlock(&sq->sq_mutex);
+  else {
+    streaming_queue_wakeup(sq, 32*1024, ms2mono(50));
+    /* slow clients skip to the next keyframe instead of a broken stream */
+    streaming_queue_policy(sq, SQ_POLICY_GOP, sec2mono(10));
   }
+  tvh_mutex_unlock(&sq->sq_mutex);
 
   while(!hc->hc_shutdown && run && tvheadend_is_running()) {
-    tvh_mutex_lock(&sq->sq_mutex);
-    sm = TAILQ_FIRST(&sq->sq_queue);
+    sm = TAILQ_FIRST(&backlog);
     if(sm == NULL) {
+      tvh_mutex_lock(&sq->sq_mutex);
+      if (!TAILQ_EMPTY(&sq->sq_queue)) {
+        streaming_queue_take(sq, &backlog);
+        tvh_mutex_unlock(&sq->sq_mutex);
+        continue;
+      }
       mono = mclk() + sec2mono(1);
       do {
         r = tvh_cond_timedwait(&sq->sq_cond, &sq->sq_mutex, mono);
@@ -384,8 +396,7 @@ http_stream_run(http_connection_t *hc, profile_chain_t *prch,
       continue;
     }
 
-    streaming_queue_remove(sq, sm);
-    tvh_mutex_unlock(&sq->sq_mutex);
+    TAILQ_REMOVE(&backlog, sm, sm_link);
 
     switch(sm->sm_type) {
     case SMT_MPEGTS:
@@ -418,6 +429,7 @@ http_stream_run(http_connection_t *hc, profile_chain_t *prch,
 
         if (hc->hc_no_output) {
           streaming_msg_free(sm);
+          streaming_queue_clear(&backlog);
           mono = mclk() + sec2mono(2);
           while (mclk() < mono) {
             if (tcp_socket_dead(hc->hc_fd))
@@ -490,6 +502,8 @@ http_stream_run(http_connection_t *hc, profile_chain_t *prch,
     }
   }
 
+  streaming_queue_clear(&backlog);
+
   if(started)
     muxer_close(mux);
 }
@@ -1289,6 +1303,9 @@ http_stream_channel(http_connection_t *hc, channel_t *ch, int weight)
                                   SUBSCRIPTION_PACKET | SUBSCRIPTION_MPEGTS)))
     return HTTP_STATUS_NOT_ALLOWED;
 
+  if (idnode_is_instance(&pro->pro_id, &profile_hls_class))
+    return hls_redirect(hc, ch);
+
   if((tcp_id = http_stream_preop(hc)) == NULL)
     return HTTP_STATUS_NOT_ALLOWED;
 
@@ -1789,6 +1806,10 @@ http_serve_file(http_connection_t *hc, const char *fname,
   if(!hc->hc_no_output) {
     while(content_len > 0) {
       chunk = MIN(1024 * ((stats ? 128 : 1024) * 1024), content_len);
+      /* let the kernel fetch the next chunk while this one is sent */
+      if (content_len > chunk)
+        tvhio_readahead(fd, file_end + 1 - content_len + chunk,
+                        MIN(chunk, content_len - chunk));
 #if defined(PLATFORM_LINUX)
       r = sendfile(hc->hc_fd, fd, NULL, chunk);
       if (r < 0) {
@@ -2159,11 +2180,14 @@ webui_init(int xspf)
   simpleui_start();
   extjs_start();
   comet_init();
+  hls_init();
   webui_api_init();
 }
 
 void
 webui_done(void)
 {
+  webui_api_done();
+  hls_done();
   comet_done();
 }
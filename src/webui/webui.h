@@ -51,12 +51,21 @@ int page_static_file(http_connection_t *hc, const char *remain, void *opaque);
 int page_xmltv(http_connection_t *hc, const char *remain, void *opaque);
 int page_markdown(http_connection_t *hc, const char *remain, void *opaque);
 
+struct channel;
+void hls_init(void);
+void hls_done(void);
+int hls_redirect(http_connection_t *hc, struct channel *ch);
+
 #if ENABLE_LINUXDVB
 void extjs_start_dvb(void);
 #endif
 
 void webui_api_init ( void );
 
+void webui_api_done ( void );
+
+void webui_api_cache_invalidate ( const char *event );
+
 
 /**
  *
@@ -24,14 +24,344 @@
 #include "api.h"
 #include "htsmsg.h"
 #include "htsmsg_json.h"
+#include "memoryinfo.h"
+
+/*
+ * Response cache for the read-heavy endpoints
+ *
+ * The entries are keyed by the endpoint, arguments and the access rights,
+ * they keep the serialized and the gzip encoded body. An entry is dropped
+ * when one of the listed notification events is raised or when it's older
+ * than maxage (for the data which change without notifications).
+ */
+
+#define WEBUI_API_CACHE_HASH     64
+#define WEBUI_API_CACHE_ENTRIES  256
+#define WEBUI_API_CACHE_SIZE     (32*1024*1024)
+
+typedef struct webui_api_cache_rule {
+  const char *subsystem;
+  const char *events[3];
+  int         maxage;
+} webui_api_cache_rule_t;
+
+static const webui_api_cache_rule_t webui_api_cache_rules[] = {
+  { "channel/grid",         { "channel" },            60 },
+  { "channel/list",         { "channel" },            60 },
+  { "channeltag/grid",      { "channeltag" },         60 },
+  { "channeltag/list",      { "channeltag" },         60 },
+  { "epg/events/grid",      { "epg", "channel" },      5 },
+  { "epg/events/load",      { "epg", "channel" },      5 },
+  { "status/connections",   { "connections" },         1 },
+  { "status/subscriptions", { "subscriptions" },       1 },
+  { "status/inputs",        { "input_status" },        1 },
+};
+
+typedef struct webui_api_cache_entry {
+  LIST_ENTRY(webui_api_cache_entry)  wace_hash_link;
+  TAILQ_ENTRY(webui_api_cache_entry) wace_lru_link;
+  int       wace_refcnt;
+  int       wace_linked;
+  uint32_t  wace_hash;
+  int       wace_rule;
+  int       wace_gen;
+  int64_t   wace_expire;
+  char     *wace_key;
+  char     *wace_data;
+  size_t    wace_size;
+  uint8_t  *wace_data_gz;
+  size_t    wace_size_gz;
+  char      wace_etag[2 * 20 + 3];
+} webui_api_cache_entry_t;
+
+LIST_HEAD(webui_api_cache_list, webui_api_cache_entry);
+TAILQ_HEAD(webui_api_cache_queue, webui_api_cache_entry);
+
+static tvh_mutex_t webui_api_cache_mutex = TVH_THREAD_MUTEX_INITIALIZER;
+static struct webui_api_cache_list webui_api_cache_hash[WEBUI_API_CACHE_HASH];
+static struct webui_api_cache_queue webui_api_cache_lru;
+static int webui_api_cache_count;
+static size_t webui_api_cache_bytes;
+static int webui_api_cache_gen[ARRAY_SIZE(webui_api_cache_rules)];
+
+static memoryinfo_t webui_api_cache_memoryinfo = { .my_name = "HTTP API cache" };
+
+/*
+ * Called from the notification code, may be called with global_lock held
+ */
+void
+webui_api_cache_invalidate ( const char *event )
+{
+  const webui_api_cache_rule_t *rule;
+  int i, j;
+
+  for (i = 0; i < ARRAY_SIZE(webui_api_cache_rules); i++) {
+    rule = &webui_api_cache_rules[i];
+    for (j = 0; j < ARRAY_SIZE(rule->events) && rule->events[j]; j++)
+      if (strcmp(rule->events[j], event) == 0) {
+        atomic_add(&webui_api_cache_gen[i], 1);
+        break;
+      }
+  }
+}
+
+static int
+webui_api_cache_rule_find ( const char *subsystem )
+{
+  int i;
+
+  for (i = 0; i < ARRAY_SIZE(webui_api_cache_rules); i++)
+    if (strcmp(webui_api_cache_rules[i].subsystem, subsystem) == 0)
+      return i;
+  return -1;
+}
+
+static char *
+webui_api_cache_key ( http_connection_t *hc, const char *remain )
+{
+  access_t *a = hc->hc_access;
+  htsbuf_queue_t q;
+  http_arg_t *ha;
+  int i;
+
+  if (a == NULL)
+    return NULL;
+  htsbuf_queue_init(&q, 0);
+  htsbuf_qprintf(&q, "%s\n", remain);
+  TAILQ_FOREACH(ha, &hc->hc_req_args, link) {
+    if (ha->val == NULL) {
+      htsbuf_queue_flush(&q);
+      return NULL;
+    }
+    htsbuf_qprintf(&q, "%s=%s\n", ha->key, ha->val);
+  }
+  htsbuf_qprintf(&q, "\n%s\n%s\n%s\n%s\n%08x\n%d\n",
+                 a->aa_username ?: "", a->aa_representative ?: "",
+                 a->aa_lang ?: "", a->aa_lang_ui ?: "",
+                 a->aa_rights, a->aa_uilevel);
+  for (i = 0; i < a->aa_chrange_count; i++)
+    htsbuf_qprintf(&q, "%"PRIu64",", a->aa_chrange[i]);
+  if (a->aa_chtags)
+    htsmsg_json_serialize(a->aa_chtags, &q, 0);
+  if (a->aa_chtags_exclude)
+    htsmsg_json_serialize(a->aa_chtags_exclude, &q, 0);
+  if (a->aa_profiles)
+    htsmsg_json_serialize(a->aa_profiles, &q, 0);
+  if (a->aa_dvrcfgs)
+    htsmsg_json_serialize(a->aa_dvrcfgs, &q, 0);
+  return htsbuf_to_string(&q);
+}
+
+static void
+webui_api_cache_release ( webui_api_cache_entry_t *e )
+{
+  if (--e->wace_refcnt > 0)
+    return;
+  memoryinfo_free(&webui_api_cache_memoryinfo,
+                  sizeof(*e) + e->wace_size + e->wace_size_gz);
+  free(e->wace_key);
+  free(e->wace_data);
+  free(e->wace_data_gz);
+  free(e);
+}
+
+static void
+webui_api_cache_unlink ( webui_api_cache_entry_t *e )
+{
+  LIST_REMOVE(e, wace_hash_link);
+  TAILQ_REMOVE(&webui_api_cache_lru, e, wace_lru_link);
+  e->wace_linked = 0;
+  webui_api_cache_count--;
+  webui_api_cache_bytes -= e->wace_size + e->wace_size_gz;
+  webui_api_cache_release(e);
+}
+
+static inline int
+webui_api_cache_valid ( webui_api_cache_entry_t *e )
+{
+  return e->wace_gen == atomic_get(&webui_api_cache_gen[e->wace_rule]) &&
+         e->wace_expire > mclk();
+}
+
+/*
+ * Find the entry, the caller must release the returned reference
+ */
+static webui_api_cache_entry_t *
+webui_api_cache_find ( int rule, const char *key, uint32_t hash )
+{
+  webui_api_cache_entry_t *e;
+
+  tvh_mutex_lock(&webui_api_cache_mutex);
+  LIST_FOREACH(e, &webui_api_cache_hash[hash % WEBUI_API_CACHE_HASH], wace_hash_link)
+    if (e->wace_hash == hash && e->wace_rule == rule &&
+        strcmp(e->wace_key, key) == 0)
+      break;
+  if (e) {
+    if (webui_api_cache_valid(e)) {
+      TAILQ_REMOVE(&webui_api_cache_lru, e, wace_lru_link);
+      TAILQ_INSERT_TAIL(&webui_api_cache_lru, e, wace_lru_link);
+      e->wace_refcnt++;
+    } else {
+      webui_api_cache_unlink(e);
+      e = NULL;
+    }
+  }
+  tvh_mutex_unlock(&webui_api_cache_mutex);
+  return e;
+}
+
+/*
+ * Create the entry from the serialized reply, the key is consumed
+ */
+static webui_api_cache_entry_t *
+webui_api_cache_store
+  ( htsbuf_queue_t *hq, int rule, int gen, char *key, uint32_t hash )
+{
+  webui_api_cache_entry_t *e, *e2;
+  uint8_t sha1[20];
+
+  e = calloc(1, sizeof(*e));
+  e->wace_refcnt = 1;
+  e->wace_hash = hash;
+  e->wace_rule = rule;
+  e->wace_gen = gen;
+  e->wace_expire = mclk() + sec2mono(webui_api_cache_rules[rule].maxage);
+  e->wace_key = key;
+  e->wace_size = hq->hq_size;
+  e->wace_data = htsbuf_to_string(hq);
+#if ENABLE_ZLIB
+  if (e->wace_size > 256)
+    e->wace_data_gz = tvh_gzip_deflate((uint8_t *)e->wace_data, e->wace_size,
+                                       &e->wace_size_gz);
+#endif
+  sha1_calc(sha1, (uint8_t *)e->wace_data, e->wace_size, NULL, 0);
+  e->wace_etag[0] = '"';
+  bin2hex(e->wace_etag + 1, 2 * sizeof(sha1) + 1, sha1, sizeof(sha1));
+  strcpy(e->wace_etag + 1 + 2 * sizeof(sha1), "\"");
+  memoryinfo_alloc(&webui_api_cache_memoryinfo,
+                   sizeof(*e) + e->wace_size + e->wace_size_gz);
+
+  if (e->wace_size + e->wace_size_gz > WEBUI_API_CACHE_SIZE / 8)
+    return e;
+
+  tvh_mutex_lock(&webui_api_cache_mutex);
+  LIST_FOREACH(e2, &webui_api_cache_hash[hash % WEBUI_API_CACHE_HASH], wace_hash_link)
+    if (e2->wace_hash == hash && e2->wace_rule == rule &&
+        strcmp(e2->wace_key, key) == 0) {
+      webui_api_cache_unlink(e2);
+      break;
+    }
+  while ((e2 = TAILQ_FIRST(&webui_api_cache_lru)) != NULL &&
+         (webui_api_cache_count >= WEBUI_API_CACHE_ENTRIES ||
+          webui_api_cache_bytes + e->wace_size + e->wace_size_gz > WEBUI_API_CACHE_SIZE))
+    webui_api_cache_unlink(e2);
+  LIST_INSERT_HEAD(&webui_api_cache_hash[hash % WEBUI_API_CACHE_HASH], e, wace_hash_link);
+  TAILQ_INSERT_TAIL(&webui_api_cache_lru, e, wace_lru_link);
+  e->wace_linked = 1;
+  e->wace_refcnt++;
+  webui_api_cache_count++;
+  webui_api_cache_bytes += e->wace_size + e->wace_size_gz;
+  tvh_mutex_unlock(&webui_api_cache_mutex);
+  return e;
+}
+
+static void
+webui_api_cache_send ( http_connection_t *hc, webui_api_cache_entry_t *e )
+{
+  http_output_content_etag(hc, "text/x-json; charset=UTF-8",
+                           e->wace_data, e->wace_size,
+                           e->wace_data_gz, e->wace_size_gz,
+                           e->wace_etag);
+  tvh_mutex_lock(&webui_api_cache_mutex);
+  webui_api_cache_release(e);
+  tvh_mutex_unlock(&webui_api_cache_mutex);
+}
+
+/*
+ * Streamed replies, the large grids are sent while they are generated
+ */
+
+#define WEBUI_API_STREAM_SIZE    (64*1024)
+
+typedef struct webui_api_stream {
+  http_connection_t *was_hc;
+  http_stream_t      was_hs;
+  int                was_started;
+  int                was_tee;
+  htsbuf_queue_t     was_tee_q;   /* copy for the response cache */
+} webui_api_stream_t;
+
+static void
+webui_api_stream_flush ( void *opaque, htsbuf_queue_t *hq )
+{
+  webui_api_stream_t *st = opaque;
+  htsbuf_data_t *hd;
+
+  if (!st->was_started) {
+    http_stream_begin(st->was_hc, &st->was_hs, "text/x-json; charset=UTF-8");
+    st->was_started = 1;
+  }
+  if (st->was_tee) {
+    if (st->was_tee_q.hq_size + hq->hq_size > WEBUI_API_CACHE_SIZE / 8) {
+      htsbuf_queue_flush(&st->was_tee_q);
+      st->was_tee = 0;
+    } else {
+      TAILQ_FOREACH(hd, &hq->hq_q, hd_link)
+        htsbuf_append(&st->was_tee_q, hd->hd_data + hd->hd_data_off,
+                      hd->hd_data_len - hd->hd_data_off);
+    }
+  }
+  http_stream_write(&st->was_hs, hq);
+}
+
+static void
+webui_api_cache_done ( void )
+{
+  webui_api_cache_entry_t *e;
+
+  tvh_mutex_lock(&webui_api_cache_mutex);
+  while ((e = TAILQ_FIRST(&webui_api_cache_lru)) != NULL)
+    webui_api_cache_unlink(e);
+  tvh_mutex_unlock(&webui_api_cache_mutex);
+}
+
+/*
+ *
+ */
 
 static int
 webui_api_handler
   ( http_connection_t *hc, const char *remain, void *opaque )
 {
-  int r;
+  int r, rule, gen = 0;
+  uint32_t hash = 0;
+  char *key = NULL;
   http_arg_t *ha;
   htsmsg_t *args, *resp = NULL;
+  webui_api_cache_entry_t *e;
+  htsmsg_json_writer_t w;
+  webui_api_stream_t st;
+
+  /* Cached response */
+  rule = webui_api_cache_rule_find(remain);
+  if (rule >= 0 && (key = webui_api_cache_key(hc, remain)) != NULL) {
+    hash = tvh_crc32((uint8_t *)key, strlen(key), 0);
+    if ((e = webui_api_cache_find(rule, key, hash)) != NULL) {
+      free(key);
+      webui_api_cache_send(hc, e);
+      return 0;
+    }
+    /* a change during the call makes the new entry stale */
+    gen = atomic_get(&webui_api_cache_gen[rule]);
+  }
+
+  /* Streamed output */
+  memset(&st, 0, sizeof(st));
+  st.was_hc = hc;
+  st.was_tee = key != NULL;
+  htsbuf_queue_init(&st.was_tee_q, 0);
+  htsmsg_json_writer_init(&w, &hc->hc_reply, WEBUI_API_STREAM_SIZE,
+                          webui_api_stream_flush, &st);
 
   /* Build arguments */
   args = htsmsg_create_map();
@@ -44,7 +374,7 @@ webui_api_handler
   }
       
   /* Call */
-  r = api_exec(hc->hc_access, remain, args, &resp);
+  r = api_exec_stream(hc->hc_access, remain, args, &resp, &w);
 
 destroy_args:
   htsmsg_destroy(args);
@@ -71,19 +401,58 @@ destroy_args:
   }
 
   /* Output response */
-  if (!r && !resp)
+  if (st.was_started) {
+    htsmsg_destroy(resp);
+    htsmsg_json_writer_flush(&w);
+    http_stream_end(&st.was_hs);
+    if (st.was_tee && !r) {
+      e = webui_api_cache_store(&st.was_tee_q, rule, gen, key, hash);
+      key = NULL;
+      tvh_mutex_lock(&webui_api_cache_mutex);
+      webui_api_cache_release(e);
+      tvh_mutex_unlock(&webui_api_cache_mutex);
+    }
+    htsbuf_queue_flush(&st.was_tee_q);
+    free(key);
+    return 0;
+  }
+  if (!r && !resp && htsbuf_empty(&hc->hc_reply))
     resp = htsmsg_create_map();
   if (resp) {
     htsmsg_json_serialize(resp, &hc->hc_reply, 0);
-    http_output_content(hc, "text/x-json; charset=UTF-8");
     htsmsg_destroy(resp);
   }
-  
+  if (!htsbuf_empty(&hc->hc_reply)) {
+    if (key && !r) {
+      e = webui_api_cache_store(&hc->hc_reply, rule, gen, key, hash);
+      key = NULL;
+      webui_api_cache_send(hc, e);
+    } else {
+      http_output_content(hc, "text/x-json; charset=UTF-8");
+    }
+  }
+
+  free(key);
   return r;
 }
 
 void
 webui_api_init ( void )
 {
+  int i;
+
+  for (i = 0; i < WEBUI_API_CACHE_HASH; i++)
+    LIST_INIT(&webui_api_cache_hash[i]);
+  TAILQ_INIT(&webui_api_cache_lru);
+  memoryinfo_register(&webui_api_cache_memoryinfo);
   http_path_add("/api", NULL, webui_api_handler, ACCESS_WEB_INTERFACE);
 }
+
+void
+webui_api_done ( void )
+{
+  webui_api_cache_done();
+  tvh_mutex_lock(&global_lock);
+  memoryinfo_unregister(&webui_api_cache_memoryinfo);
+  tvh_mutex_unlock(&global_lock);
+}
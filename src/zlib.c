@@ -17,6 +17,7 @@
  */
 
 #include "tvheadend.h"
+#include "htsbuf.h"
 
 #define ZLIB_CONST 1
 #include <zlib.h>
@@ -182,3 +183,57 @@ int tvh_gzip_deflate_fd_header ( int fd, const uint8_t *data, size_t orig,
   data2[5] = (orig & 0xff);
   return tvh_write(fd, data2, 6);
 }
+
+/* **************************************************************************
+ * Incremental compression
+ * *************************************************************************/
+
+struct tvh_gzip_stream {
+  z_stream zstr;
+};
+
+tvh_gzip_stream_t *tvh_gzip_stream_create ( int speed )
+{
+  tvh_gzip_stream_t *gz = calloc(1, sizeof(*gz));
+
+  assert(speed >= Z_BEST_SPEED && speed <= Z_BEST_COMPRESSION);
+  if (deflateInit2(&gz->zstr, speed, Z_DEFLATED, MAX_WBITS + 16 /* gzip */,
+                   MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+    free(gz);
+    return NULL;
+  }
+  return gz;
+}
+
+/*
+ * Compress the data and append the output to out, flush 1 flushes
+ * the output to a byte boundary (the receiver can decode everything
+ * sent so far), flush 2 terminates the stream
+ */
+int tvh_gzip_stream_write ( tvh_gzip_stream_t *gz, const uint8_t *data,
+                            size_t len, int flush, htsbuf_queue_t *out )
+{
+  static const int modes[] = { Z_NO_FLUSH, Z_SYNC_FLUSH, Z_FINISH };
+  uint8_t buf[16384];
+  int err, finish = flush == 2;
+
+  gz->zstr.avail_in = len;
+  gz->zstr.next_in  = (z_const uint8_t *)data;
+  do {
+    gz->zstr.avail_out = sizeof(buf);
+    gz->zstr.next_out  = buf;
+    err = deflate(&gz->zstr, modes[flush]);
+    if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR)
+      return -1;
+    htsbuf_append(out, buf, sizeof(buf) - gz->zstr.avail_out);
+  } while (gz->zstr.avail_out == 0 || (finish && err != Z_STREAM_END));
+  return 0;
+}
+
+void tvh_gzip_stream_destroy ( tvh_gzip_stream_t *gz )
+{
+  if (gz == NULL)
+    return;
+  deflateEnd(&gz->zstr);
+  free(gz);
+}
@@ -0,0 +1,149 @@
+/*
+ *  tvheadend - start code scanner test
+ *  Copyright (C) 2026 Tvheadend Foundation CIC
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares bs_scan_startcode() with the byte-by-byte loop used by
+ * parse_pes() before, on random and zero-padded buffers split into
+ * random blocks (the start code state is carried between the blocks).
+ *
+ *   make check_startcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include "bitstream.h"
+
+#define BUF_MAX 4096
+#define FOUND_MAX (BUF_MAX + 1)
+
+typedef struct {
+  int count;
+  int pos[FOUND_MAX];
+  uint_fast32_t sc[FOUND_MAX];
+  uint32_t state;
+} result_t;
+
+static void
+scan_ref(const uint8_t *data, int len, uint32_t *state, result_t *res, int base)
+{
+  uint_fast32_t sc = *state;
+  int i = 0;
+
+  while (i < len) {
+    do {
+      sc = (sc << 8) | data[i++];
+      if ((sc & 0xffffff00) == 0x00000100)
+        goto found;
+    } while (i < len);
+    break;
+found:
+    res->pos[res->count] = base + i;
+    res->sc[res->count++] = sc;
+  }
+  *state = sc;
+}
+
+static void
+scan_new(const uint8_t *data, int len, uint32_t *state, result_t *res, int base)
+{
+  uint_fast32_t sc = *state;
+  int i = 0;
+
+  while (i < len) {
+    i = bs_scan_startcode(data, i, len, &sc);
+    if (i < 0)
+      break;
+    res->pos[res->count] = base + i;
+    res->sc[res->count++] = sc;
+  }
+  *state = sc;
+}
+
+static void
+run(const uint8_t *buf, int len, const int *blocks, int nblocks,
+    result_t *res, int ref)
+{
+  int b, off = 0;
+
+  memset(res, 0, sizeof(*res));
+  res->state = 0xffffffff;
+  for (b = 0; b < nblocks; b++) {
+    if (ref)
+      scan_ref(buf + off, blocks[b], &res->state, res, off);
+    else
+      scan_new(buf + off, blocks[b], &res->state, res, off);
+    off += blocks[b];
+  }
+}
+
+static void
+fill(uint8_t *buf, int len, int mode)
+{
+  int i;
+
+  for (i = 0; i < len; i++) {
+    switch (mode) {
+    case 0: /* random */
+      buf[i] = rand();
+      break;
+    case 1: /* mostly 00 and 01 */
+      buf[i] = (rand() % 4) ? rand() % 2 : rand();
+      break;
+    default: /* zero-padded with a few start codes */
+      buf[i] = 0;
+      if (rand() % 64 == 0)
+        buf[i] = rand() % 8 ? 1 : rand();
+      break;
+    }
+  }
+}
+
+int
+main(int argc, char **argv)
+{
+  static uint8_t buf[BUF_MAX];
+  static result_t a, b;
+  int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+  int blocks[BUF_MAX];
+  int n, len, nblocks, rem, failed = 0;
+
+  srand(1);
+  for (n = 0; n < iterations; n++) {
+    len = 1 + rand() % (n % 2 ? 64 : BUF_MAX);
+    fill(buf, len, n % 3);
+    for (nblocks = 0, rem = len; rem > 0; nblocks++) {
+      blocks[nblocks] = n % 5 == 0 ? rem : 1 + rand() % (n % 4 ? 184 : 16);
+      if (blocks[nblocks] > rem)
+        blocks[nblocks] = rem;
+      rem -= blocks[nblocks];
+    }
+    run(buf, len, blocks, nblocks, &a, 1);
+    run(buf, len, blocks, nblocks, &b, 0);
+    if (a.count != b.count || a.state != b.state ||
+        memcmp(a.pos, b.pos, a.count * sizeof(a.pos[0])) ||
+        memcmp(a.sc, b.sc, a.count * sizeof(a.sc[0]))) {
+      if (failed++ < 10)
+        fprintf(stderr, "mismatch: iteration %d len %d blocks %d "
+                        "found %d/%d\n", n, len, nblocks, a.count, b.count);
+    }
+  }
+  printf("%d/%d mismatches\n", failed, iterations);
+  return failed ? 1 : 0;
+}